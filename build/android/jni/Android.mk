@@ -34,12 +34,12 @@ LOCAL_MODULE     := foundation
 include $(FOUNDATION_LOCAL_PATH)/TargetSetup.mk
 
 LOCAL_SRC_FILES  := \
-	foundation/android.c foundation/array.c foundation/assert.c foundation/assetstream.c foundation/base64.c foundation/blowfish.c \
-	foundation/bufferstream.c foundation/config.c foundation/crash.c foundation/environment.c foundation/error.c foundation/event.c \
-	foundation/foundation.c foundation/fs.c foundation/hash.c foundation/hashmap.c foundation/hashtable.c foundation/library.c \
-	foundation/log.c foundation/main.c foundation/md5.c foundation/memory.c foundation/mutex.c foundation/objectmap.c \
+	foundation/android.c foundation/array.c foundation/assert.c foundation/assetstream.c foundation/base64.c foundation/blowfish.c foundation/bucketarray.c \
+	foundation/bufferstream.c foundation/config.c foundation/crash.c foundation/environment.c foundation/error.c foundation/event.c foundation/flatmap.c \
+	foundation/foundation.c foundation/fs.c foundation/groupmap.c foundation/hash.c foundation/hashmap.c foundation/hashtable.c foundation/library.c \
+	foundation/log.c foundation/main.c foundation/md5.c foundation/memory.c foundation/mempool.c foundation/mutex.c foundation/objectmap.c \
 	foundation/path.c foundation/pipe.c foundation/process.c foundation/profile.c foundation/radixsort.c foundation/random.c \
-	foundation/ringbuffer.c foundation/semaphore.c foundation/stacktrace.c foundation/stream.c foundation/string.c \
+	foundation/ringbuffer.c foundation/semaphore.c foundation/shardmap.c foundation/stacktrace.c foundation/stream.c foundation/string.c \
 	foundation/system.c foundation/thread.c foundation/time.c foundation/uuid.c
 
 LOCAL_STATIC_LIBRARIES := android_native_app_glue cpufeatures
@@ -153,6 +153,10 @@ include $(CLEAR_VARS)
 FOUNDATION_TEST_MODULE := md5
 include $(FOUNDATION_LOCAL_PATH)/TestModule.mk
 
+include $(CLEAR_VARS)
+FOUNDATION_TEST_MODULE := memory
+include $(FOUNDATION_LOCAL_PATH)/TestModule.mk
+
 include $(CLEAR_VARS)
 FOUNDATION_TEST_MODULE := mutex
 include $(FOUNDATION_LOCAL_PATH)/TestModule.mk
@@ -220,7 +224,7 @@ endif
 endif
 endif
 
-LOCAL_STATIC_LIBRARIES += test-app test-atomic test-array test-base64 test-blowfish test-bufferstream test-config test-crash test-environment test-error test-event test-fs test-hash test-hashmap test-hashtable test-library test-math test-md5 test-mutex test-objectmap test-path test-radixsort test-random test-ringbuffer test-semaphore test-stacktrace test-string test-uuid test foundation android_native_app_glue cpufeatures
+LOCAL_STATIC_LIBRARIES += test-app test-atomic test-array test-base64 test-blowfish test-bufferstream test-config test-crash test-environment test-error test-event test-fs test-hash test-hashmap test-hashtable test-library test-math test-md5 test-memory test-mutex test-objectmap test-path test-radixsort test-random test-ringbuffer test-semaphore test-stacktrace test-string test-uuid test foundation android_native_app_glue cpufeatures
 
 LOCAL_LDLIBS     += -llog -landroid -lEGL -lGLESv1_CM -lGLESv2 -lOpenSLES
 
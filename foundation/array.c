@@ -12,6 +12,13 @@
 
 #include <foundation/foundation.h>
 
+#if FOUNDATION_ARCH_SSE2
+#  include <emmintrin.h>
+#endif
+#if FOUNDATION_ARCH_AVX2
+#  include <immintrin.h>
+#endif
+
 
 //'FARR' in ascii
 #define _array_watermark 0x52524145
@@ -22,26 +29,1029 @@ void _array_verifyfn( const void* const* arr )
 }
 
 
-void _array_growfn( void* arr, int increment, int factor, int itemsize )
+//Page granular growth rounds storage up to this size
+#define _array_page_size 4096ULL
+
+#if BUILD_ENABLE_ARRAY_64BIT
+#  define _array_max_capacity 0x7FFFFFFFFFFFFFFFLL
+#else
+#  define _array_max_capacity 0x7FFFFFFFLL
+#endif
+
+
+static int64_t _array_growth_capacity( int growth, int64_t prev_capacity, int64_t increment, int itemsize )
 {
-	void**   parr = (void**)arr;
-	int      prev_capacity = *parr ? _array_rawcapacity(*parr) : 0;
-	int      capacity = *parr ? ( factor * prev_capacity + increment ) : increment;
-	int      prev_used_size = itemsize * prev_capacity;
-	int      storage_size = itemsize * capacity;
-	uint64_t header_size = 4ULL * _array_header_size;
-	uint64_t prev_used_buffer_size = (unsigned int)prev_used_size + header_size;
-	uint64_t buffer_size = (unsigned int)storage_size + header_size;
-	int*     buffer = *parr ? memory_reallocate( _array_raw( *parr ), buffer_size, 16, prev_used_buffer_size ) : memory_allocate( buffer_size, 16, MEMORY_PERSISTENT );
-	FOUNDATION_ASSERT_MSG( buffer, "Failed to reallocate array storage" );
-	if( buffer )
+	uint64_t header_size = sizeof( _array_header_t ) * _array_header_size;
+	uint64_t buffer_size;
+	switch( growth )
+	{
+		case ARRAY_GROWTH_HALF:
+			return prev_capacity + ( prev_capacity >> 1 ) + increment;
+
+		case ARRAY_GROWTH_PAGE:
+			//Grow by an eighth, rounding the block up to whole pages. Large blocks are mapped and
+			//reallocated by remapping pages, so smaller steps do not cause extra copying
+			buffer_size = header_size + (uint64_t)itemsize * (uint64_t)( prev_capacity + ( prev_capacity >> 3 ) + increment );
+			buffer_size = ( buffer_size + _array_page_size - 1 ) & ~( _array_page_size - 1 );
+			return (int64_t)( ( buffer_size - header_size ) / (uint64_t)itemsize );
+
+		case ARRAY_GROWTH_DOUBLE:
+		default:
+			return 2 * prev_capacity + increment;
+	}
+}
+
+
+void _array_growfn( void* arr, int64_t increment, int factor, int itemsize )
+{
+	void**           parr = (void**)arr;
+	int64_t          prev_capacity = *parr ? _array_rawcapacity(*parr) : 0;
+	int64_t          capacity = *parr ? prev_capacity + increment : increment;
+	uint64_t         header_size = sizeof( _array_header_t ) * _array_header_size;
+	_array_header_t* buffer;
+
+	FOUNDATION_ASSERT_MSG( capacity <= _array_max_capacity, "Array capacity overflow" );
+	if( *parr && ( factor > 1 ) )
+	{
+		int64_t grow_capacity = _array_growth_capacity( (int)( _array_rawflags(*parr) & _array_growth_mask ), prev_capacity, increment, itemsize );
+		if( grow_capacity > _array_max_capacity )
+			grow_capacity = _array_max_capacity;
+		if( grow_capacity > capacity )
+			capacity = grow_capacity;
+	}
+
+	if( *parr && _array_isinline(*parr) )
+	{
+		//Spill inline storage to heap, header and stored elements are copied and the inline marker cleared
+		buffer = memory_allocate( header_size + (uint64_t)itemsize * (uint64_t)capacity, 16, MEMORY_PERSISTENT );
+		if( buffer )
+		{
+			memcpy( buffer, _array_raw( *parr ), (size_t)( header_size + (uint64_t)itemsize * (uint64_t)_array_rawsize(*parr) ) );
+			buffer[3] &= ~_array_flag_inline;
+		}
+	}
+	else if( *parr )
 	{
-		buffer[0] = capacity;
-		if( !*parr )
+		buffer = memory_reallocate( _array_raw( *parr ), header_size + (uint64_t)itemsize * (uint64_t)capacity, 16, header_size + (uint64_t)itemsize * (uint64_t)prev_capacity );
+	}
+	else
+	{
+		buffer = memory_allocate( header_size + (uint64_t)itemsize * (uint64_t)capacity, 16, MEMORY_PERSISTENT );
+		if( buffer )
 		{
 			buffer[1] = 0;
 			buffer[2] = _array_watermark;
+			buffer[3] = ARRAY_GROWTH_DOUBLE;
 		}
+	}
+	FOUNDATION_ASSERT_MSG( buffer, "Failed to reallocate array storage" );
+	if( buffer )
+	{
+		buffer[0] = (_array_header_t)capacity;
+		*parr = buffer + _array_header_size;
+	}
+}
+
+
+void _array_shrinkfn( void* arr, int itemsize )
+{
+	void**           parr = (void**)arr;
+	int64_t          capacity = _array_rawcapacity(*parr);
+	int64_t          size = _array_rawsize(*parr);
+	uint64_t         header_size = sizeof( _array_header_t ) * _array_header_size;
+	_array_header_t* buffer = memory_reallocate( _array_raw( *parr ), header_size + (uint64_t)itemsize * (uint64_t)size, 16, header_size + (uint64_t)itemsize * (uint64_t)capacity );
+	FOUNDATION_ASSERT_MSG( buffer, "Failed to reallocate array storage" );
+	if( buffer )
+	{
+		buffer[0] = (_array_header_t)size;
 		*parr = buffer + _array_header_size;
 	}
 }
+
+
+void _array_inlinefn( _array_header_t* header, int64_t capacity )
+{
+	header[0] = (_array_header_t)capacity;
+	header[1] = 0;
+	header[2] = _array_watermark;
+	header[3] = ARRAY_GROWTH_DOUBLE | _array_flag_inline;
+}
+
+
+static FORCEINLINE unsigned int _array_mask_first( unsigned int mask )
+{
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+	return (unsigned int)__builtin_ctz( mask );
+#else
+	unsigned int bit = 0;
+	for( ; !( mask & 1 ); mask >>= 1 )
+		++bit;
+	return bit;
+#endif
+}
+
+
+static FORCEINLINE unsigned int _array_mask_count( unsigned int mask )
+{
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+	return (unsigned int)__builtin_popcount( mask );
+#else
+	unsigned int bits = 0;
+	for( ; mask; mask &= mask - 1 )
+		++bits;
+	return bits;
+#endif
+}
+
+
+int array_find_int32( const int32_t* array, unsigned int count, int32_t value )
+{
+	unsigned int i = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256i value8 = _mm256_set1_epi32( value );
+	for( ; i + 8 <= count; i += 8 )
+	{
+		unsigned int mask = (unsigned int)_mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( _mm256_loadu_si256( (const __m256i*)( array + i ) ), value8 ) ) );
+		if( mask )
+			return (int)( i + _array_mask_first( mask ) );
+	}
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128i value4 = _mm_set1_epi32( value );
+		for( ; i + 4 <= count; i += 4 )
+		{
+			unsigned int mask = (unsigned int)_mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_loadu_si128( (const __m128i*)( array + i ) ), value4 ) ) );
+			if( mask )
+				return (int)( i + _array_mask_first( mask ) );
+		}
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		if( array[i] == value )
+			return (int)i;
+	}
+	return -1;
+}
+
+
+#if FOUNDATION_ARCH_SSE2
+//SSE2 has no 64-bit compare, combine the two 32-bit halves
+static FORCEINLINE __m128i _array_cmpeq_epi64( __m128i a, __m128i b )
+{
+	__m128i eq = _mm_cmpeq_epi32( a, b );
+	return _mm_and_si128( eq, _mm_shuffle_epi32( eq, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+}
+#endif
+
+
+int array_find_int64( const int64_t* array, unsigned int count, int64_t value )
+{
+	unsigned int i = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256i value4 = _mm256_set1_epi64x( value );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		unsigned int mask = (unsigned int)_mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpeq_epi64( _mm256_loadu_si256( (const __m256i*)( array + i ) ), value4 ) ) );
+		if( mask )
+			return (int)( i + _array_mask_first( mask ) );
+	}
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128i value2 = _mm_set1_epi64x( value );
+		for( ; i + 2 <= count; i += 2 )
+		{
+			unsigned int mask = (unsigned int)_mm_movemask_pd( _mm_castsi128_pd( _array_cmpeq_epi64( _mm_loadu_si128( (const __m128i*)( array + i ) ), value2 ) ) );
+			if( mask )
+				return (int)( i + _array_mask_first( mask ) );
+		}
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		if( array[i] == value )
+			return (int)i;
+	}
+	return -1;
+}
+
+
+int array_find_float32( const float32_t* array, unsigned int count, float32_t value )
+{
+	unsigned int i = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256 value8 = _mm256_set1_ps( value );
+	for( ; i + 8 <= count; i += 8 )
+	{
+		unsigned int mask = (unsigned int)_mm256_movemask_ps( _mm256_cmp_ps( _mm256_loadu_ps( array + i ), value8, _CMP_EQ_OQ ) );
+		if( mask )
+			return (int)( i + _array_mask_first( mask ) );
+	}
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128 value4 = _mm_set1_ps( value );
+		for( ; i + 4 <= count; i += 4 )
+		{
+			unsigned int mask = (unsigned int)_mm_movemask_ps( _mm_cmpeq_ps( _mm_loadu_ps( array + i ), value4 ) );
+			if( mask )
+				return (int)( i + _array_mask_first( mask ) );
+		}
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		if( array[i] == value )
+			return (int)i;
+	}
+	return -1;
+}
+
+
+int array_find_float64( const float64_t* array, unsigned int count, float64_t value )
+{
+	unsigned int i = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256d value4 = _mm256_set1_pd( value );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		unsigned int mask = (unsigned int)_mm256_movemask_pd( _mm256_cmp_pd( _mm256_loadu_pd( array + i ), value4, _CMP_EQ_OQ ) );
+		if( mask )
+			return (int)( i + _array_mask_first( mask ) );
+	}
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128d value2 = _mm_set1_pd( value );
+		for( ; i + 2 <= count; i += 2 )
+		{
+			unsigned int mask = (unsigned int)_mm_movemask_pd( _mm_cmpeq_pd( _mm_loadu_pd( array + i ), value2 ) );
+			if( mask )
+				return (int)( i + _array_mask_first( mask ) );
+		}
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		if( array[i] == value )
+			return (int)i;
+	}
+	return -1;
+}
+
+
+unsigned int array_count_int32( const int32_t* array, unsigned int count, int32_t value )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256i value8 = _mm256_set1_epi32( value );
+	for( ; i + 8 <= count; i += 8 )
+		num += _array_mask_count( (unsigned int)_mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( _mm256_loadu_si256( (const __m256i*)( array + i ) ), value8 ) ) ) );
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128i value4 = _mm_set1_epi32( value );
+		for( ; i + 4 <= count; i += 4 )
+			num += _array_mask_count( (unsigned int)_mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_loadu_si128( (const __m128i*)( array + i ) ), value4 ) ) ) );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( array[i] == value ) ? 1 : 0;
+	return num;
+}
+
+
+unsigned int array_count_int64( const int64_t* array, unsigned int count, int64_t value )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256i value4 = _mm256_set1_epi64x( value );
+	for( ; i + 4 <= count; i += 4 )
+		num += _array_mask_count( (unsigned int)_mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpeq_epi64( _mm256_loadu_si256( (const __m256i*)( array + i ) ), value4 ) ) ) );
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128i value2 = _mm_set1_epi64x( value );
+		for( ; i + 2 <= count; i += 2 )
+			num += _array_mask_count( (unsigned int)_mm_movemask_pd( _mm_castsi128_pd( _array_cmpeq_epi64( _mm_loadu_si128( (const __m128i*)( array + i ) ), value2 ) ) ) );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( array[i] == value ) ? 1 : 0;
+	return num;
+}
+
+
+unsigned int array_count_float32( const float32_t* array, unsigned int count, float32_t value )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256 value8 = _mm256_set1_ps( value );
+	for( ; i + 8 <= count; i += 8 )
+		num += _array_mask_count( (unsigned int)_mm256_movemask_ps( _mm256_cmp_ps( _mm256_loadu_ps( array + i ), value8, _CMP_EQ_OQ ) ) );
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128 value4 = _mm_set1_ps( value );
+		for( ; i + 4 <= count; i += 4 )
+			num += _array_mask_count( (unsigned int)_mm_movemask_ps( _mm_cmpeq_ps( _mm_loadu_ps( array + i ), value4 ) ) );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( array[i] == value ) ? 1 : 0;
+	return num;
+}
+
+
+unsigned int array_count_float64( const float64_t* array, unsigned int count, float64_t value )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256d value4 = _mm256_set1_pd( value );
+	for( ; i + 4 <= count; i += 4 )
+		num += _array_mask_count( (unsigned int)_mm256_movemask_pd( _mm256_cmp_pd( _mm256_loadu_pd( array + i ), value4, _CMP_EQ_OQ ) ) );
+#endif
+#if FOUNDATION_ARCH_SSE2
+	{
+		__m128d value2 = _mm_set1_pd( value );
+		for( ; i + 2 <= count; i += 2 )
+			num += _array_mask_count( (unsigned int)_mm_movemask_pd( _mm_cmpeq_pd( _mm_loadu_pd( array + i ), value2 ) ) );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( array[i] == value ) ? 1 : 0;
+	return num;
+}
+
+
+//Min and max are computed together, the scan is bound by memory bandwidth rather than compares
+static void _array_minmax_int32( const int32_t* array, unsigned int count, int32_t* minval, int32_t* maxval )
+{
+	unsigned int i = 0, lane;
+	int32_t lmin, lmax;
+	if( !count )
+	{
+		*minval = *maxval = 0;
+		return;
+	}
+	lmin = lmax = array[0];
+#if FOUNDATION_ARCH_AVX2
+	if( count >= 8 )
+	{
+		int32_t store[8];
+		__m256i vmin = _mm256_loadu_si256( (const __m256i*)array );
+		__m256i vmax = vmin;
+		for( i = 8; i + 8 <= count; i += 8 )
+		{
+			__m256i v = _mm256_loadu_si256( (const __m256i*)( array + i ) );
+			vmin = _mm256_min_epi32( vmin, v );
+			vmax = _mm256_max_epi32( vmax, v );
+		}
+		_mm256_storeu_si256( (__m256i*)store, vmin );
+		for( lane = 0; lane < 8; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm256_storeu_si256( (__m256i*)store, vmax );
+		for( lane = 0; lane < 8; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#elif FOUNDATION_ARCH_SSE2
+	if( count >= 4 )
+	{
+		int32_t store[4];
+		__m128i vmin = _mm_loadu_si128( (const __m128i*)array );
+		__m128i vmax = vmin;
+		for( i = 4; i + 4 <= count; i += 4 )
+		{
+			__m128i v = _mm_loadu_si128( (const __m128i*)( array + i ) );
+			__m128i less = _mm_cmplt_epi32( v, vmin );
+			__m128i greater = _mm_cmpgt_epi32( v, vmax );
+			vmin = _mm_or_si128( _mm_and_si128( less, v ), _mm_andnot_si128( less, vmin ) );
+			vmax = _mm_or_si128( _mm_and_si128( greater, v ), _mm_andnot_si128( greater, vmax ) );
+		}
+		_mm_storeu_si128( (__m128i*)store, vmin );
+		for( lane = 0; lane < 4; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm_storeu_si128( (__m128i*)store, vmax );
+		for( lane = 0; lane < 4; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		lmin = ( array[i] < lmin ) ? array[i] : lmin;
+		lmax = ( array[i] > lmax ) ? array[i] : lmax;
+	}
+	*minval = lmin;
+	*maxval = lmax;
+}
+
+
+static void _array_minmax_uint32( const uint32_t* array, unsigned int count, uint32_t* minval, uint32_t* maxval )
+{
+	unsigned int i = 0, lane;
+	uint32_t lmin, lmax;
+	if( !count )
+	{
+		*minval = *maxval = 0;
+		return;
+	}
+	lmin = lmax = array[0];
+#if FOUNDATION_ARCH_AVX2
+	if( count >= 8 )
+	{
+		uint32_t store[8];
+		__m256i vmin = _mm256_loadu_si256( (const __m256i*)array );
+		__m256i vmax = vmin;
+		for( i = 8; i + 8 <= count; i += 8 )
+		{
+			__m256i v = _mm256_loadu_si256( (const __m256i*)( array + i ) );
+			vmin = _mm256_min_epu32( vmin, v );
+			vmax = _mm256_max_epu32( vmax, v );
+		}
+		_mm256_storeu_si256( (__m256i*)store, vmin );
+		for( lane = 0; lane < 8; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm256_storeu_si256( (__m256i*)store, vmax );
+		for( lane = 0; lane < 8; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#elif FOUNDATION_ARCH_SSE2
+	if( count >= 4 )
+	{
+		//Flip sign bit to use signed compares, flipped back when storing lanes
+		uint32_t store[4];
+		__m128i bias = _mm_set1_epi32( (int)0x80000000 );
+		__m128i vmin = _mm_xor_si128( _mm_loadu_si128( (const __m128i*)array ), bias );
+		__m128i vmax = vmin;
+		for( i = 4; i + 4 <= count; i += 4 )
+		{
+			__m128i v = _mm_xor_si128( _mm_loadu_si128( (const __m128i*)( array + i ) ), bias );
+			__m128i less = _mm_cmplt_epi32( v, vmin );
+			__m128i greater = _mm_cmpgt_epi32( v, vmax );
+			vmin = _mm_or_si128( _mm_and_si128( less, v ), _mm_andnot_si128( less, vmin ) );
+			vmax = _mm_or_si128( _mm_and_si128( greater, v ), _mm_andnot_si128( greater, vmax ) );
+		}
+		_mm_storeu_si128( (__m128i*)store, _mm_xor_si128( vmin, bias ) );
+		for( lane = 0; lane < 4; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm_storeu_si128( (__m128i*)store, _mm_xor_si128( vmax, bias ) );
+		for( lane = 0; lane < 4; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		lmin = ( array[i] < lmin ) ? array[i] : lmin;
+		lmax = ( array[i] > lmax ) ? array[i] : lmax;
+	}
+	*minval = lmin;
+	*maxval = lmax;
+}
+
+
+//64-bit integer compares need AVX2, SSE2 builds use the scalar loop. Unsigned values are compared
+//as signed with the sign bit flipped
+static void _array_minmax_int64( const int64_t* array, unsigned int count, bool is_unsigned, int64_t* minval, int64_t* maxval )
+{
+	unsigned int i = 0, lane;
+	int64_t bias = is_unsigned ? (int64_t)0x8000000000000000ULL : 0;
+	int64_t lmin, lmax;
+	if( !count )
+	{
+		*minval = *maxval = 0;
+		return;
+	}
+	lmin = lmax = array[0] ^ bias;
+#if FOUNDATION_ARCH_AVX2
+	if( count >= 4 )
+	{
+		int64_t store[4];
+		__m256i vbias = _mm256_set1_epi64x( bias );
+		__m256i vmin = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i*)array ), vbias );
+		__m256i vmax = vmin;
+		for( i = 4; i + 4 <= count; i += 4 )
+		{
+			__m256i v = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i*)( array + i ) ), vbias );
+			vmin = _mm256_blendv_epi8( vmin, v, _mm256_cmpgt_epi64( vmin, v ) );
+			vmax = _mm256_blendv_epi8( vmax, v, _mm256_cmpgt_epi64( v, vmax ) );
+		}
+		_mm256_storeu_si256( (__m256i*)store, vmin );
+		for( lane = 0; lane < 4; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm256_storeu_si256( (__m256i*)store, vmax );
+		for( lane = 0; lane < 4; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		int64_t value = array[i] ^ bias;
+		lmin = ( value < lmin ) ? value : lmin;
+		lmax = ( value > lmax ) ? value : lmax;
+	}
+	*minval = lmin ^ bias;
+	*maxval = lmax ^ bias;
+}
+
+
+static void _array_minmax_float32( const float32_t* array, unsigned int count, float32_t* minval, float32_t* maxval )
+{
+	unsigned int i = 0, lane;
+	float32_t lmin, lmax;
+	if( !count )
+	{
+		*minval = *maxval = 0;
+		return;
+	}
+	lmin = lmax = array[0];
+#if FOUNDATION_ARCH_AVX2
+	if( count >= 8 )
+	{
+		float32_t store[8];
+		__m256 vmin = _mm256_loadu_ps( array );
+		__m256 vmax = vmin;
+		for( i = 8; i + 8 <= count; i += 8 )
+		{
+			__m256 v = _mm256_loadu_ps( array + i );
+			vmin = _mm256_min_ps( vmin, v );
+			vmax = _mm256_max_ps( vmax, v );
+		}
+		_mm256_storeu_ps( store, vmin );
+		for( lane = 0; lane < 8; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm256_storeu_ps( store, vmax );
+		for( lane = 0; lane < 8; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#elif FOUNDATION_ARCH_SSE2
+	if( count >= 4 )
+	{
+		float32_t store[4];
+		__m128 vmin = _mm_loadu_ps( array );
+		__m128 vmax = vmin;
+		for( i = 4; i + 4 <= count; i += 4 )
+		{
+			__m128 v = _mm_loadu_ps( array + i );
+			vmin = _mm_min_ps( vmin, v );
+			vmax = _mm_max_ps( vmax, v );
+		}
+		_mm_storeu_ps( store, vmin );
+		for( lane = 0; lane < 4; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm_storeu_ps( store, vmax );
+		for( lane = 0; lane < 4; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		lmin = ( array[i] < lmin ) ? array[i] : lmin;
+		lmax = ( array[i] > lmax ) ? array[i] : lmax;
+	}
+	*minval = lmin;
+	*maxval = lmax;
+}
+
+
+static void _array_minmax_float64( const float64_t* array, unsigned int count, float64_t* minval, float64_t* maxval )
+{
+	unsigned int i = 0, lane;
+	float64_t lmin, lmax;
+	if( !count )
+	{
+		*minval = *maxval = 0;
+		return;
+	}
+	lmin = lmax = array[0];
+#if FOUNDATION_ARCH_AVX2
+	if( count >= 4 )
+	{
+		float64_t store[4];
+		__m256d vmin = _mm256_loadu_pd( array );
+		__m256d vmax = vmin;
+		for( i = 4; i + 4 <= count; i += 4 )
+		{
+			__m256d v = _mm256_loadu_pd( array + i );
+			vmin = _mm256_min_pd( vmin, v );
+			vmax = _mm256_max_pd( vmax, v );
+		}
+		_mm256_storeu_pd( store, vmin );
+		for( lane = 0; lane < 4; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm256_storeu_pd( store, vmax );
+		for( lane = 0; lane < 4; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#elif FOUNDATION_ARCH_SSE2
+	if( count >= 2 )
+	{
+		float64_t store[2];
+		__m128d vmin = _mm_loadu_pd( array );
+		__m128d vmax = vmin;
+		for( i = 2; i + 2 <= count; i += 2 )
+		{
+			__m128d v = _mm_loadu_pd( array + i );
+			vmin = _mm_min_pd( vmin, v );
+			vmax = _mm_max_pd( vmax, v );
+		}
+		_mm_storeu_pd( store, vmin );
+		for( lane = 0; lane < 2; ++lane )
+			lmin = ( store[lane] < lmin ) ? store[lane] : lmin;
+		_mm_storeu_pd( store, vmax );
+		for( lane = 0; lane < 2; ++lane )
+			lmax = ( store[lane] > lmax ) ? store[lane] : lmax;
+	}
+#endif
+	for( ; i < count; ++i )
+	{
+		lmin = ( array[i] < lmin ) ? array[i] : lmin;
+		lmax = ( array[i] > lmax ) ? array[i] : lmax;
+	}
+	*minval = lmin;
+	*maxval = lmax;
+}
+
+
+int32_t array_min_int32( const int32_t* array, unsigned int count )
+{
+	int32_t minval, maxval;
+	_array_minmax_int32( array, count, &minval, &maxval );
+	return minval;
+}
+
+
+int32_t array_max_int32( const int32_t* array, unsigned int count )
+{
+	int32_t minval, maxval;
+	_array_minmax_int32( array, count, &minval, &maxval );
+	return maxval;
+}
+
+
+uint32_t array_min_uint32( const uint32_t* array, unsigned int count )
+{
+	uint32_t minval, maxval;
+	_array_minmax_uint32( array, count, &minval, &maxval );
+	return minval;
+}
+
+
+uint32_t array_max_uint32( const uint32_t* array, unsigned int count )
+{
+	uint32_t minval, maxval;
+	_array_minmax_uint32( array, count, &minval, &maxval );
+	return maxval;
+}
+
+
+int64_t array_min_int64( const int64_t* array, unsigned int count )
+{
+	int64_t minval, maxval;
+	_array_minmax_int64( array, count, false, &minval, &maxval );
+	return minval;
+}
+
+
+int64_t array_max_int64( const int64_t* array, unsigned int count )
+{
+	int64_t minval, maxval;
+	_array_minmax_int64( array, count, false, &minval, &maxval );
+	return maxval;
+}
+
+
+uint64_t array_min_uint64( const uint64_t* array, unsigned int count )
+{
+	int64_t minval, maxval;
+	_array_minmax_int64( (const int64_t*)array, count, true, &minval, &maxval );
+	return (uint64_t)minval;
+}
+
+
+uint64_t array_max_uint64( const uint64_t* array, unsigned int count )
+{
+	int64_t minval, maxval;
+	_array_minmax_int64( (const int64_t*)array, count, true, &minval, &maxval );
+	return (uint64_t)maxval;
+}
+
+
+float32_t array_min_float32( const float32_t* array, unsigned int count )
+{
+	float32_t minval, maxval;
+	_array_minmax_float32( array, count, &minval, &maxval );
+	return minval;
+}
+
+
+float32_t array_max_float32( const float32_t* array, unsigned int count )
+{
+	float32_t minval, maxval;
+	_array_minmax_float32( array, count, &minval, &maxval );
+	return maxval;
+}
+
+
+float64_t array_min_float64( const float64_t* array, unsigned int count )
+{
+	float64_t minval, maxval;
+	_array_minmax_float64( array, count, &minval, &maxval );
+	return minval;
+}
+
+
+float64_t array_max_float64( const float64_t* array, unsigned int count )
+{
+	float64_t minval, maxval;
+	_array_minmax_float64( array, count, &minval, &maxval );
+	return maxval;
+}
+
+
+int64_t array_sum_int32( const int32_t* array, unsigned int count )
+{
+	unsigned int i = 0;
+	int64_t sum = 0;
+#if FOUNDATION_ARCH_AVX2
+	int64_t store[4];
+	__m256i acc = _mm256_setzero_si256();
+	for( ; i + 8 <= count; i += 8 )
+	{
+		acc = _mm256_add_epi64( acc, _mm256_cvtepi32_epi64( _mm_loadu_si128( (const __m128i*)( array + i ) ) ) );
+		acc = _mm256_add_epi64( acc, _mm256_cvtepi32_epi64( _mm_loadu_si128( (const __m128i*)( array + i + 4 ) ) ) );
+	}
+	_mm256_storeu_si256( (__m256i*)store, acc );
+	sum = store[0] + store[1] + store[2] + store[3];
+#elif FOUNDATION_ARCH_SSE2
+	int64_t store[2];
+	__m128i acc = _mm_setzero_si128();
+	for( ; i + 4 <= count; i += 4 )
+	{
+		//Sign extend to 64-bit lanes by interleaving with the sign mask
+		__m128i v = _mm_loadu_si128( (const __m128i*)( array + i ) );
+		__m128i sign = _mm_srai_epi32( v, 31 );
+		acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( v, sign ) );
+		acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( v, sign ) );
+	}
+	_mm_storeu_si128( (__m128i*)store, acc );
+	sum = store[0] + store[1];
+#endif
+	for( ; i < count; ++i )
+		sum += array[i];
+	return sum;
+}
+
+
+uint64_t array_sum_uint32( const uint32_t* array, unsigned int count )
+{
+	unsigned int i = 0;
+	uint64_t sum = 0;
+#if FOUNDATION_ARCH_AVX2
+	uint64_t store[4];
+	__m256i acc = _mm256_setzero_si256();
+	for( ; i + 8 <= count; i += 8 )
+	{
+		acc = _mm256_add_epi64( acc, _mm256_cvtepu32_epi64( _mm_loadu_si128( (const __m128i*)( array + i ) ) ) );
+		acc = _mm256_add_epi64( acc, _mm256_cvtepu32_epi64( _mm_loadu_si128( (const __m128i*)( array + i + 4 ) ) ) );
+	}
+	_mm256_storeu_si256( (__m256i*)store, acc );
+	sum = store[0] + store[1] + store[2] + store[3];
+#elif FOUNDATION_ARCH_SSE2
+	uint64_t store[2];
+	__m128i zero = _mm_setzero_si128();
+	__m128i acc = zero;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)( array + i ) );
+		acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( v, zero ) );
+		acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( v, zero ) );
+	}
+	_mm_storeu_si128( (__m128i*)store, acc );
+	sum = store[0] + store[1];
+#endif
+	for( ; i < count; ++i )
+		sum += array[i];
+	return sum;
+}
+
+
+int64_t array_sum_int64( const int64_t* array, unsigned int count )
+{
+	unsigned int i = 0;
+	uint64_t sum = 0;
+#if FOUNDATION_ARCH_AVX2
+	uint64_t store[4];
+	__m256i acc = _mm256_setzero_si256();
+	for( ; i + 4 <= count; i += 4 )
+		acc = _mm256_add_epi64( acc, _mm256_loadu_si256( (const __m256i*)( array + i ) ) );
+	_mm256_storeu_si256( (__m256i*)store, acc );
+	sum = store[0] + store[1] + store[2] + store[3];
+#elif FOUNDATION_ARCH_SSE2
+	uint64_t store[2];
+	__m128i acc = _mm_setzero_si128();
+	for( ; i + 2 <= count; i += 2 )
+		acc = _mm_add_epi64( acc, _mm_loadu_si128( (const __m128i*)( array + i ) ) );
+	_mm_storeu_si128( (__m128i*)store, acc );
+	sum = store[0] + store[1];
+#endif
+	//Accumulate unsigned to get defined wrap around
+	for( ; i < count; ++i )
+		sum += (uint64_t)array[i];
+	return (int64_t)sum;
+}
+
+
+float32_t array_sum_float32( const float32_t* array, unsigned int count )
+{
+	unsigned int i = 0;
+	float32_t sum = 0;
+#if FOUNDATION_ARCH_AVX2
+	float32_t store[8];
+	__m256 acc = _mm256_setzero_ps();
+	for( ; i + 8 <= count; i += 8 )
+		acc = _mm256_add_ps( acc, _mm256_loadu_ps( array + i ) );
+	_mm256_storeu_ps( store, acc );
+	sum = ( ( store[0] + store[1] ) + ( store[2] + store[3] ) ) + ( ( store[4] + store[5] ) + ( store[6] + store[7] ) );
+#elif FOUNDATION_ARCH_SSE2
+	float32_t store[4];
+	__m128 acc = _mm_setzero_ps();
+	for( ; i + 4 <= count; i += 4 )
+		acc = _mm_add_ps( acc, _mm_loadu_ps( array + i ) );
+	_mm_storeu_ps( store, acc );
+	sum = ( store[0] + store[1] ) + ( store[2] + store[3] );
+#endif
+	for( ; i < count; ++i )
+		sum += array[i];
+	return sum;
+}
+
+
+float64_t array_sum_float64( const float64_t* array, unsigned int count )
+{
+	unsigned int i = 0;
+	float64_t sum = 0;
+#if FOUNDATION_ARCH_AVX2
+	float64_t store[4];
+	__m256d acc = _mm256_setzero_pd();
+	for( ; i + 4 <= count; i += 4 )
+		acc = _mm256_add_pd( acc, _mm256_loadu_pd( array + i ) );
+	_mm256_storeu_pd( store, acc );
+	sum = ( store[0] + store[1] ) + ( store[2] + store[3] );
+#elif FOUNDATION_ARCH_SSE2
+	float64_t store[2];
+	__m128d acc = _mm_setzero_pd();
+	for( ; i + 2 <= count; i += 2 )
+		acc = _mm_add_pd( acc, _mm_loadu_pd( array + i ) );
+	_mm_storeu_pd( store, acc );
+	sum = store[0] + store[1];
+#endif
+	for( ; i < count; ++i )
+		sum += array[i];
+	return sum;
+}
+
+
+//Bounds are found by binary search down to a window of this many elements, which is then
+//resolved by counting elements less than (or not greater than) the value with a linear scan
+#define ARRAY_BOUND_WINDOW 32
+
+static unsigned int _array_count_less_int32( const int32_t* array, unsigned int count, int32_t value, bool inclusive )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_SSE2
+	__m128i value4 = _mm_set1_epi32( value );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)( array + i ) );
+		unsigned int mask = (unsigned int)_mm_movemask_ps( _mm_castsi128_ps( inclusive ? _mm_cmpgt_epi32( v, value4 ) : _mm_cmplt_epi32( v, value4 ) ) );
+		num += inclusive ? 4 - _array_mask_count( mask ) : _array_mask_count( mask );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( ( array[i] < value ) || ( inclusive && ( array[i] == value ) ) ) ? 1 : 0;
+	return num;
+}
+
+
+static unsigned int _array_count_less_uint32( const uint32_t* array, unsigned int count, uint32_t value, bool inclusive )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_SSE2
+	__m128i bias = _mm_set1_epi32( (int)0x80000000 );
+	__m128i value4 = _mm_xor_si128( _mm_set1_epi32( (int)value ), bias );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128i v = _mm_xor_si128( _mm_loadu_si128( (const __m128i*)( array + i ) ), bias );
+		unsigned int mask = (unsigned int)_mm_movemask_ps( _mm_castsi128_ps( inclusive ? _mm_cmpgt_epi32( v, value4 ) : _mm_cmplt_epi32( v, value4 ) ) );
+		num += inclusive ? 4 - _array_mask_count( mask ) : _array_mask_count( mask );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( ( array[i] < value ) || ( inclusive && ( array[i] == value ) ) ) ? 1 : 0;
+	return num;
+}
+
+
+static unsigned int _array_count_less_int64( const int64_t* array, unsigned int count, int64_t value, bool inclusive )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256i value4 = _mm256_set1_epi64x( value );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*)( array + i ) );
+		unsigned int mask = (unsigned int)_mm256_movemask_pd( _mm256_castsi256_pd( inclusive ? _mm256_cmpgt_epi64( v, value4 ) : _mm256_cmpgt_epi64( value4, v ) ) );
+		num += inclusive ? 4 - _array_mask_count( mask ) : _array_mask_count( mask );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( ( array[i] < value ) || ( inclusive && ( array[i] == value ) ) ) ? 1 : 0;
+	return num;
+}
+
+
+static unsigned int _array_count_less_uint64( const uint64_t* array, unsigned int count, uint64_t value, bool inclusive )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_AVX2
+	__m256i bias = _mm256_set1_epi64x( (int64_t)0x8000000000000000ULL );
+	__m256i value4 = _mm256_xor_si256( _mm256_set1_epi64x( (int64_t)value ), bias );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m256i v = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i*)( array + i ) ), bias );
+		unsigned int mask = (unsigned int)_mm256_movemask_pd( _mm256_castsi256_pd( inclusive ? _mm256_cmpgt_epi64( v, value4 ) : _mm256_cmpgt_epi64( value4, v ) ) );
+		num += inclusive ? 4 - _array_mask_count( mask ) : _array_mask_count( mask );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( ( array[i] < value ) || ( inclusive && ( array[i] == value ) ) ) ? 1 : 0;
+	return num;
+}
+
+
+static unsigned int _array_count_less_float32( const float32_t* array, unsigned int count, float32_t value, bool inclusive )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_SSE2
+	__m128 value4 = _mm_set1_ps( value );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 v = _mm_loadu_ps( array + i );
+		num += _array_mask_count( (unsigned int)_mm_movemask_ps( inclusive ? _mm_cmple_ps( v, value4 ) : _mm_cmplt_ps( v, value4 ) ) );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( ( array[i] < value ) || ( inclusive && ( array[i] == value ) ) ) ? 1 : 0;
+	return num;
+}
+
+
+static unsigned int _array_count_less_float64( const float64_t* array, unsigned int count, float64_t value, bool inclusive )
+{
+	unsigned int i = 0, num = 0;
+#if FOUNDATION_ARCH_SSE2
+	__m128d value2 = _mm_set1_pd( value );
+	for( ; i + 2 <= count; i += 2 )
+	{
+		__m128d v = _mm_loadu_pd( array + i );
+		num += _array_mask_count( (unsigned int)_mm_movemask_pd( inclusive ? _mm_cmple_pd( v, value2 ) : _mm_cmplt_pd( v, value2 ) ) );
+	}
+#endif
+	for( ; i < count; ++i )
+		num += ( ( array[i] < value ) || ( inclusive && ( array[i] == value ) ) ) ? 1 : 0;
+	return num;
+}
+
+
+#define _ARRAY_DEFINE_BOUNDS( suffix, type ) \
+	unsigned int array_lower_bound_##suffix( const type* array, unsigned int count, type value ) \
+	{ \
+		unsigned int base = 0; \
+		while( count > ARRAY_BOUND_WINDOW ) \
+		{ \
+			unsigned int half = count >> 1; \
+			base = ( array[ base + half ] < value ) ? base + half : base; \
+			count -= half; \
+		} \
+		return base + _array_count_less_##suffix( array + base, count, value, false ); \
+	} \
+	unsigned int array_upper_bound_##suffix( const type* array, unsigned int count, type value ) \
+	{ \
+		unsigned int base = 0; \
+		while( count > ARRAY_BOUND_WINDOW ) \
+		{ \
+			unsigned int half = count >> 1; \
+			base = ( array[ base + half ] <= value ) ? base + half : base; \
+			count -= half; \
+		} \
+		return base + _array_count_less_##suffix( array + base, count, value, true ); \
+	}
+
+_ARRAY_DEFINE_BOUNDS( int32, int32_t )
+_ARRAY_DEFINE_BOUNDS( uint32, uint32_t )
+_ARRAY_DEFINE_BOUNDS( int64, int64_t )
+_ARRAY_DEFINE_BOUNDS( uint64, uint64_t )
+_ARRAY_DEFINE_BOUNDS( float32, float32_t )
+_ARRAY_DEFINE_BOUNDS( float64, float64_t )
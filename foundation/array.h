@@ -21,14 +21,32 @@
 #include <foundation/types.h>
 
 
-//! Free array memory and reset pointer to zero.
-#define array_deallocate( array )                           ( _array_verify( array ) ? memory_deallocate( _array_raw( array ) ), (array)=0, 0 : 0 )
+//! Free array memory and reset pointer to zero. Inline storage is not freed, only storage allocated after spilling to heap.
+#define array_deallocate( array )                           ( _array_verify( array ) ? ( _array_isinline( array ) ? (void)0 : memory_deallocate( _array_raw( array ) ) ), (array)=0, 0 : 0 )
+
+//! Declare inline array storage for up to capacity elements of given type, for use as a struct member or local variable. Element type alignment must not exceed 16 bytes.
+#define array_inline( type, capacity )                      struct { _array_header_t header[_array_header_size]; type storage[capacity]; }
+
+//! Initialize inline array storage and get the array pointer to use with all other array functions. The array is moved to heap storage when growing beyond the inline capacity, call array_deallocate to free any heap storage.
+#define array_inline_initialize( inl )                      ( _array_inlinefn( (inl).header, (int64_t)( sizeof( (inl).storage ) / sizeof( *(inl).storage ) ) ), (inl).storage )
 
 //! Get capacity of buffer in number of elements.
 #define array_capacity( array )                             ( _array_verify( array ) ? _array_rawcapacity_const( array ) : 0 )
 
 //! Reserve storage for given number of elements (never reduces storage and does not affect number of currently stored elements).
-#define array_reserve( array, capacity )                    ( (void)_array_maybegrowfixed( array, (capacity) - array_capacity( array ) ) )
+#define array_reserve( array, capacity )                    ( (void)( ( (capacity) > array_capacity( array ) ) ? _array_grow( array, (capacity) - array_capacity( array ), 1 ), 0 : 0 ) )
+
+//! Reduce storage to the number of currently stored elements.
+#define array_shrink_to_fit( array )                        ( _array_verify( array ) && !_array_isinline( array ) && ( _array_rawcapacity( array ) > _array_rawsize( array ) ) ? _array_shrinkfn( &(array), sizeof( *(array) ) ), 0 : 0 )
+
+//! Set growth policy used when storage runs out on push/insert (ARRAY_GROWTH_DOUBLE by default). Allocates storage for one element if array is null.
+#define array_set_growth( array, growth )                   ( ( _array_verify( array ) ? 0 : ( _array_grow( array, 1, 1 ), 0 ) ), ( _array_verify( array ) ? _array_rawflags( array ) = ( _array_rawflags( array ) & ~_array_growth_mask ) | (growth), 0 : 0 ) )
+
+//! Get growth policy of array.
+#define array_growth( array )                               ( _array_verify( array ) ? (array_growth_t)( _array_rawflags_const( array ) & _array_growth_mask ) : ARRAY_GROWTH_DOUBLE )
+
+//! Query if array is using inline storage (has not spilled to heap).
+#define array_is_inline( array )                            ( _array_verify( array ) ? _array_isinline( array ) : false )
 
 //! Get number of currently stored elements. Safe to pass null pointer.
 #define array_size( array )                                 ( _array_verify( array ) ? _array_rawsize_const( array ) : 0 )
@@ -74,27 +92,106 @@
 #define array_erase_ordered_range_safe( array, pos, num )   do { int _clamped_start = math_clamp( (pos), 0, array_size( array ) ); int _clamped_end = math_clamp( ( (pos) + (num) ), 0, array_size( array ) ); if( _clamped_end > _clamped_start ) array_erase_ordered_range( array, _clamped_start, _clamped_end - _clamped_start ); } while(0)
 
 
+// Search and reduction over typed element buffers, pass array_size( array ) as count for arrays. Uses SSE2/AVX2 kernels
+// when enabled at compile time (FOUNDATION_ARCH_SSE2/FOUNDATION_ARCH_AVX2), scalar code otherwise. Floating point
+// results are undefined if the buffer contains NaN values, and float sums are accumulated in vector lanes order.
+
+//! Find index of first element equal to value, -1 if not found
+FOUNDATION_API int           array_find_int32( const int32_t* array, unsigned int count, int32_t value );
+FOUNDATION_API int           array_find_int64( const int64_t* array, unsigned int count, int64_t value );
+FOUNDATION_API int           array_find_float32( const float32_t* array, unsigned int count, float32_t value );
+FOUNDATION_API int           array_find_float64( const float64_t* array, unsigned int count, float64_t value );
+#define                      array_find_uint32( array, count, value )           array_find_int32( (const int32_t*)(array), (count), (int32_t)(value) )
+#define                      array_find_uint64( array, count, value )           array_find_int64( (const int64_t*)(array), (count), (int64_t)(value) )
+#define                      array_find_hash( array, count, value )             array_find_int64( (const int64_t*)(array), (count), (int64_t)(value) )
+
+//! Count number of elements equal to value
+FOUNDATION_API unsigned int  array_count_int32( const int32_t* array, unsigned int count, int32_t value );
+FOUNDATION_API unsigned int  array_count_int64( const int64_t* array, unsigned int count, int64_t value );
+FOUNDATION_API unsigned int  array_count_float32( const float32_t* array, unsigned int count, float32_t value );
+FOUNDATION_API unsigned int  array_count_float64( const float64_t* array, unsigned int count, float64_t value );
+#define                      array_count_uint32( array, count, value )          array_count_int32( (const int32_t*)(array), (count), (int32_t)(value) )
+#define                      array_count_uint64( array, count, value )          array_count_int64( (const int64_t*)(array), (count), (int64_t)(value) )
+#define                      array_count_hash( array, count, value )            array_count_int64( (const int64_t*)(array), (count), (int64_t)(value) )
+
+//! Get smallest element value, zero if count is zero
+FOUNDATION_API int32_t       array_min_int32( const int32_t* array, unsigned int count );
+FOUNDATION_API uint32_t      array_min_uint32( const uint32_t* array, unsigned int count );
+FOUNDATION_API int64_t       array_min_int64( const int64_t* array, unsigned int count );
+FOUNDATION_API uint64_t      array_min_uint64( const uint64_t* array, unsigned int count );
+FOUNDATION_API float32_t     array_min_float32( const float32_t* array, unsigned int count );
+FOUNDATION_API float64_t     array_min_float64( const float64_t* array, unsigned int count );
+
+//! Get largest element value, zero if count is zero
+FOUNDATION_API int32_t       array_max_int32( const int32_t* array, unsigned int count );
+FOUNDATION_API uint32_t      array_max_uint32( const uint32_t* array, unsigned int count );
+FOUNDATION_API int64_t       array_max_int64( const int64_t* array, unsigned int count );
+FOUNDATION_API uint64_t      array_max_uint64( const uint64_t* array, unsigned int count );
+FOUNDATION_API float32_t     array_max_float32( const float32_t* array, unsigned int count );
+FOUNDATION_API float64_t     array_max_float64( const float64_t* array, unsigned int count );
+
+//! Sum all elements, 32-bit integers are summed with 64-bit precision and 64-bit integer sums wrap around
+FOUNDATION_API int64_t       array_sum_int32( const int32_t* array, unsigned int count );
+FOUNDATION_API uint64_t      array_sum_uint32( const uint32_t* array, unsigned int count );
+FOUNDATION_API int64_t       array_sum_int64( const int64_t* array, unsigned int count );
+FOUNDATION_API float32_t     array_sum_float32( const float32_t* array, unsigned int count );
+FOUNDATION_API float64_t     array_sum_float64( const float64_t* array, unsigned int count );
+#define                      array_sum_uint64( array, count )                   ( (uint64_t)array_sum_int64( (const int64_t*)(array), (count) ) )
+
+//! Find index of first element not less than value in a buffer sorted in ascending order, count if all elements are less than value
+FOUNDATION_API unsigned int  array_lower_bound_int32( const int32_t* array, unsigned int count, int32_t value );
+FOUNDATION_API unsigned int  array_lower_bound_uint32( const uint32_t* array, unsigned int count, uint32_t value );
+FOUNDATION_API unsigned int  array_lower_bound_int64( const int64_t* array, unsigned int count, int64_t value );
+FOUNDATION_API unsigned int  array_lower_bound_uint64( const uint64_t* array, unsigned int count, uint64_t value );
+FOUNDATION_API unsigned int  array_lower_bound_float32( const float32_t* array, unsigned int count, float32_t value );
+FOUNDATION_API unsigned int  array_lower_bound_float64( const float64_t* array, unsigned int count, float64_t value );
+#define                      array_lower_bound_hash( array, count, value )      array_lower_bound_uint64( (array), (count), (value) )
+
+//! Find index of first element greater than value in a buffer sorted in ascending order, count if no element is greater than value
+FOUNDATION_API unsigned int  array_upper_bound_int32( const int32_t* array, unsigned int count, int32_t value );
+FOUNDATION_API unsigned int  array_upper_bound_uint32( const uint32_t* array, unsigned int count, uint32_t value );
+FOUNDATION_API unsigned int  array_upper_bound_int64( const int64_t* array, unsigned int count, int64_t value );
+FOUNDATION_API unsigned int  array_upper_bound_uint64( const uint64_t* array, unsigned int count, uint64_t value );
+FOUNDATION_API unsigned int  array_upper_bound_float32( const float32_t* array, unsigned int count, float32_t value );
+FOUNDATION_API unsigned int  array_upper_bound_float64( const float64_t* array, unsigned int count, float64_t value );
+#define                      array_upper_bound_hash( array, count, value )      array_upper_bound_uint64( (array), (count), (value) )
+
+
 // **** Internal implementation details below, not for direct use **** 
 
-//Header size set to 16 bytes in order to align main array memory
+//Header holds capacity, size, watermark and flags (growth policy and inline storage marker). Header size is 16 bytes (32 bytes with 64-bit
+//headers) in order to align main array memory
+#if BUILD_ENABLE_ARRAY_64BIT
+#  define _array_header_t            int64_t
+#else
+#  define _array_header_t            int32_t
+#endif
 #define _array_header_size           4UL
 #if BUILD_DEBUG
 #  define _array_verify(a)           ( _array_verifyfn((const void* const*)&(a)), (a) )
 #else
 #  define _array_verify(a)           (a)
 #endif
-#define _array_raw(a)                ( (int32_t*)(a)-_array_header_size )
+#define _array_raw(a)                ( (_array_header_t*)(a)-_array_header_size )
 #define _array_rawcapacity(a)        _array_raw(a)[0]
 #define _array_rawsize(a)            _array_raw(a)[1]
-#define _array_raw_const(a)          ( (const int32_t*)(a)-_array_header_size )
+#define _array_rawflags(a)           _array_raw(a)[3]
+#define _array_raw_const(a)          ( (const _array_header_t*)(a)-_array_header_size )
 #define _array_rawcapacity_const(a)  _array_raw_const(a)[0]
 #define _array_rawsize_const(a)      _array_raw_const(a)[1]
+#define _array_rawflags_const(a)     _array_raw_const(a)[3]
+
+#define _array_growth_mask           0xFF
+#define _array_flag_inline           0x100
+#define _array_isinline(a)           ( ( _array_rawflags_const(a) & _array_flag_inline ) != 0 )
 
 #define _array_needgrow(a,n)         ( ((n)>0) && ( _array_verify(a)==0 || (_array_rawsize_const(a)+(n)) > _array_rawcapacity_const(a) ) )
 #define _array_maybegrow(a,n)        ( _array_needgrow(a,(n)) ? _array_grow(a,n,2), 0 : 0 )
 #define _array_maybegrowfixed(a,n)   ( _array_needgrow(a,(n)) ? _array_grow(a,n,1), 0 : 0 )
 #define _array_grow(a,n,f)           ( _array_growfn(&(a),(n),(f),sizeof(*(a))) )
 
-FOUNDATION_API void _array_growfn( void* arr, int increment, int factor, int itemsize );
+FOUNDATION_API void _array_growfn( void* arr, int64_t increment, int factor, int itemsize );
+FOUNDATION_API void _array_shrinkfn( void* arr, int itemsize );
+FOUNDATION_API void _array_inlinefn( _array_header_t* header, int64_t capacity );
 FOUNDATION_API void _array_verifyfn( const void* const* arr );
 
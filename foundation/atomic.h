@@ -107,6 +107,14 @@ static FORCEINLINE bool         atomic_cas64( volatile int64_t* dst, int64_t val
 static FORCEINLINE bool         atomic_cas_ptr( void** dst, void* val, void* ref );
 #endif
 
+/*! Memory barrier with acquire semantics. Loads after the barrier are not performed before loads
+    preceding the barrier */
+static FORCEINLINE void         atomic_thread_fence_acquire( void );
+
+/*! Memory barrier with release semantics. Stores before the barrier are visible before stores
+    following the barrier */
+static FORCEINLINE void         atomic_thread_fence_release( void );
+
 
 
 static FORCEINLINE int32_t atomic_exchange_and_add32( volatile int32_t* val, int32_t add )
@@ -224,3 +232,32 @@ static FORCEINLINE bool atomic_cas_ptr( void** dst, void* val, void* ref )
 #  endif
 }
 #endif
+
+
+static FORCEINLINE void atomic_thread_fence_acquire( void )
+{
+#if FOUNDATION_PLATFORM_WINDOWS && ( FOUNDATION_COMPILER_MSVC || FOUNDATION_COMPILER_INTEL )
+#  if FOUNDATION_PLATFORM_ARCH_X86 || FOUNDATION_PLATFORM_ARCH_X86_64
+	_ReadWriteBarrier();
+#  else
+	MemoryBarrier();
+#  endif
+#elif FOUNDATION_PLATFORM_APPLE
+	OSMemoryBarrier();
+#elif FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+#  if FOUNDATION_PLATFORM_ARCH_X86 || FOUNDATION_PLATFORM_ARCH_X86_64
+	__asm__ __volatile__( "" ::: "memory" );
+#  else
+	__sync_synchronize();
+#  endif
+#else
+#  error Not implemented
+#endif
+}
+
+
+static FORCEINLINE void atomic_thread_fence_release( void )
+{
+	//x86 only reorders stores after loads, both barriers are compiler barriers there
+	atomic_thread_fence_acquire();
+}
@@ -0,0 +1,92 @@
+/* bucketarray.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <foundation/foundation.h>
+
+
+static bool _bucketarray_grow( bucketarray_t* array )
+{
+	void* bucket = memory_allocate( (uint64_t)array->element_size << array->bucket_shift, array->align, MEMORY_PERSISTENT );
+	if( !bucket )
+		return false;
+	array_push( array->bucket, bucket );
+	return true;
+}
+
+
+void bucketarray_initialize( bucketarray_t* array, unsigned int element_size, unsigned int align, unsigned int bucket_size )
+{
+	unsigned int shift = 0;
+	while( ( 1U << shift ) < bucket_size )
+		++shift;
+
+	memset( array, 0, sizeof( bucketarray_t ) );
+	array->element_size = element_size;
+	array->align = align;
+	array->bucket_shift = shift;
+}
+
+
+void bucketarray_destroy( bucketarray_t* array )
+{
+	if( array->bucket )
+		memory_deallocate_batch( array->bucket, array_size( array->bucket ) );
+	array_deallocate( array->bucket );
+	array->size = 0;
+}
+
+
+void* bucketarray_push( bucketarray_t* array, const void* element )
+{
+	void* stored;
+
+	FOUNDATION_ASSERT_MSG( array->element_size, "Bucket array not initialized" );
+
+	if( ( array->size >> array->bucket_shift ) >= (unsigned int)array_size( array->bucket ) )
+	{
+		if( !_bucketarray_grow( array ) )
+			return 0;
+	}
+
+	stored = bucketarray_get( array, array->size++ );
+	if( element )
+		memcpy( stored, element, array->element_size );
+	else
+		memset( stored, 0, array->element_size );
+	return stored;
+}
+
+
+void bucketarray_pop( bucketarray_t* array )
+{
+	if( array->size )
+		--array->size;
+}
+
+
+void bucketarray_clear( bucketarray_t* array )
+{
+	array->size = 0;
+}
+
+
+void bucketarray_reserve( bucketarray_t* array, unsigned int capacity )
+{
+	unsigned int buckets = ( capacity + ( 1U << array->bucket_shift ) - 1 ) >> array->bucket_shift;
+	if( buckets > (unsigned int)array_size( array->bucket ) )
+		array_reserve( array->bucket, (int)buckets );
+	while( buckets > (unsigned int)array_size( array->bucket ) )
+	{
+		if( !_bucketarray_grow( array ) )
+			break;
+	}
+}
@@ -0,0 +1,123 @@
+/* bucketarray.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file bucketarray.h
+    Chunked array with stable element addresses. Elements are stored in buckets of a fixed
+    power-of-two number of elements, growing the array adds buckets and never moves stored
+    elements, so pointers to elements remain valid until the element is popped or the array
+    is cleared or destroyed */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+#include <foundation/array.h>
+
+
+/*! Static initializer for a bucket array, for arrays with static storage that are used before
+    any initialization function can be called
+    \param size                     Element size
+    \param align                    Element alignment
+    \param shift                    Number of elements in each bucket as a power of two shift */
+#define BUCKETARRAY_INITIALIZER( size, align, shift ) { (size), (align), (shift), 0, 0 }
+
+/*! Initialize a bucket array
+    \param array                    Bucket array
+    \param element_size             Element size
+    \param align                    Element alignment
+    \param bucket_size              Number of elements in each bucket, rounded up to a power of two */
+FOUNDATION_API void                 bucketarray_initialize( bucketarray_t* array, unsigned int element_size, unsigned int align, unsigned int bucket_size );
+
+/*! Free all memory used by the array. Element size, alignment and bucket size are kept, the
+    array can be reused without initializing it again
+    \param array                    Bucket array */
+FOUNDATION_API void                 bucketarray_destroy( bucketarray_t* array );
+
+/*! Append an element, allocating a new bucket if needed
+    \param array                    Bucket array
+    \param element                  Element data to copy, zero to zero the new element
+    \return                         Pointer to the new element, stable until it is popped or the array cleared, zero if out of memory */
+FOUNDATION_API void*                bucketarray_push( bucketarray_t* array, const void* element );
+
+/*! Remove the last element
+    \param array                    Bucket array */
+FOUNDATION_API void                 bucketarray_pop( bucketarray_t* array );
+
+/*! Remove all elements. Buckets are kept and reused by later pushes
+    \param array                    Bucket array */
+FOUNDATION_API void                 bucketarray_clear( bucketarray_t* array );
+
+/*! Allocate buckets for at least the given number of elements
+    \param array                    Bucket array
+    \param capacity                 Number of elements */
+FOUNDATION_API void                 bucketarray_reserve( bucketarray_t* array, unsigned int capacity );
+
+/*! Get number of stored elements
+    \param array                    Bucket array
+    \return                         Number of elements */
+static FORCEINLINE PURECALL unsigned int bucketarray_size( const bucketarray_t* array );
+
+/*! Get number of elements that can be stored without allocating new buckets
+    \param array                    Bucket array
+    \return                         Capacity in number of elements */
+static FORCEINLINE PURECALL unsigned int bucketarray_capacity( const bucketarray_t* array );
+
+/*! Get element at given index. No range checking is done
+    \param array                    Bucket array
+    \param index                    Element index
+    \return                         Pointer to element */
+static FORCEINLINE PURECALL void*   bucketarray_get( const bucketarray_t* array, unsigned int index );
+
+/*! Get number of buckets holding stored elements, for iterating the array bucket by bucket
+    \param array                    Bucket array
+    \return                         Number of buckets in use */
+static FORCEINLINE PURECALL unsigned int bucketarray_bucket_count( const bucketarray_t* array );
+
+/*! Get storage of a bucket. Elements in a bucket are contiguous in memory
+    \param array                    Bucket array
+    \param bucket                   Bucket index, less than bucketarray_bucket_count()
+    \param count                    Receives number of stored elements in bucket
+    \return                         Pointer to first element in bucket */
+static FORCEINLINE void*            bucketarray_bucket( const bucketarray_t* array, unsigned int bucket, unsigned int* count );
+
+
+static FORCEINLINE unsigned int bucketarray_size( const bucketarray_t* array )
+{
+	return array->size;
+}
+
+
+static FORCEINLINE unsigned int bucketarray_capacity( const bucketarray_t* array )
+{
+	return (unsigned int)array_size( array->bucket ) << array->bucket_shift;
+}
+
+
+static FORCEINLINE void* bucketarray_get( const bucketarray_t* array, unsigned int index )
+{
+	return pointer_offset( array->bucket[ index >> array->bucket_shift ], (size_t)( index & ( ( 1U << array->bucket_shift ) - 1 ) ) * array->element_size );
+}
+
+
+static FORCEINLINE unsigned int bucketarray_bucket_count( const bucketarray_t* array )
+{
+	return ( array->size + ( 1U << array->bucket_shift ) - 1 ) >> array->bucket_shift;
+}
+
+
+static FORCEINLINE void* bucketarray_bucket( const bucketarray_t* array, unsigned int bucket, unsigned int* count )
+{
+	unsigned int first = bucket << array->bucket_shift;
+	unsigned int left = array->size - first;
+	*count = ( left < ( 1U << array->bucket_shift ) ) ? left : ( 1U << array->bucket_shift );
+	return array->bucket[ bucket ];
+}
@@ -26,11 +26,12 @@ typedef struct ALIGN(8) _foundation_stream_buffer
 } stream_buffer_t;
 
 static stream_vtable_t _buffer_stream_vtable;
+static mempool_t _buffer_stream_pool = MEMPOOL_INITIALIZER( sizeof( stream_buffer_t ), 8, MEMORYCONTEXT_STREAM );
 
 
 stream_t* buffer_stream_allocate( void* buffer, unsigned int mode, uint64_t size, uint64_t capacity, bool adopt, bool grow )
 {
-	stream_buffer_t* buffer_stream = memory_allocate_zero_context( MEMORYCONTEXT_STREAM, sizeof( stream_buffer_t ), 0, MEMORY_PERSISTENT );
+	stream_buffer_t* buffer_stream = mempool_allocate_zero( &_buffer_stream_pool );
 	stream_t* stream = (stream_t*)buffer_stream;
 
 	_stream_initialize( stream, system_byteorder() );
@@ -66,6 +67,12 @@ stream_t* buffer_stream_allocate( void* buffer, unsigned int mode, uint64_t size
 }
 
 
+static void _buffer_stream_release( stream_t* stream )
+{
+	mempool_deallocate( &_buffer_stream_pool, stream );
+}
+
+
 static void _buffer_stream_deallocate( stream_t* stream )
 {
 	stream_buffer_t* buffer_stream = (stream_buffer_t*)stream;
@@ -226,4 +233,5 @@ void _buffer_stream_initialize( void )
 	_buffer_stream_vtable.lastmod = _buffer_stream_lastmod;
 	_buffer_stream_vtable.available_read = _buffer_stream_available_read;
 	_buffer_stream_vtable.deallocate = _buffer_stream_deallocate;
+	_buffer_stream_vtable.release = _buffer_stream_release;
 }
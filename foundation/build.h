@@ -118,13 +118,32 @@
 #endif
 
 #ifndef BUILD_ENABLE_MEMORY_TRACKER
-#if BUILD_DEBUG || BUILD_RELEASE
+#if BUILD_DEBUG || BUILD_RELEASE || BUILD_PROFILE
 #define BUILD_ENABLE_MEMORY_TRACKER           1
 #else
 #define BUILD_ENABLE_MEMORY_TRACKER           0
 #endif
 #endif
 
+// Sampling heap profiler (memory_tracker_sampling), cheap enough to stay compiled in for deploy builds. The full
+// local tracker recording every allocation is controlled by BUILD_ENABLE_MEMORY_TRACKER
+#ifndef BUILD_ENABLE_MEMORY_SAMPLING
+#define BUILD_ENABLE_MEMORY_SAMPLING          1
+#endif
+
+// Per memory context statistics prefix every allocation through the memory frontend with a header of 8 bytes,
+// or the requested alignment if larger (up to 4KiB for page aligned blocks). Enabled in all builds including deploy
+// to attribute production memory use, define to 0 to drop the overhead. Note that deploy builds compile out the
+// memory context stack, only allocations with an explicit context are attributed to other than the global context
+#ifndef BUILD_ENABLE_MEMORY_STATISTICS
+#define BUILD_ENABLE_MEMORY_STATISTICS        1
+#endif
+
+// Use 64-bit capacity and size in array headers, allowing arrays with more than 2^31 elements at the cost of 16 extra bytes per array
+#ifndef BUILD_ENABLE_ARRAY_64BIT
+#define BUILD_ENABLE_ARRAY_64BIT              0
+#endif
+
 #ifndef BUILD_ENABLE_STATIC_HASH_DEBUG
 #if !BUILD_DEPLOY && FOUNDATION_PLATFORM_FAMILY_DESKTOP
 #define BUILD_ENABLE_STATIC_HASH_DEBUG        1
@@ -144,6 +163,13 @@
 // Default size of temporary (linear) memory allocator buffer
 #define BUILD_SIZE_TEMPORARY_MEMORY           2 * 1024 * 1024
 
+// Maximum number of per-thread temporary memory buffers, threads beyond this share a single buffer.
+// Address space for all buffers is reserved up front and only committed when a thread first uses its buffer
+#define BUILD_SIZE_TEMPORARY_THREAD_ARENAS    64
+
+// Default size above which the malloc memory system maps blocks directly from the OS (allowing in-place growth)
+#define BUILD_SIZE_MEMORY_MAP_THRESHOLD       ( 1 * 1024 * 1024 )
+
 // Maximum allowed size for an event block
 #define BUILD_SIZE_EVENT_BLOCK_LIMIT          ( 1 * 1024 * 1024 )
 
@@ -156,6 +182,28 @@
 // Maximum memory context depth
 #define BUILD_SIZE_MEMORY_CONTEXT_DEPTH       32
 
+// Number of memory contexts with separate allocation statistics, contexts beyond this share the last slot
+#define BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS 64
+
+// Number of size buckets in memory statistics histograms
+#define BUILD_SIZE_MEMORY_STATISTICS_HISTOGRAM 16
+
+// Maximum number of registered memory pressure callbacks
+#define BUILD_SIZE_MEMORY_PRESSURE_CALLBACKS  16
+
+// Default average number of bytes allocated between samples taken by the sampling memory tracker
+#define BUILD_SIZE_MEMORY_SAMPLE_INTERVAL     ( 512 * 1024 )
+
+// Maximum number of live sampled allocations and distinct call sites in the sampling memory tracker
+#define BUILD_SIZE_MEMORY_SAMPLES             16384
+#define BUILD_SIZE_MEMORY_SAMPLE_SITES        4096
+
+// Number of threads with per-thread object caches in memory pools, threads beyond this use the shared free list
+#define BUILD_SIZE_MEMPOOL_THREADS            32
+
+// Number of free objects cached per thread in memory pools
+#define BUILD_SIZE_MEMPOOL_MAGAZINE           16
+
 // Maximum stacktrace depth
 #define BUILD_SIZE_STACKTRACE_DEPTH           32
 
@@ -16,9 +16,13 @@
 
 #define BUILD_CONFIG_DEBUG        0
 
-#define CONFIG_SECTION_BUCKETS    7
 #define CONFIG_KEY_BUCKETS        11
 
+//Sections and keys are stored in bucket arrays to keep returned pointers valid when new entries are added,
+//sections are looked up through a sorted map from section name to section
+#define CONFIG_SECTION_BUCKET_SHIFT  2
+#define CONFIG_KEY_BUCKET_SIZE       4
+
 typedef enum _foundation_config_value_type
 {
 	CONFIGVALUE_BOOL = 0,
@@ -44,14 +48,15 @@ typedef struct ALIGN(16) _foundation_config_key
 typedef struct ALIGN(16) _foundation_config_section
 {
 	hash_t                  name;
-	config_key_t*           key[CONFIG_KEY_BUCKETS];
+	bucketarray_t           key[CONFIG_KEY_BUCKETS];
 } config_section_t;
 
 FOUNDATION_STATIC_ASSERT( ( sizeof( config_key_t ) % 16 ) == 0, config_key_align );
 FOUNDATION_STATIC_ASSERT( ( sizeof( config_section_t ) % 16 ) == 0, config_section_align );
 
 //Global config store
-static config_section_t* _config_section[CONFIG_SECTION_BUCKETS] = {0};
+static bucketarray_t _config_section = BUCKETARRAY_INITIALIZER( sizeof( config_section_t ), 16, CONFIG_SECTION_BUCKET_SHIFT );
+static flatmap_t* _config_section_map = 0;
 
 
 static int64_t _config_string_to_int( const char* str )
@@ -200,31 +205,50 @@ int _config_initialize( void )
 }
 
 
+#define CONFIG_SHUTDOWN_BATCH     64
+
+static void _config_shutdown_release( void** batch, unsigned int* num, void* p )
+{
+	if( !p )
+		return;
+	batch[(*num)++] = p;
+	if( *num == CONFIG_SHUTDOWN_BATCH )
+	{
+		memory_deallocate_batch( batch, *num );
+		*num = 0;
+	}
+}
+
+
 void _config_shutdown( void )
 {
-	int isb, is, ikb, ik, ssize, ksize;
+	unsigned int is, ikb, ik, ssize, ksize;
 	config_section_t* section;
 	config_key_t* key;
-	for( isb = 0; isb < CONFIG_SECTION_BUCKETS; ++isb )
+	void* batch[CONFIG_SHUTDOWN_BATCH];
+	unsigned int num = 0;
+	for( is = 0, ssize = bucketarray_size( &_config_section ); is < ssize; ++is )
 	{
-		section = _config_section[isb];
-		for( is = 0, ssize = array_size( section ); is < ssize; ++is )
+		section = bucketarray_get( &_config_section, is );
+		for( ikb = 0; ikb < CONFIG_KEY_BUCKETS; ++ikb )
 		{
-			for( ikb = 0; ikb < CONFIG_KEY_BUCKETS; ++ikb )
+			for( ik = 0, ksize = bucketarray_size( section->key + ikb ); ik < ksize; ++ik )
 			{
-				key = section[is].key[ikb];
-				for( ik = 0, ksize = array_size( key ); ik < ksize; ++ik )
-				{
-					if( key[ik].expanded != key[ik].sval )
-						string_deallocate( key[ik].expanded );
-					if( ( key[ik].type != CONFIGVALUE_STRING_CONST ) && ( key[ik].type != CONFIGVALUE_STRING_CONST_VAR ) )
-						string_deallocate( key[ik].sval );
-				}
-				array_deallocate( key );
+				key = bucketarray_get( section->key + ikb, ik );
+				if( key->expanded != key->sval )
+					_config_shutdown_release( batch, &num, key->expanded );
+				if( ( key->type != CONFIGVALUE_STRING_CONST ) && ( key->type != CONFIGVALUE_STRING_CONST_VAR ) )
+					_config_shutdown_release( batch, &num, key->sval );
 			}
+			bucketarray_destroy( section->key + ikb );
 		}
-		array_deallocate( section );
 	}
+	bucketarray_destroy( &_config_section );
+	memory_deallocate_batch( batch, num );
+
+	if( _config_section_map )
+		flatmap_deallocate( _config_section_map );
+	_config_section_map = 0;
 }
 
 
@@ -478,38 +502,37 @@ void config_load( const char* name, hash_t filter_section, bool built_in, bool o
 
 static NOINLINE config_section_t* config_section( hash_t section, bool create )
 {
-	config_section_t* bucket;
-	int ib, bsize;
-
-	bucket = _config_section[ section % CONFIG_SECTION_BUCKETS ];
-	for( ib = 0, bsize = array_size( bucket ); ib < bsize; ++ib )
-	{
-		if( bucket[ib].name == section )
-			return bucket + ib;
-	}
+	config_section_t* csection;
+	unsigned int ib;
 
-	if( !create )
-		return 0;
+	csection = _config_section_map ? flatmap_lookup( _config_section_map, section ) : 0;
+	if( csection || !create )
+		return csection;
 
 	//TODO: Thread safeness
-	{
-		config_section_t new_section = {0};
-		new_section.name = section;
+	if( !_config_section_map )
+		_config_section_map = flatmap_allocate( 16 );
 
-		array_push_memcpy( bucket, &new_section );
-		_config_section[ section % CONFIG_SECTION_BUCKETS ] = bucket;
+	csection = bucketarray_push( &_config_section, 0 );
+	if( csection )
+	{
+		csection->name = section;
+		for( ib = 0; ib < CONFIG_KEY_BUCKETS; ++ib )
+			bucketarray_initialize( csection->key + ib, sizeof( config_key_t ), 16, CONFIG_KEY_BUCKET_SIZE );
+		flatmap_insert( _config_section_map, section, csection );
 	}
 
-	return bucket + bsize;
+	return csection;
 }
 
 
 static NOINLINE config_key_t* config_key( hash_t section, hash_t key, bool create )
 {
-	config_key_t new_key = {0};
 	config_section_t* csection;
+	bucketarray_t* keys;
 	config_key_t* bucket;
-	int ib, bsize;
+	config_key_t* new_key;
+	unsigned int ib, ie, bcount, esize;
 
 	csection = config_section( section, create );
 	if( !csection )
@@ -517,23 +540,26 @@ static NOINLINE config_key_t* config_key( hash_t section, hash_t key, bool creat
 		FOUNDATION_ASSERT( !create );
 		return 0;
 	}
-	bucket = csection->key[ key % CONFIG_KEY_BUCKETS ];
-	for( ib = 0, bsize = array_size( bucket ); ib < bsize; ++ib )
+	keys = csection->key + ( key % CONFIG_KEY_BUCKETS );
+	for( ib = 0, bcount = bucketarray_bucket_count( keys ); ib < bcount; ++ib )
 	{
-		if( bucket[ib].name == key )
-			return bucket + ib;
+		bucket = bucketarray_bucket( keys, ib, &esize );
+		for( ie = 0; ie < esize; ++ie )
+		{
+			if( bucket[ie].name == key )
+				return bucket + ie;
+		}
 	}
 
 	if( !create )
 		return 0;
 
-	new_key.name = key;
-
 	//TODO: Thread safeness
-	array_push_memcpy( bucket, &new_key );
-	csection->key[ key % CONFIG_KEY_BUCKETS ] = bucket;
+	new_key = bucketarray_push( keys, 0 );
+	if( new_key )
+		new_key->name = key;
 
-	return bucket + bsize;
+	return new_key;
 }
 
 
@@ -843,7 +869,7 @@ void config_write( stream_t* stream, hash_t filter_section )
 {
 	config_section_t* csection;
 	config_key_t* bucket;
-	int key, ib, bsize;
+	unsigned int key, ib, bcount, ie, esize;
 
 	stream_set_binary( stream, false );
 
@@ -855,39 +881,42 @@ void config_write( stream_t* stream, hash_t filter_section )
 		csection = config_section( filter_section, false );
 		if( csection ) for( key = 0; key < CONFIG_KEY_BUCKETS; ++key )
 		{
-			bucket = csection->key[ key ];
-			for( ib = 0, bsize = array_size( bucket ); ib < bsize; ++ib )
+			for( ib = 0, bcount = bucketarray_bucket_count( csection->key + key ); ib < bcount; ++ib )
 			{
-				stream_write_format( stream, "\t%s\t\t\t\t= ", hash_to_string( bucket[ib].name ) );
-				switch( bucket[ib].type )
+				bucket = bucketarray_bucket( csection->key + key, ib, &esize );
+				for( ie = 0; ie < esize; ++ie )
 				{
-					case CONFIGVALUE_BOOL:
-						stream_write_bool( stream, bucket[ib].bval );
-						break;
+					stream_write_format( stream, "\t%s\t\t\t\t= ", hash_to_string( bucket[ie].name ) );
+					switch( bucket[ie].type )
+					{
+						case CONFIGVALUE_BOOL:
+							stream_write_bool( stream, bucket[ie].bval );
+							break;
 
-					case CONFIGVALUE_INT:
-						stream_write_int64( stream, bucket[ib].ival );
-						break;
+						case CONFIGVALUE_INT:
+							stream_write_int64( stream, bucket[ie].ival );
+							break;
 
-					case CONFIGVALUE_REAL:
+						case CONFIGVALUE_REAL:
 #if FOUNDATION_PLATFORM_REALSIZE == 64
-						stream_write_float64( stream, bucket[ib].rval );
+							stream_write_float64( stream, bucket[ie].rval );
 #else
-						stream_write_float32( stream, bucket[ib].rval );
+							stream_write_float32( stream, bucket[ie].rval );
 #endif
-						break;
+							break;
 
-					case CONFIGVALUE_STRING:
-					case CONFIGVALUE_STRING_CONST:
-					case CONFIGVALUE_STRING_VAR:
-					case CONFIGVALUE_STRING_CONST_VAR:
-						stream_write_string( stream, bucket[ib].sval );
-						break;
+						case CONFIGVALUE_STRING:
+						case CONFIGVALUE_STRING_CONST:
+						case CONFIGVALUE_STRING_VAR:
+						case CONFIGVALUE_STRING_CONST_VAR:
+							stream_write_string( stream, bucket[ie].sval );
+							break;
 
-					default:
-						break;
+						default:
+							break;
+					}
+					stream_write_endl( stream );
 				}
-				stream_write_endl( stream );
 			}
 		}
 	}
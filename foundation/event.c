@@ -20,6 +20,7 @@ struct _foundation_event_block
 {
 	volatile uint32_t                used;
 	uint32_t                         capacity;
+	uint32_t                         reserved;
 	event_stream_t*                  stream;
 	event_t*                         events;
 };
@@ -33,6 +34,43 @@ struct ALIGN(16) _foundation_event_stream
 
 static int32_t _event_serial = 1;
 
+#define BLOCK_CHUNK_SIZE ( 32 * 1024 )
+
+
+static event_t* _event_block_grow( event_block_t* block, uint32_t prev_capacity )
+{
+	uint64_t size = block->capacity + 2ULL;
+	event_t* events;
+
+	//Large blocks are moved once into a virtual address range reserved for the maximum block size,
+	//after which growing the block only commits more pages and never moves or copies events
+	if( block->reserved )
+	{
+		if( ( size <= block->reserved ) && memory_commit( block->events, size ) )
+			return block->events;
+		events = memory_allocate( size, 16, MEMORY_PERSISTENT );
+		memcpy( events, block->events, block->used );
+		memory_release_virtual( block->events, block->reserved );
+		block->reserved = 0;
+		return events;
+	}
+
+	if( block->events && ( size > BLOCK_CHUNK_SIZE ) && ( size < BUILD_SIZE_EVENT_BLOCK_LIMIT ) )
+	{
+		events = memory_reserve_virtual( BUILD_SIZE_EVENT_BLOCK_LIMIT );
+		if( events && memory_commit( events, size ) )
+		{
+			memcpy( events, block->events, block->used );
+			memory_deallocate( block->events );
+			block->reserved = BUILD_SIZE_EVENT_BLOCK_LIMIT;
+			return events;
+		}
+		memory_release_virtual( events, BUILD_SIZE_EVENT_BLOCK_LIMIT );
+	}
+
+	return block->events ? memory_reallocate( block->events, size, 16, prev_capacity ) : memory_allocate( size, 16, MEMORY_PERSISTENT );
+}
+
 
 static void _event_post_delay_with_flag( event_stream_t* stream, uint8_t systemid, uint8_t id, uint16_t size, uint64_t object, const void* payload, uint16_t flags, uint64_t timestamp )
 {
@@ -66,7 +104,6 @@ static void _event_post_delay_with_flag( event_stream_t* stream, uint8_t systemi
 
 	if( ( block->used + allocsize + 2 ) >= block->capacity )
 	{
-#define BLOCK_CHUNK_SIZE ( 32 * 1024 )
 		uint32_t prev_capacity = block->capacity + 2ULL;
 		if( block->capacity < BLOCK_CHUNK_SIZE )
 		{
@@ -81,7 +118,7 @@ static void _event_post_delay_with_flag( event_stream_t* stream, uint8_t systemi
 		}
 		if( block->capacity % 16 )
 			block->capacity += 16 - ( basesize % 16 );			
-		block->events = block->events ? memory_reallocate( block->events, block->capacity + 2ULL, 16, prev_capacity ) : memory_allocate( block->capacity + 2ULL, 16, MEMORY_PERSISTENT );
+		block->events = _event_block_grow( block, prev_capacity );
 	}
 
 	event = pointer_offset( block->events, block->used );
@@ -181,12 +218,16 @@ event_stream_t* event_stream_allocate( unsigned int size )
 
 void event_stream_deallocate( event_stream_t* stream )
 {
+	unsigned int iblock;
 	if( !stream )
 		return;
-	if( stream->block[0].events )
-		memory_deallocate( stream->block[0].events );
-	if( stream->block[1].events )
-		memory_deallocate( stream->block[1].events );
+	for( iblock = 0; iblock < 2; ++iblock )
+	{
+		if( stream->block[iblock].reserved )
+			memory_release_virtual( stream->block[iblock].events, stream->block[iblock].reserved );
+		else if( stream->block[iblock].events )
+			memory_deallocate( stream->block[iblock].events );
+	}
 	memory_deallocate( stream );
 }
 
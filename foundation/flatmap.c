@@ -0,0 +1,190 @@
+/* flatmap.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ * 
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ * 
+ * https://github.com/rampantpixels/foundation_lib
+ * 
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <foundation/foundation.h>
+
+#include <stdlib.h>
+
+
+//Keys and values are kept in separate arrays so lookups only touch the key array
+struct _foundation_flatmap
+{
+	hash_t*               key;
+	void**                value;
+};
+
+
+typedef struct _foundation_flatmap_node
+{
+	hash_t                key;
+	unsigned int          index;
+} flatmap_node_t;
+
+
+flatmap_t* flatmap_allocate( unsigned int capacity )
+{
+	flatmap_t* map = memory_allocate( sizeof( flatmap_t ), 0, MEMORY_PERSISTENT );
+
+	map->key   = 0;
+	map->value = 0;
+
+	if( capacity )
+	{
+		array_reserve( map->key, (int)capacity );
+		array_reserve( map->value, (int)capacity );
+	}
+
+	return map;
+}
+
+
+void flatmap_deallocate( flatmap_t* map )
+{
+	array_deallocate( map->key );
+	array_deallocate( map->value );
+	memory_deallocate( map );
+}
+
+
+void* flatmap_insert( flatmap_t* map, hash_t key, void* value )
+{
+	unsigned int size = array_size( map->key );
+	unsigned int index = array_lower_bound_hash( map->key, size, key );
+	if( ( index < size ) && ( map->key[index] == key ) )
+	{
+		void* prev = map->value[index];
+		map->value[index] = value;
+		return prev;
+	}
+	array_insert( map->key, index, key );
+	array_insert( map->value, index, value );
+	return 0;
+}
+
+
+void* flatmap_erase( flatmap_t* map, hash_t key )
+{
+	unsigned int size = array_size( map->key );
+	unsigned int index = array_lower_bound_hash( map->key, size, key );
+	if( ( index < size ) && ( map->key[index] == key ) )
+	{
+		void* prev = map->value[index];
+		array_erase_ordered( map->key, index );
+		array_erase_ordered( map->value, index );
+		return prev;
+	}
+	return 0;
+}
+
+
+void* flatmap_lookup( const flatmap_t* map, hash_t key )
+{
+	unsigned int size = array_size( map->key );
+	unsigned int index = array_lower_bound_hash( map->key, size, key );
+	return ( ( index < size ) && ( map->key[index] == key ) ) ? map->value[index] : 0;
+}
+
+
+bool flatmap_has_key( const flatmap_t* map, hash_t key )
+{
+	unsigned int size = array_size( map->key );
+	unsigned int index = array_lower_bound_hash( map->key, size, key );
+	return ( index < size ) && ( map->key[index] == key );
+}
+
+
+unsigned int flatmap_size( const flatmap_t* map )
+{
+	return array_size( map->key );
+}
+
+
+void flatmap_clear( flatmap_t* map )
+{
+	array_clear( map->key );
+	array_clear( map->value );
+}
+
+
+static int _flatmap_node_compare( const void* lhs, const void* rhs )
+{
+	const flatmap_node_t* lnode = lhs;
+	const flatmap_node_t* rnode = rhs;
+	if( lnode->key != rnode->key )
+		return ( lnode->key < rnode->key ) ? -1 : 1;
+	return ( lnode->index < rnode->index ) ? -1 : ( ( lnode->index > rnode->index ) ? 1 : 0 );
+}
+
+
+void flatmap_build( flatmap_t* map, const hash_t* keys, void* const* values, unsigned int num )
+{
+	unsigned int i, size = 0;
+
+	flatmap_clear( map );
+	if( !num )
+		return;
+
+	array_reserve( map->key, (int)num );
+	array_reserve( map->value, (int)num );
+
+	if( num <= (radixsort_index_t)-1 )
+	{
+		//Radix sort is stable, duplicate keys stay in input order
+		radixsort_t* sort = radixsort_allocate( RADIXSORT_UINT64, (radixsort_index_t)num );
+		const radixsort_index_t* order = radixsort( sort, keys, (radixsort_index_t)num );
+		for( i = 0; i < num; ++i )
+		{
+			radixsort_index_t src = order[i];
+			if( size && ( map->key[size-1] == keys[src] ) )
+				--size;
+			map->key[size] = keys[src];
+			map->value[size] = values[src];
+			++size;
+		}
+		radixsort_deallocate( sort );
+	}
+	else
+	{
+		//Too many entries for the radix sort index type, sort on key and input order
+		flatmap_node_t* node = memory_allocate( sizeof( flatmap_node_t ) * num, 0, MEMORY_TEMPORARY );
+		for( i = 0; i < num; ++i )
+		{
+			node[i].key = keys[i];
+			node[i].index = i;
+		}
+		qsort( node, num, sizeof( flatmap_node_t ), _flatmap_node_compare );
+		for( i = 0; i < num; ++i )
+		{
+			if( size && ( map->key[size-1] == node[i].key ) )
+				--size;
+			map->key[size] = node[i].key;
+			map->value[size] = values[ node[i].index ];
+			++size;
+		}
+		memory_deallocate( node );
+	}
+
+	array_grow( map->key, (int)size );
+	array_grow( map->value, (int)size );
+}
+
+
+const hash_t* flatmap_keys( const flatmap_t* map )
+{
+	return map->key;
+}
+
+
+void* const* flatmap_values( const flatmap_t* map )
+{
+	return map->value;
+}
@@ -0,0 +1,45 @@
+/* flatmap.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ * 
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ * 
+ * https://github.com/rampantpixels/foundation_lib
+ * 
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file flatmap.h
+    Container mapping hashvalues to pointers, stored as sorted key and value arrays. Lookup is
+    a binary search over the contiguous key array and iteration is in ascending key order.
+    Insert and erase move the following entries, use for read-mostly maps and build bulk
+    content with flatmap_build */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+
+FOUNDATION_API flatmap_t*                  flatmap_allocate( unsigned int capacity );
+FOUNDATION_API void                        flatmap_deallocate( flatmap_t* map );
+
+FOUNDATION_API void*                       flatmap_insert( flatmap_t* map, hash_t key, void* value );
+FOUNDATION_API void*                       flatmap_erase( flatmap_t* map, hash_t key );
+
+FOUNDATION_API void*                       flatmap_lookup( const flatmap_t* map, hash_t key );
+FOUNDATION_API bool                        flatmap_has_key( const flatmap_t* map, hash_t key );
+
+FOUNDATION_API unsigned int                flatmap_size( const flatmap_t* map );
+
+FOUNDATION_API void                        flatmap_clear( flatmap_t* map );
+
+//! Replace map content with the given key/value pairs in any order. Keys are sorted with a radix sort, for duplicate keys the last pair is kept
+FOUNDATION_API void                        flatmap_build( flatmap_t* map, const hash_t* keys, void* const* values, unsigned int num );
+
+//! Get keys in ascending order, flatmap_size() entries. Invalidated by any modification of the map
+FOUNDATION_API const hash_t*               flatmap_keys( const flatmap_t* map );
+
+//! Get values in ascending key order, matching the flatmap_keys() array
+FOUNDATION_API void* const*                flatmap_values( const flatmap_t* map );
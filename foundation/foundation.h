@@ -22,6 +22,7 @@
 #include <foundation/bits.h>
 #include <foundation/assert.h>
 #include <foundation/memory.h>
+#include <foundation/mempool.h>
 #include <foundation/atomic.h>
 #include <foundation/error.h>
 #include <foundation/thread.h>
@@ -38,7 +39,11 @@
 #include <foundation/base64.h>
 #include <foundation/md5.h>
 #include <foundation/array.h>
+#include <foundation/bucketarray.h>
 #include <foundation/hashmap.h>
+#include <foundation/flatmap.h>
+#include <foundation/groupmap.h>
+#include <foundation/shardmap.h>
 #include <foundation/hashtable.h>
 #include <foundation/ringbuffer.h>
 #include <foundation/string.h>
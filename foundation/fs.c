@@ -52,6 +52,7 @@ typedef struct ALIGN(8) _foundation_stream_file
 #define GET_STREAM( f ) ((stream_t*)(f))
 
 static stream_vtable_t _fs_file_vtable;
+static mempool_t _fs_file_pool = MEMPOOL_INITIALIZER( sizeof( stream_file_t ), 8, MEMORYCONTEXT_STREAM );
 
 static void* _fs_monitor( object_t, void* );
 
@@ -1221,6 +1222,12 @@ static stream_t* _fs_file_clone( stream_t* stream )
 }
 
 
+static void _fs_file_release( stream_t* stream )
+{
+	mempool_deallocate( &_fs_file_pool, stream );
+}
+
+
 static void _fs_file_close( stream_t* stream )
 {
 	stream_file_t* file = GET_FILE( stream );
@@ -1280,9 +1287,10 @@ stream_t* fs_open_file( const char* path, unsigned int mode )
 		mode |= STREAM_IN;
 
 	pathlen = string_length( path );
-	file = memory_allocate_zero_context( MEMORYCONTEXT_STREAM, sizeof( stream_file_t ), 0, MEMORY_PERSISTENT );
+	file = mempool_allocate_zero( &_fs_file_pool );
 	stream = GET_STREAM( file );
 	_stream_initialize( stream, BUILD_DEFAULT_STREAM_BYTEORDER );
+	stream->vtable = &_fs_file_vtable;
 
 	stream->type = STREAMTYPE_FILE;
 
@@ -1303,7 +1311,6 @@ stream_t* fs_open_file( const char* path, unsigned int mode )
 
 	stream->mode   = mode & ( STREAM_OUT | STREAM_IN | STREAM_BINARY | STREAM_SYNC );
 	stream->path   = has_protocol ? abspath : string_prepend( abspath, "file://" );
-	stream->vtable = &_fs_file_vtable;
 
 	if( !file->fd )
 	{
@@ -1339,6 +1346,7 @@ int _fs_initialize( void )
 	_fs_file_vtable.available_read = 0;
 	_fs_file_vtable.deallocate = _fs_file_close;
 	_fs_file_vtable.clone = _fs_file_clone;
+	_fs_file_vtable.release = _fs_file_release;
 
 	_ringbuffer_stream_initialize();
 	_buffer_stream_initialize();
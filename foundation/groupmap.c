@@ -0,0 +1,293 @@
+/* groupmap.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_ARCH_SSE2
+#  include <emmintrin.h>
+#endif
+
+
+//Open addressing over groups of 16 slots with one control byte per slot. A control byte is either
+//empty, deleted or the top 7 bits of the key hash. Lookups compare the tag against a whole control
+//group at once and only visit slots with a matching tag, probing stops at the first group with an
+//empty slot. Groups are probed in triangular sequence which visits every group once
+#define GROUPMAP_GROUP_SIZE        16
+#define GROUPMAP_MINCAPACITY       16
+#define GROUPMAP_MAXCAPACITY       0x80000000U
+#define GROUPMAP_LOAD_NUMERATOR    7
+#define GROUPMAP_LOAD_DENOMINATOR  8
+#define GROUPMAP_EMPTY             0x80
+#define GROUPMAP_DELETED           0xFE
+
+typedef struct _foundation_groupmap_slot
+{
+	hash_t                key;
+	void*                 value;
+} groupmap_slot_t;
+
+
+struct _foundation_groupmap
+{
+	unsigned int          capacity;
+	unsigned int          num_nodes;
+	unsigned int          growth_left; //Empty slots that can be used before the table must be rehashed
+	uint8_t*              control;
+	groupmap_slot_t*      slot;
+};
+
+
+static FORCEINLINE uint64_t _groupmap_hash( hash_t key )
+{
+	//Fold high bits down before the multiply so keys differing only in high bits still spread
+	return ( key ^ ( key >> 32 ) ) * 0x9E3779B97F4A7C15ULL;
+}
+
+
+static FORCEINLINE uint8_t _groupmap_tag( uint64_t hash )
+{
+	return (uint8_t)( hash >> 57 );
+}
+
+
+static FORCEINLINE unsigned int _groupmap_group( const groupmap_t* map, uint64_t hash )
+{
+	return (unsigned int)( hash >> 25 ) & ( ( map->capacity / GROUPMAP_GROUP_SIZE ) - 1 );
+}
+
+
+static FORCEINLINE unsigned int _groupmap_mask_first( unsigned int mask )
+{
+#if FOUNDATION_COMPILER_GCC || FOUNDATION_COMPILER_CLANG
+	return (unsigned int)__builtin_ctz( mask );
+#else
+	unsigned int bit = 0;
+	for( ; !( mask & 1 ); mask >>= 1 )
+		++bit;
+	return bit;
+#endif
+}
+
+
+//Get bit mask of slots in group with the given control byte
+static FORCEINLINE unsigned int _groupmap_match( const uint8_t* group, uint8_t control )
+{
+#if FOUNDATION_ARCH_SSE2
+	return (unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_load_si128( (const __m128i*)group ), _mm_set1_epi8( (char)control ) ) );
+#else
+	unsigned int mask = 0;
+	unsigned int islot;
+	for( islot = 0; islot < GROUPMAP_GROUP_SIZE; ++islot )
+		mask |= ( group[islot] == control ) ? ( 1U << islot ) : 0;
+	return mask;
+#endif
+}
+
+
+//Get bit mask of slots in group that are empty or deleted, which both have the high bit set
+static FORCEINLINE unsigned int _groupmap_match_free( const uint8_t* group )
+{
+#if FOUNDATION_ARCH_SSE2
+	return (unsigned int)_mm_movemask_epi8( _mm_load_si128( (const __m128i*)group ) );
+#else
+	unsigned int mask = 0;
+	unsigned int islot;
+	for( islot = 0; islot < GROUPMAP_GROUP_SIZE; ++islot )
+		mask |= ( group[islot] & 0x80 ) ? ( 1U << islot ) : 0;
+	return mask;
+#endif
+}
+
+
+static void _groupmap_set_capacity( groupmap_t* map, unsigned int capacity )
+{
+	unsigned int bits = 0;
+	while( ( 1U << bits ) < capacity )
+		++bits;
+	map->capacity = 1U << bits;
+	map->growth_left = (unsigned int)( (uint64_t)map->capacity * GROUPMAP_LOAD_NUMERATOR / GROUPMAP_LOAD_DENOMINATOR );
+
+	//Control bytes first, keeps both the control groups and the slots aligned
+	map->control = memory_allocate( (uint64_t)map->capacity * ( 1 + sizeof( groupmap_slot_t ) ), GROUPMAP_GROUP_SIZE, MEMORY_PERSISTENT );
+	map->slot = pointer_offset( map->control, map->capacity );
+	memset( map->control, GROUPMAP_EMPTY, map->capacity );
+}
+
+
+static groupmap_slot_t* _groupmap_find( const groupmap_t* map, hash_t key )
+{
+	uint64_t hash = _groupmap_hash( key );
+	uint8_t tag = _groupmap_tag( hash );
+	unsigned int mask = ( map->capacity / GROUPMAP_GROUP_SIZE ) - 1;
+	unsigned int group = _groupmap_group( map, hash );
+	unsigned int step = 0;
+
+	for( ;; )
+	{
+		const uint8_t* control = map->control + ( group * GROUPMAP_GROUP_SIZE );
+		unsigned int match = _groupmap_match( control, tag );
+		while( match )
+		{
+			groupmap_slot_t* slot = map->slot + ( group * GROUPMAP_GROUP_SIZE ) + _groupmap_mask_first( match );
+			if( slot->key == key )
+				return slot;
+			match &= match - 1;
+		}
+		if( _groupmap_match( control, GROUPMAP_EMPTY ) )
+			return 0;
+		group = ( group + ++step ) & mask;
+	}
+}
+
+
+//Store a key not present in the map in the first free slot of its probe sequence
+static void _groupmap_place( groupmap_t* map, hash_t key, void* value )
+{
+	uint64_t hash = _groupmap_hash( key );
+	unsigned int mask = ( map->capacity / GROUPMAP_GROUP_SIZE ) - 1;
+	unsigned int group = _groupmap_group( map, hash );
+	unsigned int step = 0;
+	unsigned int free;
+	unsigned int index;
+
+	while( !( free = _groupmap_match_free( map->control + ( group * GROUPMAP_GROUP_SIZE ) ) ) )
+		group = ( group + ++step ) & mask;
+
+	index = ( group * GROUPMAP_GROUP_SIZE ) + _groupmap_mask_first( free );
+	if( map->control[index] == GROUPMAP_EMPTY )
+		--map->growth_left;
+	map->control[index] = _groupmap_tag( hash );
+	map->slot[index].key = key;
+	map->slot[index].value = value;
+	++map->num_nodes;
+}
+
+
+static void _groupmap_rehash( groupmap_t* map )
+{
+	uint8_t* old_control = map->control;
+	groupmap_slot_t* old_slot = map->slot;
+	unsigned int old_capacity = map->capacity;
+	unsigned int capacity = old_capacity;
+	unsigned int islot;
+
+	//Grow if mostly full of live nodes, otherwise rehash in place size to purge deleted slots
+	if( ( ( map->num_nodes + 1 ) * 2 > (unsigned int)( (uint64_t)old_capacity * GROUPMAP_LOAD_NUMERATOR / GROUPMAP_LOAD_DENOMINATOR ) ) && ( old_capacity < GROUPMAP_MAXCAPACITY ) )
+		capacity *= 2;
+
+	map->num_nodes = 0;
+	_groupmap_set_capacity( map, capacity );
+	for( islot = 0; islot < old_capacity; ++islot )
+	{
+		if( !( old_control[islot] & 0x80 ) )
+			_groupmap_place( map, old_slot[islot].key, old_slot[islot].value );
+	}
+
+	memory_deallocate( old_control );
+}
+
+
+groupmap_t* groupmap_allocate( unsigned int capacity )
+{
+	groupmap_t* map;
+	uint64_t slots = (uint64_t)capacity * GROUPMAP_LOAD_DENOMINATOR / GROUPMAP_LOAD_NUMERATOR;
+	if( slots < GROUPMAP_MINCAPACITY )
+		slots = GROUPMAP_MINCAPACITY;
+	if( slots > GROUPMAP_MAXCAPACITY )
+		slots = GROUPMAP_MAXCAPACITY;
+
+	map = memory_allocate( sizeof( groupmap_t ), 0, MEMORY_PERSISTENT );
+	map->num_nodes = 0;
+	_groupmap_set_capacity( map, (unsigned int)slots );
+
+	return map;
+}
+
+
+void groupmap_deallocate( groupmap_t* map )
+{
+	void* raw[2];
+	raw[0] = map->control;
+	raw[1] = map;
+	memory_deallocate_batch( raw, 2 );
+}
+
+
+void* groupmap_insert( groupmap_t* map, hash_t key, void* value )
+{
+	groupmap_slot_t* slot = _groupmap_find( map, key );
+	if( slot )
+	{
+		void* prev = slot->value;
+		slot->value = value;
+		return prev;
+	}
+
+	if( !map->growth_left )
+		_groupmap_rehash( map );
+
+	_groupmap_place( map, key, value );
+
+	return 0;
+}
+
+
+void* groupmap_erase( groupmap_t* map, hash_t key )
+{
+	unsigned int index;
+	groupmap_slot_t* slot = _groupmap_find( map, key );
+	if( !slot )
+		return 0;
+
+	//A group with an empty slot ends every probe sequence passing it, the erased slot can then be
+	//made empty again. Otherwise a probe may need to continue past it and it is marked deleted
+	index = (unsigned int)( slot - map->slot );
+	if( _groupmap_match( map->control + ( index & ~( GROUPMAP_GROUP_SIZE - 1 ) ), GROUPMAP_EMPTY ) )
+	{
+		map->control[index] = GROUPMAP_EMPTY;
+		++map->growth_left;
+	}
+	else
+	{
+		map->control[index] = GROUPMAP_DELETED;
+	}
+	--map->num_nodes;
+
+	return slot->value;
+}
+
+
+void* groupmap_lookup( const groupmap_t* map, hash_t key )
+{
+	groupmap_slot_t* slot = _groupmap_find( map, key );
+	return slot ? slot->value : 0;
+}
+
+
+bool groupmap_has_key( const groupmap_t* map, hash_t key )
+{
+	return _groupmap_find( map, key ) != 0;
+}
+
+
+unsigned int groupmap_size( const groupmap_t* map )
+{
+	return map->num_nodes;
+}
+
+
+void groupmap_clear( groupmap_t* map )
+{
+	memset( map->control, GROUPMAP_EMPTY, map->capacity );
+	map->num_nodes = 0;
+	map->growth_left = (unsigned int)( (uint64_t)map->capacity * GROUPMAP_LOAD_NUMERATOR / GROUPMAP_LOAD_DENOMINATOR );
+}
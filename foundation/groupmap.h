@@ -0,0 +1,36 @@
+/* groupmap.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file groupmap.h
+    Container mapping hashvalues to pointers, tuned for lookup heavy use. Slots are probed in
+    groups of 16, each slot has a control byte holding 7 bits of the key hash and a group is
+    matched against the searched key with a single SIMD compare, so most lookups touch one
+    control group and one slot */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+
+FOUNDATION_API groupmap_t*                 groupmap_allocate( unsigned int capacity );
+FOUNDATION_API void                        groupmap_deallocate( groupmap_t* map );
+
+FOUNDATION_API void*                       groupmap_insert( groupmap_t* map, hash_t key, void* value );
+FOUNDATION_API void*                       groupmap_erase( groupmap_t* map, hash_t key );
+
+FOUNDATION_API void*                       groupmap_lookup( const groupmap_t* map, hash_t key );
+FOUNDATION_API bool                        groupmap_has_key( const groupmap_t* map, hash_t key );
+
+FOUNDATION_API unsigned int                groupmap_size( const groupmap_t* map );
+
+FOUNDATION_API void                        groupmap_clear( groupmap_t* map );
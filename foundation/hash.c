@@ -191,8 +191,8 @@ void _static_hash_initialize( void )
 
 void _static_hash_shutdown( void )
 {
-	unsigned int slot;
-	for( slot = 0; slot < BUILD_SIZE_STATIC_HASH_STORE + 1; ++slot )
+	uint64_t slot;
+	for( slot = 0; slot < hashtable64_raw_capacity( _hash_lookup ); ++slot )
 	{
 		char* str = (char*)((uintptr_t)hashtable64_raw( _hash_lookup, slot ));
 		if( str )
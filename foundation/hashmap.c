@@ -11,127 +11,140 @@
  */
 
 #include <foundation/foundation.h>
+#include <foundation/internal.h>
 
 
-typedef struct _foundation_hashmap_node
+//Open addressing with Robin Hood probing, see robinhood_table_t in internal.h
+#define HASHMAP_BATCH_SIZE         16
+
+struct _foundation_hashmap
 {
-	hash_t                key;
-	void*                 value;
-} hashmap_node_t;
+	robinhood_table_t     table;
+	unsigned int          num_nodes;
+};
 
 
-typedef hashmap_node_t*   hashmap_bucket_t;
+static void _hashmap_set_capacity( hashmap_t* map, unsigned int capacity )
+{
+	unsigned int bits = _robinhood_bits( capacity );
+	_robinhood_initialize( &map->table, bits, memory_allocate_zero( sizeof( robinhood_node_t ) * ( 1ULL << bits ), 0, MEMORY_PERSISTENT ) );
+}
 
 
-struct _foundation_hashmap
+static void _hashmap_resize( hashmap_t* map, unsigned int capacity )
 {
-	unsigned int          num_buckets;
-	unsigned int          num_nodes;
-	hashmap_bucket_t      bucket[];
-};
-	
+	robinhood_table_t old_table = map->table;
+
+	_hashmap_set_capacity( map, capacity );
+	_robinhood_rehash( &map->table, &old_table );
+
+	memory_deallocate( old_table.node );
+}
+
 
 hashmap_t* hashmap_allocate( unsigned int buckets, unsigned int bucketsize )
 {
 	hashmap_t* map;
-	unsigned int ibucket;
+	uint64_t capacity;
 
 	if( buckets < HASHMAP_MINBUCKETS )
 		buckets = HASHMAP_MINBUCKETS;
 	if( bucketsize < HASHMAP_MINBUCKETSIZE )
 		bucketsize = HASHMAP_MINBUCKETSIZE;
-	
-	map = memory_allocate( sizeof( hashmap_t ) + sizeof( hashmap_bucket_t ) * buckets, 0, MEMORY_PERSISTENT );
 
-	map->num_buckets = buckets;
-	map->num_nodes   = 0;
+	//Bucket count and size give the expected number of nodes, size table to hold them below max load
+	capacity = (uint64_t)buckets * bucketsize * ROBINHOOD_LOAD_DENOMINATOR / ROBINHOOD_LOAD_NUMERATOR;
+	if( capacity < ROBINHOOD_MINCAPACITY )
+		capacity = ROBINHOOD_MINCAPACITY;
+	if( capacity > ROBINHOOD_MAXCAPACITY )
+		capacity = ROBINHOOD_MAXCAPACITY;
+
+	map = memory_allocate( sizeof( hashmap_t ), 0, MEMORY_PERSISTENT );
+	map->num_nodes = 0;
+	_hashmap_set_capacity( map, (unsigned int)capacity );
 
-	for( ibucket = 0; ibucket < buckets; ++ibucket )
-	{
-		map->bucket[ibucket] = 0;
-		array_reserve( map->bucket[ibucket], (int)bucketsize );
-	}
-	
 	return map;
 }
 
 
 void hashmap_deallocate( hashmap_t* map )
 {
-	unsigned int ibucket;
-	for( ibucket = 0; ibucket < map->num_buckets; ++ibucket )
-		array_deallocate( map->bucket[ibucket] );
-	memory_deallocate( map );
+	void* raw[2];
+	raw[0] = map->table.node;
+	raw[1] = map;
+	memory_deallocate_batch( raw, 2 );
 }
 
 
 void* hashmap_insert( hashmap_t* map, hash_t key, void* value )
 {
-	unsigned int ibucket = (unsigned int)( key % map->num_buckets );
-	hashmap_bucket_t bucket = map->bucket[ibucket];
-	unsigned int inode, nsize;
-	for( inode = 0, nsize = array_size( bucket ); inode < nsize; ++inode )
+	robinhood_node_t* node = _robinhood_find( &map->table, key );
+	if( node )
 	{
-		if( bucket[inode].key == key )
-		{
-			void* prev = bucket[inode].value;
-			bucket[inode].value = value;
-			return prev;
-		}
-	}
-	{
-		hashmap_node_t node = { key, value };
-		array_push( map->bucket[ibucket], node );
-		++map->num_nodes;
+		void* prev = node->value;
+		node->value = value;
+		return prev;
 	}
+
+	if( _robinhood_need_grow( &map->table, map->num_nodes ) )
+		_hashmap_resize( map, map->table.capacity * 2 );
+
+	_robinhood_place( &map->table, key, value );
+	++map->num_nodes;
+
 	return 0;
 }
 
 
 void* hashmap_erase( hashmap_t* map, hash_t key )
 {
-	unsigned int ibucket = (unsigned int)( key % map->num_buckets );
-	hashmap_bucket_t bucket = map->bucket[ibucket];
-	unsigned int inode, nsize;
-	for( inode = 0, nsize = array_size( bucket ); inode < nsize; ++inode )
-	{
-		if( bucket[inode].key == key )
-		{
-			void* prev = bucket[inode].value;
-			array_erase( map->bucket[ibucket], inode );
-			--map->num_nodes;
-			return prev;
-		}
-	}
-	return 0;
+	void* prev;
+	robinhood_node_t* node = _robinhood_find( &map->table, key );
+	if( !node )
+		return 0;
+
+	prev = node->value;
+	_robinhood_erase( &map->table, node );
+	--map->num_nodes;
+
+	return prev;
 }
 
 
 void* hashmap_lookup( hashmap_t* map, hash_t key )
 {
-	unsigned int ibucket = (unsigned int)( key % map->num_buckets );
-	hashmap_bucket_t bucket = map->bucket[ibucket];
-	unsigned int inode, nsize;
-	for( inode = 0, nsize = array_size( bucket ); inode < nsize; ++inode )
+	robinhood_node_t* node = _robinhood_find( &map->table, key );
+	return node ? node->value : 0;
+}
+
+
+void hashmap_lookup_batch( hashmap_t* map, const hash_t* keys, unsigned int num, void** values )
+{
+	unsigned int slot[HASHMAP_BATCH_SIZE];
+	unsigned int ikey, ibatch, batch;
+
+	//Compute home slots and prefetch a batch of nodes before resolving any of them, so the cache
+	//misses of independent lookups overlap instead of being taken one after another
+	for( ikey = 0; ikey < num; ikey += batch )
 	{
-		if( bucket[inode].key == key )
-			return bucket[inode].value;
+		batch = ( num - ikey < HASHMAP_BATCH_SIZE ) ? num - ikey : HASHMAP_BATCH_SIZE;
+		for( ibatch = 0; ibatch < batch; ++ibatch )
+		{
+			slot[ibatch] = _robinhood_home( &map->table, keys[ikey + ibatch] );
+			PREFETCH( map->table.node + slot[ibatch] );
+		}
+		for( ibatch = 0; ibatch < batch; ++ibatch )
+		{
+			robinhood_node_t* node = _robinhood_find_from( &map->table, keys[ikey + ibatch], slot[ibatch] );
+			values[ikey + ibatch] = node ? node->value : 0;
+		}
 	}
-	return 0;
 }
 
 
 bool hashmap_has_key( hashmap_t* map, hash_t key )
 {
-	unsigned int ibucket = (unsigned int)( key % map->num_buckets );
-	hashmap_bucket_t bucket = map->bucket[ibucket];
-	unsigned int inode, nsize;
-	for( inode = 0, nsize = array_size( bucket ); inode < nsize; ++inode )
-	{
-		if( bucket[inode].key == key )
-			return true;
-	}
-	return false;
+	return _robinhood_find( &map->table, key ) != 0;
 }
 
 
@@ -143,8 +156,6 @@ unsigned int hashmap_size( hashmap_t* map )
 
 void hashmap_clear( hashmap_t* map )
 {
-	unsigned int ibucket;
-	for( ibucket = 0; ibucket < map->num_buckets; ++ibucket )
-		array_clear( map->bucket[ibucket] );
+	memset( map->table.node, 0, sizeof( robinhood_node_t ) * map->table.capacity );
 	map->num_nodes = 0;
 }
@@ -29,6 +29,8 @@ FOUNDATION_API void*                       hashmap_insert( hashmap_t* map, hash_
 FOUNDATION_API void*                       hashmap_erase( hashmap_t* map, hash_t key );
 
 FOUNDATION_API void*                       hashmap_lookup( hashmap_t* map, hash_t key );
+//! Look up num keys, storing the value of each key or zero if not found in values. Cache misses of the lookups overlap, use for many independent lookups in large maps
+FOUNDATION_API void                        hashmap_lookup_batch( hashmap_t* map, const hash_t* keys, unsigned int num, void** values );
 FOUNDATION_API bool                        hashmap_has_key( hashmap_t* map, hash_t key );
 
 FOUNDATION_API unsigned int                hashmap_size( hashmap_t* map );
@@ -21,3 +21,8 @@
 #define HASH_REMOTE static_hash_string( "remote", 0x4d4ee1b3734e2c5cULL )
 #define HASH_NONE static_hash_string( "none", 0xa90768116f8af366ULL )
 #define HASH_TEST static_hash_string( "test", 0x74326336c500c367ULL )
+#define HASH_MEMORY_MAP_THRESHOLD static_hash_string( "memory_map_threshold", 0x8f06daa86e6515ebULL )
+#define HASH_SAMPLING static_hash_string( "sampling", 0x889f501c8add6cbeULL )
+#define HASH_MEMORY_SAMPLE_INTERVAL static_hash_string( "memory_sample_interval", 0x4686143d2ade776aULL )
+#define HASH_MEMORY_BUDGET_SOFT static_hash_string( "memory_budget_soft", 0x07937c5c04190958ULL )
+#define HASH_MEMORY_BUDGET_HARD static_hash_string( "memory_budget_hard", 0x0766a6fee4faaf84ULL )
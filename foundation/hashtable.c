@@ -14,6 +14,27 @@
 #include <foundation/internal.h>
 
 
+//Open addressing with linear probing over a power-of-two sized store. Keys are claimed with a CAS
+//and never released within a store, erase only clears the value and leaves the key as a tombstone.
+//When claimed keys reach max load writers allocate a new store sized for the live entries and
+//cooperatively copy live entries to it in chunks, which grows the table or compacts away tombstones.
+//Writers arriving during the migration help copy instead of writing and retry on the new store once
+//it is published. Readers are never blocked, a replaced store is frozen during migration. Readers
+//register in one of two counters selected by the epoch parity, the replaced store is freed after the
+//epoch is flipped and the readers of the previous parity are done. Reader counters are striped over
+//cache line sized slots picked per thread so concurrent readers do not contend on a single line
+#define HASHTABLE_MINCAPACITY       16
+#define HASHTABLE_LOAD_NUMERATOR    3
+#define HASHTABLE_LOAD_DENOMINATOR  4
+#define HASHTABLE_MIGRATE_CHUNK     256
+
+//Number of reader counter slots, must be a power of two
+#define HASHTABLE_READER_SLOTS      16
+
+//Number of lookups with slots computed and prefetched ahead of resolving them in batched gets
+#define HASHTABLE_BATCH_SIZE        16
+
+
 typedef struct _foundation_hashtable32_entry
 {
 	uint32_t   key;
@@ -28,20 +49,91 @@ typedef struct _foundation_hashtable64_entry
 } hashtable64_entry_t;
 
 
-struct ALIGN(8) _foundation_hashtable32
+typedef struct ALIGN(64) _foundation_hashtable_reader
+{
+	volatile int32_t   readers[2];   //Readers in a read section, indexed by epoch parity
+} hashtable_reader_t;
+
+
+typedef struct _foundation_hashtable32_store hashtable32_store_t;
+typedef struct _foundation_hashtable64_store hashtable64_store_t;
+
+
+struct ALIGN(8) _foundation_hashtable32_store
 {
 	uint32_t                        capacity;
+	volatile int32_t                used;        //Number of claimed keys
+	volatile int32_t                chunk_next;  //Next chunk to migrate
+	volatile int32_t                chunk_done;  //Number of migrated chunks
+	hashtable32_store_t* volatile   next;        //Store being migrated to
 	ALIGN(8) hashtable32_entry_t    entries[];
 };
 
 
-struct ALIGN(8) _foundation_hashtable64
+struct ALIGN(8) _foundation_hashtable64_store
 {
 	uint64_t                        capacity;
+	volatile int32_t                used;
+	volatile int32_t                chunk_next;
+	volatile int32_t                chunk_done;
+	hashtable64_store_t* volatile   next;
 	ALIGN(8) hashtable64_entry_t    entries[];
 };
 
 
+//Fields loaded by readers, fields modified by writers and the reader slots are kept on separate cache lines
+struct ALIGN(64) _foundation_hashtable32
+{
+	hashtable32_store_t* volatile   store;
+	volatile int32_t                epoch;       //Parity selects the reader counter for new readers
+	ALIGN(64) volatile int32_t      writers;     //Number of writers operating on the current store
+	volatile int32_t                resizing;
+	volatile int32_t                count;       //Number of keys with a value
+	hashtable_reader_t              reader[HASHTABLE_READER_SLOTS];
+};
+
+
+struct ALIGN(64) _foundation_hashtable64
+{
+	hashtable64_store_t* volatile   store;
+	volatile int32_t                epoch;
+	ALIGN(64) volatile int32_t      writers;
+	volatile int32_t                resizing;
+	volatile int32_t                count;
+	hashtable_reader_t              reader[HASHTABLE_READER_SLOTS];
+};
+
+
+static volatile int32_t _hashtable_reader_next = 0;
+
+FOUNDATION_DECLARE_THREAD_LOCAL( int, hashtable_reader_slot, 0 )
+
+
+//Reader slot of the calling thread, assigned round robin on first use
+static FORCEINLINE hashtable_reader_t* _hashtable_reader( hashtable_reader_t* reader )
+{
+	int slot = get_thread_hashtable_reader_slot();
+	if( !slot )
+	{
+		slot = ( atomic_incr32( &_hashtable_reader_next ) & ( HASHTABLE_READER_SLOTS - 1 ) ) + 1;
+		set_thread_hashtable_reader_slot( slot );
+	}
+	return reader + ( slot - 1 );
+}
+
+
+//Wait until all readers registered with the given parity have left their read sections
+static void _hashtable_readers_wait( hashtable_reader_t* reader, int32_t parity )
+{
+	unsigned int islot;
+	for( islot = 0; islot < HASHTABLE_READER_SLOTS; ++islot )
+	{
+		while( reader[islot].readers[parity] )
+			thread_yield();
+	}
+}
+
+
 
 static FORCEINLINE uint32_t _hashtable32_hash( uint32_t key )
 {
@@ -66,276 +158,656 @@ static FORCEINLINE uint64_t _hashtable64_hash( uint64_t key )
 
 
 
+static hashtable32_store_t* _hashtable32_store_allocate( uint64_t capacity )
+{
+	hashtable32_store_t* store;
+	uint64_t size = HASHTABLE_MINCAPACITY;
+	while( size < capacity )
+		size <<= 1;
+
+	store = memory_allocate_zero( sizeof( hashtable32_store_t ) + sizeof( hashtable32_entry_t ) * size, 8, MEMORY_PERSISTENT );
+	store->capacity = (uint32_t)size;
+	return store;
+}
+
+
+//Find the slot of the key, claiming a free slot if the key is not stored and the store is below max load.
+//Returns null if the key is not stored and a free slot could not be claimed
+static hashtable32_entry_t* _hashtable32_claim( hashtable32_store_t* store, uint32_t key )
+{
+	uint32_t mask = store->capacity - 1;
+	uint32_t ie = _hashtable32_hash( key ) & mask;
+	uint32_t iprobe;
+	for( iprobe = 0; iprobe < store->capacity; ++iprobe, ie = ( ie + 1 ) & mask )
+	{
+		uint32_t current_key = store->entries[ie].key;
+		if( current_key == key )
+			return store->entries + ie;
+		if( !current_key )
+		{
+			if( (uint64_t)store->used * HASHTABLE_LOAD_DENOMINATOR >= (uint64_t)store->capacity * HASHTABLE_LOAD_NUMERATOR )
+				return 0;
+			if( atomic_cas32( (volatile int32_t*)&store->entries[ie].key, key, 0 ) )
+			{
+				atomic_incr32( &store->used );
+				return store->entries + ie;
+			}
+			if( store->entries[ie].key == key )
+				return store->entries + ie;
+		}
+	}
+	return 0;
+}
+
+
+//Store a value and return the previous value
+static FORCEINLINE uint32_t _hashtable32_exchange( hashtable32_entry_t* entry, uint32_t value )
+{
+	uint32_t prev;
+	do
+	{
+		prev = entry->value;
+	} while( !atomic_cas32( (volatile int32_t*)&entry->value, (int32_t)value, (int32_t)prev ) );
+	return prev;
+}
+
+
+static hashtable32_entry_t* _hashtable32_find( hashtable32_store_t* store, uint32_t key, uint32_t ie )
+{
+	uint32_t mask = store->capacity - 1;
+	uint32_t iprobe;
+	for( iprobe = 0; iprobe < store->capacity; ++iprobe, ie = ( ie + 1 ) & mask )
+	{
+		uint32_t current_key = store->entries[ie].key;
+		if( current_key == key )
+			return store->entries + ie;
+		if( !current_key )
+			return 0;
+	}
+	return 0;
+}
+
+
+//Enter a read section, the store returned is valid until the section ends
+static FORCEINLINE hashtable32_store_t* _hashtable32_read_begin( hashtable32_t* table, volatile int32_t** counter )
+{
+	hashtable_reader_t* reader = _hashtable_reader( table->reader );
+	do
+	{
+		int32_t parity = table->epoch & 1;
+		*counter = reader->readers + parity;
+		atomic_incr32( *counter );
+		if( ( table->epoch & 1 ) == parity )
+			return table->store;
+		atomic_decr32( *counter );
+	} while( true );
+}
+
+
+static FORCEINLINE void _hashtable32_read_end( volatile int32_t* counter )
+{
+	atomic_decr32( counter );
+}
+
+
+static void _hashtable32_migrate( hashtable32_t* table )
+{
+	while( table->resizing )
+	{
+		volatile int32_t* counter;
+		int32_t parity;
+		hashtable32_store_t* store = _hashtable32_read_begin( table, &counter );
+		hashtable32_store_t* next = store->next;
+		int32_t num_chunks = (int32_t)( ( (uint64_t)store->capacity + HASHTABLE_MIGRATE_CHUNK - 1 ) / HASHTABLE_MIGRATE_CHUNK );
+		int32_t chunk = num_chunks;
+		bool last = false;
+
+		if( next && ( store->chunk_next < num_chunks ) && ( ( chunk = atomic_exchange_and_add32( &store->chunk_next, 1 ) ) < num_chunks ) )
+		{
+			uint32_t ie = (uint32_t)chunk * HASHTABLE_MIGRATE_CHUNK;
+			uint32_t eend = ( store->capacity - ie > HASHTABLE_MIGRATE_CHUNK ) ? ie + HASHTABLE_MIGRATE_CHUNK : store->capacity;
+			for( ; ie < eend; ++ie )
+			{
+				if( store->entries[ie].key && store->entries[ie].value )
+					_hashtable32_claim( next, store->entries[ie].key )->value = store->entries[ie].value;
+			}
+			last = ( atomic_incr32( &store->chunk_done ) == num_chunks );
+		}
+
+		_hashtable32_read_end( counter );
+
+		if( last )
+		{
+			//Last chunk copied, publish the new store. Flip the reader epoch and free the old store once
+			//readers that might have loaded it are done, then let writers back in
+			atomic_cas_ptr( (void* volatile*)&table->store, next, store );
+			parity = table->epoch & 1;
+			atomic_incr32( &table->epoch );
+			_hashtable_readers_wait( table->reader, parity );
+			memory_deallocate( store );
+			atomic_cas32( &table->resizing, 0, 1 );
+		}
+		else if( chunk >= num_chunks )
+		{
+			thread_yield();
+		}
+	}
+}
+
+
+static void _hashtable32_resize( hashtable32_t* table, hashtable32_store_t* store )
+{
+	if( ( table->store == store ) && atomic_cas32( &table->resizing, 1, 0 ) )
+	{
+		if( table->store == store )
+		{
+			//Let writers already operating on the store finish, new writers wait and help migrate
+			hashtable32_store_t* next;
+			while( table->writers )
+				thread_yield();
+
+			//Size for twice the live entries, dropping erased keys. Grows a store full of live
+			//entries and compacts a store where most keys have been erased
+			next = _hashtable32_store_allocate( ( (uint64_t)table->count + 1 ) * 2 * HASHTABLE_LOAD_DENOMINATOR / HASHTABLE_LOAD_NUMERATOR );
+			atomic_cas_ptr( (void* volatile*)&store->next, next, 0 );
+		}
+		else
+		{
+			atomic_cas32( &table->resizing, 0, 1 );
+		}
+	}
+	_hashtable32_migrate( table );
+}
+
+
+static FORCEINLINE hashtable32_store_t* _hashtable32_enter( hashtable32_t* table )
+{
+	atomic_incr32( &table->writers );
+	if( !table->resizing )
+		return table->store;
+	atomic_decr32( &table->writers );
+	_hashtable32_migrate( table );
+	return 0;
+}
+
+
+static FORCEINLINE void _hashtable32_leave( hashtable32_t* table )
+{
+	atomic_decr32( &table->writers );
+}
+
+
 hashtable32_t* hashtable32_allocate( unsigned int buckets )
 {
-	hashtable32_t* table = (hashtable32_t*)memory_allocate_zero( sizeof( hashtable32_t ) + sizeof( hashtable32_entry_t ) * buckets, 8, MEMORY_PERSISTENT );
-	table->capacity = buckets;
+	hashtable32_t* table = (hashtable32_t*)memory_allocate_zero( sizeof( hashtable32_t ), 64, MEMORY_PERSISTENT );
+	table->store = _hashtable32_store_allocate( buckets );
 	return table;
 }
 
 
 void hashtable32_deallocate( hashtable32_t* table )
 {
+	memory_deallocate( table->store );
 	memory_deallocate( table );
 }
 
 
 void hashtable32_set( hashtable32_t* table, uint32_t key, uint32_t value )
 {
-	uint32_t ie, eend;
-
 	FOUNDATION_ASSERT( table );
 	FOUNDATION_ASSERT( key );
 	FOUNDATION_ASSERT( value );
 
-	ie = eend = _hashtable32_hash( key ) % table->capacity;
 	do
 	{
-		uint32_t current_key = table->entries[ie].key;
+		hashtable32_entry_t* entry;
+		hashtable32_store_t* store = _hashtable32_enter( table );
+		if( !store )
+			continue;
 
-		if( current_key != key )
-		{
-			if( current_key || !atomic_cas32( (int32_t*)&table->entries[ie].key, key, 0 ) )
-			{
-				ie = ( ie + 1 ) % table->capacity;
-				if( ie == eend )
-				{
-					FOUNDATION_ASSERT( "Hashtable set looped, out-out-memory" );
-					//Keep looping until slot frees up
-					thread_yield();
-				}
-				continue;
-			}
-		}
+		entry = _hashtable32_claim( store, key );
+		if( entry && !_hashtable32_exchange( entry, value ) )
+			atomic_incr32( &table->count );
 
-		table->entries[ie].value = value;
-		break;
+		_hashtable32_leave( table );
+
+		if( entry )
+			break;
+
+		_hashtable32_resize( table, store );
 	} while( true );
 }
 
 
 void hashtable32_erase( hashtable32_t* table, uint32_t key )
 {
-	uint32_t ie, eend;
+	hashtable32_entry_t* entry;
+	hashtable32_store_t* store;
 
 	FOUNDATION_ASSERT( table );
 	FOUNDATION_ASSERT( key );
-	
-	ie = eend = _hashtable32_hash( key ) % table->capacity;
-	do
-	{
-		uint32_t current_key = table->entries[ie].key;
 
-		if( current_key == key )
-		{
-			table->entries[ie].value = 0;
-			return;
-		}
+	while( !( store = _hashtable32_enter( table ) ) )
+		continue;
 
-		if( !current_key )
-			return;
+	entry = _hashtable32_find( store, key, _hashtable32_hash( key ) & ( store->capacity - 1 ) );
+	if( entry && _hashtable32_exchange( entry, 0 ) )
+		atomic_decr32( &table->count );
 
-		ie = ( ie + 1 ) % table->capacity;
-		if( ie == eend )
-		{
-			FOUNDATION_ASSERT( "Hashtable erase looped, not found" );
-			return;
-		}
-	} while( true );
+	_hashtable32_leave( table );
 }
 
 
 uint32_t hashtable32_get( hashtable32_t* table, uint32_t key )
 {
-	uint32_t ie, eend;
+	volatile int32_t* counter;
+	hashtable32_store_t* store;
+	hashtable32_entry_t* entry;
+	uint32_t value;
 
 	FOUNDATION_ASSERT( table );
 	FOUNDATION_ASSERT( key );
-	
-	ie = eend = _hashtable32_hash( key ) % table->capacity;
-	do
+
+	store = _hashtable32_read_begin( table, &counter );
+	entry = _hashtable32_find( store, key, _hashtable32_hash( key ) & ( store->capacity - 1 ) );
+	value = entry ? entry->value : 0;
+	_hashtable32_read_end( counter );
+
+	return value;
+}
+
+
+void hashtable32_get_batch( hashtable32_t* table, const uint32_t* keys, unsigned int num, uint32_t* values )
+{
+	uint32_t slot[HASHTABLE_BATCH_SIZE];
+	unsigned int ikey, ibatch, batch;
+	volatile int32_t* counter;
+	hashtable32_store_t* store;
+
+	FOUNDATION_ASSERT( table );
+
+	store = _hashtable32_read_begin( table, &counter );
+	for( ikey = 0; ikey < num; ikey += batch )
 	{
-		uint32_t current_key = table->entries[ie].key;
+		batch = ( num - ikey < HASHTABLE_BATCH_SIZE ) ? num - ikey : HASHTABLE_BATCH_SIZE;
+		for( ibatch = 0; ibatch < batch; ++ibatch )
+		{
+			FOUNDATION_ASSERT( keys[ikey + ibatch] );
+			slot[ibatch] = _hashtable32_hash( keys[ikey + ibatch] ) & ( store->capacity - 1 );
+			PREFETCH( store->entries + slot[ibatch] );
+		}
+		for( ibatch = 0; ibatch < batch; ++ibatch )
+		{
+			hashtable32_entry_t* entry = _hashtable32_find( store, keys[ikey + ibatch], slot[ibatch] );
+			values[ikey + ibatch] = entry ? entry->value : 0;
+		}
+	}
+	_hashtable32_read_end( counter );
+}
+
+
+uint32_t hashtable32_raw( hashtable32_t* table, uint32_t slot )
+{
+	hashtable32_store_t* store = table->store;
+	if( ( slot >= store->capacity ) || !store->entries[slot].key )
+		return 0;
+	return store->entries[slot].value;
+}
+
+
+uint32_t hashtable32_raw_capacity( hashtable32_t* table )
+{
+	return table->store->capacity;
+}
+
+
+void hashtable32_compact( hashtable32_t* table )
+{
+	FOUNDATION_ASSERT( table );
+	_hashtable32_resize( table, table->store );
+}
+
 
+unsigned int hashtable32_size( hashtable32_t* table )
+{
+	return (unsigned int)table->count;
+}
+
+
+void hashtable32_clear( hashtable32_t* table )
+{
+	hashtable32_store_t* store;
+	FOUNDATION_ASSERT( table );
+	store = table->store;
+	memset( store->entries, 0, sizeof( hashtable32_entry_t ) * (size_t)store->capacity );
+	store->used = 0;
+	table->count = 0;
+}
+
+
+
+static hashtable64_store_t* _hashtable64_store_allocate( uint64_t capacity )
+{
+	hashtable64_store_t* store;
+	uint64_t size = HASHTABLE_MINCAPACITY;
+	while( size < capacity )
+		size <<= 1;
+
+	store = memory_allocate_zero( sizeof( hashtable64_store_t ) + sizeof( hashtable64_entry_t ) * size, 8, MEMORY_PERSISTENT );
+	store->capacity = (uint64_t)size;
+	return store;
+}
+
+
+//Find the slot of the key, claiming a free slot if the key is not stored and the store is below max load.
+//Returns null if the key is not stored and a free slot could not be claimed
+static hashtable64_entry_t* _hashtable64_claim( hashtable64_store_t* store, uint64_t key )
+{
+	uint64_t mask = store->capacity - 1;
+	uint64_t ie = _hashtable64_hash( key ) & mask;
+	uint64_t iprobe;
+	for( iprobe = 0; iprobe < store->capacity; ++iprobe, ie = ( ie + 1 ) & mask )
+	{
+		uint64_t current_key = store->entries[ie].key;
 		if( current_key == key )
-			return table->entries[ie].value;
+			return store->entries + ie;
+		if( !current_key )
+		{
+			if( (uint64_t)store->used * HASHTABLE_LOAD_DENOMINATOR >= (uint64_t)store->capacity * HASHTABLE_LOAD_NUMERATOR )
+				return 0;
+			if( atomic_cas64( (volatile int64_t*)&store->entries[ie].key, key, 0 ) )
+			{
+				atomic_incr32( &store->used );
+				return store->entries + ie;
+			}
+			if( store->entries[ie].key == key )
+				return store->entries + ie;
+		}
+	}
+	return 0;
+}
 
+
+//Store a value and return the previous value
+static FORCEINLINE uint64_t _hashtable64_exchange( hashtable64_entry_t* entry, uint64_t value )
+{
+	uint64_t prev;
+	do
+	{
+		prev = entry->value;
+	} while( !atomic_cas64( (volatile int64_t*)&entry->value, (int64_t)value, (int64_t)prev ) );
+	return prev;
+}
+
+
+static hashtable64_entry_t* _hashtable64_find( hashtable64_store_t* store, uint64_t key, uint64_t ie )
+{
+	uint64_t mask = store->capacity - 1;
+	uint64_t iprobe;
+	for( iprobe = 0; iprobe < store->capacity; ++iprobe, ie = ( ie + 1 ) & mask )
+	{
+		uint64_t current_key = store->entries[ie].key;
+		if( current_key == key )
+			return store->entries + ie;
 		if( !current_key )
 			return 0;
+	}
+	return 0;
+}
 
-		ie = ( ie + 1 ) % table->capacity;
-		if( ie == eend )
-		{
-			FOUNDATION_ASSERT( "Hashtable get looped, not found" );
-			return 0;
-		}
+
+//Enter a read section, the store returned is valid until the section ends
+static FORCEINLINE hashtable64_store_t* _hashtable64_read_begin( hashtable64_t* table, volatile int32_t** counter )
+{
+	hashtable_reader_t* reader = _hashtable_reader( table->reader );
+	do
+	{
+		int32_t parity = table->epoch & 1;
+		*counter = reader->readers + parity;
+		atomic_incr32( *counter );
+		if( ( table->epoch & 1 ) == parity )
+			return table->store;
+		atomic_decr32( *counter );
 	} while( true );
+}
 
-	return 0;
+
+static FORCEINLINE void _hashtable64_read_end( volatile int32_t* counter )
+{
+	atomic_decr32( counter );
 }
 
 
-uint32_t hashtable32_raw( hashtable32_t* table, uint32_t slot )
+static void _hashtable64_migrate( hashtable64_t* table )
 {
-	if( !table->entries[slot].key )
-		return 0;
-	return table->entries[slot].value;
+	while( table->resizing )
+	{
+		volatile int32_t* counter;
+		int32_t parity;
+		hashtable64_store_t* store = _hashtable64_read_begin( table, &counter );
+		hashtable64_store_t* next = store->next;
+		int32_t num_chunks = (int32_t)( ( (uint64_t)store->capacity + HASHTABLE_MIGRATE_CHUNK - 1 ) / HASHTABLE_MIGRATE_CHUNK );
+		int32_t chunk = num_chunks;
+		bool last = false;
+
+		if( next && ( store->chunk_next < num_chunks ) && ( ( chunk = atomic_exchange_and_add32( &store->chunk_next, 1 ) ) < num_chunks ) )
+		{
+			uint64_t ie = (uint64_t)chunk * HASHTABLE_MIGRATE_CHUNK;
+			uint64_t eend = ( store->capacity - ie > HASHTABLE_MIGRATE_CHUNK ) ? ie + HASHTABLE_MIGRATE_CHUNK : store->capacity;
+			for( ; ie < eend; ++ie )
+			{
+				if( store->entries[ie].key && store->entries[ie].value )
+					_hashtable64_claim( next, store->entries[ie].key )->value = store->entries[ie].value;
+			}
+			last = ( atomic_incr32( &store->chunk_done ) == num_chunks );
+		}
+
+		_hashtable64_read_end( counter );
+
+		if( last )
+		{
+			//Last chunk copied, publish the new store. Flip the reader epoch and free the old store once
+			//readers that might have loaded it are done, then let writers back in
+			atomic_cas_ptr( (void* volatile*)&table->store, next, store );
+			parity = table->epoch & 1;
+			atomic_incr32( &table->epoch );
+			_hashtable_readers_wait( table->reader, parity );
+			memory_deallocate( store );
+			atomic_cas32( &table->resizing, 0, 1 );
+		}
+		else if( chunk >= num_chunks )
+		{
+			thread_yield();
+		}
+	}
 }
 
 
-unsigned int hashtable32_size( hashtable32_t* table )
+static void _hashtable64_resize( hashtable64_t* table, hashtable64_store_t* store )
 {
-	unsigned int count = 0;
-	unsigned int ie;
-	for( ie = 0; ie < table->capacity; ++ie )
+	if( ( table->store == store ) && atomic_cas32( &table->resizing, 1, 0 ) )
 	{
-		if( table->entries[ie].key && table->entries[ie].value )
-			++count;
+		if( table->store == store )
+		{
+			//Let writers already operating on the store finish, new writers wait and help migrate
+			hashtable64_store_t* next;
+			while( table->writers )
+				thread_yield();
+
+			//Size for twice the live entries, dropping erased keys. Grows a store full of live
+			//entries and compacts a store where most keys have been erased
+			next = _hashtable64_store_allocate( ( (uint64_t)table->count + 1 ) * 2 * HASHTABLE_LOAD_DENOMINATOR / HASHTABLE_LOAD_NUMERATOR );
+			atomic_cas_ptr( (void* volatile*)&store->next, next, 0 );
+		}
+		else
+		{
+			atomic_cas32( &table->resizing, 0, 1 );
+		}
 	}
-	return count;
+	_hashtable64_migrate( table );
 }
 
 
-void hashtable32_clear( hashtable32_t* table )
+static FORCEINLINE hashtable64_store_t* _hashtable64_enter( hashtable64_t* table )
 {
-	FOUNDATION_ASSERT( table );
-	memset( table->entries, 0, sizeof( hashtable32_entry_t ) * table->capacity );
+	atomic_incr32( &table->writers );
+	if( !table->resizing )
+		return table->store;
+	atomic_decr32( &table->writers );
+	_hashtable64_migrate( table );
+	return 0;
 }
 
 
+static FORCEINLINE void _hashtable64_leave( hashtable64_t* table )
+{
+	atomic_decr32( &table->writers );
+}
+
 
 hashtable64_t* hashtable64_allocate( unsigned int buckets )
 {
-	hashtable64_t* table = (hashtable64_t*)memory_allocate_zero( sizeof( hashtable64_t ) + sizeof( hashtable64_entry_t ) * buckets, 8, MEMORY_PERSISTENT );
-	table->capacity = buckets;
+	hashtable64_t* table = (hashtable64_t*)memory_allocate_zero( sizeof( hashtable64_t ), 64, MEMORY_PERSISTENT );
+	table->store = _hashtable64_store_allocate( buckets );
 	return table;
 }
 
 
 void hashtable64_deallocate( hashtable64_t* table )
 {
+	memory_deallocate( table->store );
 	memory_deallocate( table );
 }
 
 
 void hashtable64_set( hashtable64_t* table, uint64_t key, uint64_t value )
 {
-	uint64_t ie, eend;
-
 	FOUNDATION_ASSERT( table );
 	FOUNDATION_ASSERT( key );
 	FOUNDATION_ASSERT( value );
 
-	ie = eend = _hashtable64_hash( key ) % table->capacity;
 	do
 	{
-		uint64_t current_key = table->entries[ie].key;
+		hashtable64_entry_t* entry;
+		hashtable64_store_t* store = _hashtable64_enter( table );
+		if( !store )
+			continue;
 
-		if( current_key != key )
-		{
-			if( current_key || !atomic_cas64( (int64_t*)&table->entries[ie].key, key, 0 ) )
-			{
-				ie = ( ie + 1 ) % table->capacity;
-				if( ie == eend )
-				{
-					FOUNDATION_ASSERT( "Hashtable set looped, out-out-memory" );
-					//Keep looping until slot frees up
-					thread_yield();
-				}
-				continue;
-			}
-		}
+		entry = _hashtable64_claim( store, key );
+		if( entry && !_hashtable64_exchange( entry, value ) )
+			atomic_incr32( &table->count );
+
+		_hashtable64_leave( table );
 
-		table->entries[ie].value = value;
-		break;
+		if( entry )
+			break;
+
+		_hashtable64_resize( table, store );
 	} while( true );
 }
 
 
 void hashtable64_erase( hashtable64_t* table, uint64_t key )
 {
-	uint64_t ie, eend;
+	hashtable64_entry_t* entry;
+	hashtable64_store_t* store;
 
 	FOUNDATION_ASSERT( table );
 	FOUNDATION_ASSERT( key );
-	
-	ie = eend = _hashtable64_hash( key ) % table->capacity;
-	do
-	{
-		uint64_t current_key = table->entries[ie].key;
 
-		if( current_key == key )
-		{
-			table->entries[ie].value = 0;
-			return;
-		}
+	while( !( store = _hashtable64_enter( table ) ) )
+		continue;
 
-		if( !current_key )
-			return;
+	entry = _hashtable64_find( store, key, _hashtable64_hash( key ) & ( store->capacity - 1 ) );
+	if( entry && _hashtable64_exchange( entry, 0 ) )
+		atomic_decr32( &table->count );
 
-		ie = ( ie + 1 ) % table->capacity;
-		if( ie == eend )
-		{
-			FOUNDATION_ASSERT( "Hashtable erase looped, not found" );
-			return;
-		}
-	} while( true );
+	_hashtable64_leave( table );
 }
 
 
 uint64_t hashtable64_get( hashtable64_t* table, uint64_t key )
 {
-	uint64_t ie, eend;
+	volatile int32_t* counter;
+	hashtable64_store_t* store;
+	hashtable64_entry_t* entry;
+	uint64_t value;
 
 	FOUNDATION_ASSERT( table );
 	FOUNDATION_ASSERT( key );
-	
-	ie = eend = _hashtable64_hash( key ) % table->capacity;
-	do
-	{
-		uint64_t current_key = table->entries[ie].key;
 
-		if( current_key == key )
-			return table->entries[ie].value;
+	store = _hashtable64_read_begin( table, &counter );
+	entry = _hashtable64_find( store, key, _hashtable64_hash( key ) & ( store->capacity - 1 ) );
+	value = entry ? entry->value : 0;
+	_hashtable64_read_end( counter );
 
-		if( !current_key )
-			return 0;
+	return value;
+}
+
+
+void hashtable64_get_batch( hashtable64_t* table, const uint64_t* keys, unsigned int num, uint64_t* values )
+{
+	uint64_t slot[HASHTABLE_BATCH_SIZE];
+	unsigned int ikey, ibatch, batch;
+	volatile int32_t* counter;
+	hashtable64_store_t* store;
 
-		ie = ( ie + 1 ) % table->capacity;
-		if( ie == eend )
+	FOUNDATION_ASSERT( table );
+
+	store = _hashtable64_read_begin( table, &counter );
+	for( ikey = 0; ikey < num; ikey += batch )
+	{
+		batch = ( num - ikey < HASHTABLE_BATCH_SIZE ) ? num - ikey : HASHTABLE_BATCH_SIZE;
+		for( ibatch = 0; ibatch < batch; ++ibatch )
 		{
-			FOUNDATION_ASSERT( "Hashtable get looped, not found" );
-			return 0;
+			FOUNDATION_ASSERT( keys[ikey + ibatch] );
+			slot[ibatch] = _hashtable64_hash( keys[ikey + ibatch] ) & ( store->capacity - 1 );
+			PREFETCH( store->entries + slot[ibatch] );
 		}
-	} while( true );
-
-	return 0;
+		for( ibatch = 0; ibatch < batch; ++ibatch )
+		{
+			hashtable64_entry_t* entry = _hashtable64_find( store, keys[ikey + ibatch], slot[ibatch] );
+			values[ikey + ibatch] = entry ? entry->value : 0;
+		}
+	}
+	_hashtable64_read_end( counter );
 }
 
 
 uint64_t hashtable64_raw( hashtable64_t* table, uint64_t slot )
 {
-	if( !table->entries[slot].key )
+	hashtable64_store_t* store = table->store;
+	if( ( slot >= store->capacity ) || !store->entries[slot].key )
 		return 0;
-	return table->entries[slot].value;
+	return store->entries[slot].value;
+}
+
+
+uint64_t hashtable64_raw_capacity( hashtable64_t* table )
+{
+	return table->store->capacity;
+}
+
+
+void hashtable64_compact( hashtable64_t* table )
+{
+	FOUNDATION_ASSERT( table );
+	_hashtable64_resize( table, table->store );
 }
 
 
 unsigned int hashtable64_size( hashtable64_t* table )
 {
-	unsigned int count = 0;
-	unsigned int ie;
-	for( ie = 0; ie < table->capacity; ++ie )
-	{
-		if( table->entries[ie].key && table->entries[ie].value )
-			++count;
-	}
-	return count;
+	return (unsigned int)table->count;
 }
 
 
 void hashtable64_clear( hashtable64_t* table )
 {
+	hashtable64_store_t* store;
 	FOUNDATION_ASSERT( table );
-	memset( table->entries, 0, sizeof( hashtable64_entry_t ) * (size_t)table->capacity );
+	store = table->store;
+	memset( store->entries, 0, sizeof( hashtable64_entry_t ) * (size_t)store->capacity );
+	store->used = 0;
+	table->count = 0;
 }
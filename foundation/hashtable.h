@@ -13,7 +13,9 @@
 #pragma once
 
 /*! \file hashtable.h
-    Simple lock-free container mapping 32/64-bit keys to values. Fixed size. */
+    Simple lock-free container mapping 32/64-bit keys to values. Zero is not a valid key or value.
+    The table grows when it reaches max load and compacts away erased keys, the initial number of
+    buckets is only a hint */
 
 #include <foundation/platform.h>
 #include <foundation/types.h>
@@ -25,9 +27,13 @@ FOUNDATION_API void                          hashtable32_deallocate( hashtable32
 FOUNDATION_API void                          hashtable32_set( hashtable32_t* table, uint32_t key, uint32_t value );
 FOUNDATION_API void                          hashtable32_erase( hashtable32_t* table, uint32_t key );
 FOUNDATION_API uint32_t                      hashtable32_get( hashtable32_t* table, uint32_t key );
+FOUNDATION_API void                          hashtable32_get_batch( hashtable32_t* table, const uint32_t* keys, unsigned int num, uint32_t* values );
 
 FOUNDATION_API unsigned int                  hashtable32_size( hashtable32_t* table );
 
+//! Copy live entries to a store sized for them, releasing slots of erased keys. Safe to call while other threads use the table
+FOUNDATION_API void                          hashtable32_compact( hashtable32_t* table );
+
 FOUNDATION_API void                          hashtable32_clear( hashtable32_t* table );
 
 
@@ -37,9 +43,13 @@ FOUNDATION_API void                          hashtable64_deallocate( hashtable64
 FOUNDATION_API void                          hashtable64_set( hashtable64_t* table, uint64_t key, uint64_t value );
 FOUNDATION_API void                          hashtable64_erase( hashtable64_t* table, uint64_t key );
 FOUNDATION_API uint64_t                      hashtable64_get( hashtable64_t* table, uint64_t key );
+FOUNDATION_API void                          hashtable64_get_batch( hashtable64_t* table, const uint64_t* keys, unsigned int num, uint64_t* values );
 
 FOUNDATION_API unsigned int                  hashtable64_size( hashtable64_t* table );
 
+//! Copy live entries to a store sized for them, releasing slots of erased keys. Safe to call while other threads use the table
+FOUNDATION_API void                          hashtable64_compact( hashtable64_t* table );
+
 FOUNDATION_API void                          hashtable64_clear( hashtable64_t* table );
 
 
@@ -51,7 +61,9 @@ FOUNDATION_API void                          hashtable64_clear( hashtable64_t* t
 #define hashtable_set           hashtable32_set
 #define hashtable_erase         hashtable32_erase
 #define hashtable_get           hashtable32_get
+#define hashtable_get_batch     hashtable32_get_batch
 #define hashtable_size          hashtable32_size
+#define hashtable_compact       hashtable32_compact
 #define hashtable_clear         hashtable32_clear
 
 #else
@@ -62,7 +74,9 @@ FOUNDATION_API void                          hashtable64_clear( hashtable64_t* t
 #define hashtable_set           hashtable64_set
 #define hashtable_erase         hashtable64_erase
 #define hashtable_get           hashtable64_get
+#define hashtable_get_batch     hashtable64_get_batch
 #define hashtable_size          hashtable64_size
+#define hashtable_compact       hashtable64_compact
 #define hashtable_clear         hashtable64_clear
 
 #endif
@@ -66,6 +66,7 @@ typedef struct _foundation_stream_vtable
 	stream_available_read_fn available_read;
 	stream_deallocate_fn     deallocate;
 	stream_clone_fn          clone;
+	stream_deallocate_fn     release;
 } stream_vtable_t;
 
 #define FOUNDATION_DECLARE_STREAM                     \
@@ -86,6 +87,131 @@ struct ALIGN(8) _foundation_stream
 };
 
 
+//Robin Hood open addressing table shared by hashmap and shardmap. Nodes are stored inline in a
+//power-of-two sized table together with their probe distance, lookups stop as soon as they reach a
+//node closer to its home slot than the searched key would be. Erase shifts following nodes back
+//instead of leaving tombstones
+#define ROBINHOOD_MINCAPACITY        16
+#define ROBINHOOD_MAXCAPACITY        0x80000000U
+#define ROBINHOOD_LOAD_NUMERATOR     7
+#define ROBINHOOD_LOAD_DENOMINATOR   8
+
+typedef struct _foundation_robinhood_node
+{
+	hash_t                  key;
+	void*                   value;
+	unsigned int            probe; //Distance from home slot plus one, zero if slot is empty
+} robinhood_node_t;
+
+typedef struct _foundation_robinhood_table
+{
+	unsigned int            capacity;
+	unsigned int            shift;
+	robinhood_node_t*       node;
+} robinhood_table_t;
+
+static FORCEINLINE unsigned int _robinhood_bits( unsigned int capacity )
+{
+	unsigned int bits = 0;
+	while( ( 1U << bits ) < capacity )
+		++bits;
+	return bits;
+}
+
+static FORCEINLINE void _robinhood_initialize( robinhood_table_t* table, unsigned int bits, robinhood_node_t* node )
+{
+	table->capacity = 1U << bits;
+	table->shift = 64 - bits;
+	table->node = node;
+}
+
+static FORCEINLINE unsigned int _robinhood_home( const robinhood_table_t* table, hash_t key )
+{
+	//Fibonacci hashing, spreads keys with poor low bits (pointers, counters) over the table
+	return (unsigned int)( ( key * 0x9E3779B97F4A7C15ULL ) >> table->shift );
+}
+
+static FORCEINLINE bool _robinhood_need_grow( const robinhood_table_t* table, unsigned int num_nodes )
+{
+	return ( ( (uint64_t)num_nodes + 1 ) * ROBINHOOD_LOAD_DENOMINATOR > (uint64_t)table->capacity * ROBINHOOD_LOAD_NUMERATOR ) && ( table->capacity < ROBINHOOD_MAXCAPACITY );
+}
+
+static FORCEINLINE void _robinhood_place( robinhood_table_t* table, hash_t key, void* value )
+{
+	unsigned int mask = table->capacity - 1;
+	unsigned int slot = _robinhood_home( table, key );
+	robinhood_node_t carry;
+
+	carry.key = key;
+	carry.value = value;
+	carry.probe = 1;
+
+	for( ;; slot = ( slot + 1 ) & mask, ++carry.probe )
+	{
+		robinhood_node_t* node = table->node + slot;
+		if( !node->probe )
+		{
+			*node = carry;
+			return;
+		}
+		if( node->probe < carry.probe )
+		{
+			//Take the slot from the node closer to its home and continue placing that node
+			robinhood_node_t swap = *node;
+			*node = carry;
+			carry = swap;
+		}
+	}
+}
+
+static FORCEINLINE void _robinhood_rehash( robinhood_table_t* table, const robinhood_table_t* source )
+{
+	unsigned int inode;
+	for( inode = 0; inode < source->capacity; ++inode )
+	{
+		if( source->node[inode].probe )
+			_robinhood_place( table, source->node[inode].key, source->node[inode].value );
+	}
+}
+
+static FORCEINLINE robinhood_node_t* _robinhood_find_from( const robinhood_table_t* table, hash_t key, unsigned int slot )
+{
+	//Probe count is bounded by capacity, a shardmap reader racing a writer may see a table in any state
+	unsigned int mask = table->capacity - 1;
+	unsigned int probe;
+
+	for( probe = 1; probe <= table->capacity; slot = ( slot + 1 ) & mask, ++probe )
+	{
+		robinhood_node_t* node = table->node + slot;
+		if( node->probe < probe )
+			return 0;
+		if( node->key == key )
+			return node;
+	}
+	return 0;
+}
+
+static FORCEINLINE robinhood_node_t* _robinhood_find( const robinhood_table_t* table, hash_t key )
+{
+	return _robinhood_find_from( table, key, _robinhood_home( table, key ) );
+}
+
+static FORCEINLINE void _robinhood_erase( robinhood_table_t* table, robinhood_node_t* node )
+{
+	//Backward shift following nodes that are displaced from their home slot
+	unsigned int mask = table->capacity - 1;
+	unsigned int slot = (unsigned int)( node - table->node );
+	unsigned int next;
+
+	for( next = ( slot + 1 ) & mask; table->node[next].probe > 1; slot = next, next = ( next + 1 ) & mask )
+	{
+		table->node[slot] = table->node[next];
+		--table->node[slot].probe;
+	}
+	table->node[slot].probe = 0;
+}
+
+
 //Internal entry points
 
 FOUNDATION_API void _stream_initialize( stream_t* stream, byteorder_t order );
@@ -104,6 +230,8 @@ FOUNDATION_API int _memory_initialize( const memory_system_t memory );
 FOUNDATION_API void _memory_preallocate( void );
 FOUNDATION_API void _memory_shutdown( void );
 
+FOUNDATION_API void _mempool_shutdown( void );
+
 FOUNDATION_API int _time_initialize( void );
 FOUNDATION_API void _time_shutdown( void );
 
@@ -140,3 +268,5 @@ FOUNDATION_API void foundation_startup( void );
 
 FOUNDATION_API uint32_t      hashtable32_raw( hashtable32_t* table, uint32_t key );
 FOUNDATION_API uint64_t      hashtable64_raw( hashtable64_t* table, uint64_t key );
+FOUNDATION_API uint32_t      hashtable32_raw_capacity( hashtable32_t* table );
+FOUNDATION_API uint64_t      hashtable64_raw_capacity( hashtable64_t* table );
@@ -19,6 +19,21 @@
 #if FOUNDATION_PLATFORM_POSIX
 #  include <foundation/posix.h>
 #  include <sys/mman.h>
+#  ifndef MAP_UNINITIALIZED
+#    define MAP_UNINITIALIZED 0
+#  endif
+#  ifndef MAP_ANONYMOUS
+#    define MAP_ANONYMOUS MAP_ANON
+#  endif
+#  ifndef MAP_32BIT
+#    define MAP_32BIT 0
+#  endif
+#  ifndef MAP_HUGETLB
+#    define MAP_HUGETLB 0
+#  endif
+#  ifndef MAP_NORESERVE
+#    define MAP_NORESERVE 0
+#  endif
 #endif
 
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
@@ -37,12 +52,38 @@ typedef ALIGN(8) struct
 	void*               tail;
 	uint64_t            size;
 	uint64_t            maxchunk;
+	volatile int64_t    wraps;
 } atomic_linear_memory_t;
 
+typedef struct
+{
+	void*               storage;
+	void*               end;
+	void*               head;
+	volatile int32_t    used;
+	uint64_t            wraps;
+} thread_linear_memory_t;
+
 static atomic_linear_memory_t _memory_temporary = {0};
 
+static uint64_t               _memory_map_threshold = BUILD_SIZE_MEMORY_MAP_THRESHOLD;
 
-#if BUILD_ENABLE_MEMORY_TRACKER
+static thread_linear_memory_t _memory_temporary_thread[BUILD_SIZE_TEMPORARY_THREAD_ARENAS];
+static volatile int32_t       _memory_temporary_thread_lock = 0;
+static void*                  _memory_temporary_thread_base = 0;
+static void*                  _memory_temporary_thread_end = 0;
+
+//Marks a thread which could not get an arena of its own and uses the shared ring buffer
+#define MEMORY_TEMPORARY_SHARED ((thread_linear_memory_t*)(uintptr_t)1)
+
+FOUNDATION_DECLARE_THREAD_LOCAL( thread_linear_memory_t*, memory_temporary, 0 )
+
+
+#if BUILD_ENABLE_MEMORY_SAMPLING
+static uint64_t         _memory_sample_interval = BUILD_SIZE_MEMORY_SAMPLE_INTERVAL;
+#endif
+
+#if BUILD_ENABLE_MEMORY_TRACKER || BUILD_ENABLE_MEMORY_SAMPLING
 static memory_tracker_t _memory_tracker = {0};
 static void _memory_track( void* addr, uint64_t size );
 static void _memory_untrack( void* addr );
@@ -54,29 +95,84 @@ static void _memory_report( void );
 #endif
 
 
+#if BUILD_ENABLE_MEMORY_STATISTICS
+static unsigned int _memory_statistics_header_size( unsigned int align );
+static void* _memory_statistics_store( void* raw, unsigned int header, uint16_t context, uint64_t size );
+static void* _memory_statistics_release( void* p, uint16_t* context );
+static void* _memory_statistics_reallocate( void* p, uint64_t size, unsigned int align, uint64_t oldsize );
+static void _memory_statistics_deallocate( void* p );
+static void _memory_statistics_shutdown( void );
+static void _memory_statistics_thread_release( void );
+static bool _memory_budget_reserve( uint16_t context, uint64_t size );
+#else
+#define _memory_statistics_header_size( align ) 0
+#define _memory_statistics_store( raw, header, context, size ) (raw)
+#define _memory_statistics_release( p, context ) ( (void)(context), (p) )
+#define _memory_statistics_reallocate( p, size, align, oldsize ) _memsys.reallocate( (p), (size), (align), (oldsize) )
+#define _memory_statistics_deallocate( p ) _memsys.deallocate( (p) )
+#define _memory_statistics_shutdown() do {} while(0)
+#define _memory_statistics_thread_release() do {} while(0)
+#define _memory_budget_reserve( context, size ) true
+#endif
+
+
 #if FOUNDATION_PLATFORM_ANDROID
-#  define FOUNDATION_MAX_ALIGN  8
+#  define FOUNDATION_MIN_ALIGN  8
 #else
-#  define FOUNDATION_MAX_ALIGN  16
+#  define FOUNDATION_MIN_ALIGN  FOUNDATION_PLATFORM_POINTER_SIZE
 #endif
+#define FOUNDATION_MAX_ALIGN    4096
+
+//Allocations with MEMORY_PERSISTENT_HUGEPAGE hint smaller than a huge page are treated as MEMORY_PERSISTENT
+#define MEMORY_HUGEPAGE_SIZE    ( 2 * 1024 * 1024 )
+
+
+static FORCEINLINE void _memory_spin_lock( volatile int32_t* lock )
+{
+	while( !atomic_cas32( lock, 1, 0 ) )
+		thread_yield();
+}
+
+
+static FORCEINLINE void _memory_spin_unlock( volatile int32_t* lock )
+{
+	atomic_cas32( lock, 0, 1 );
+}
 
 
 static void _atomic_allocate_initialize( uint64_t storagesize )
 {
 	if( storagesize < 1024 )
 		storagesize = BUILD_SIZE_TEMPORARY_MEMORY;
-	_memory_temporary.storage   = memory_allocate( storagesize, FOUNDATION_PLATFORM_POINTER_SIZE, MEMORY_PERSISTENT );
+	_memory_temporary.storage   = _memsys.allocate( MEMORYCONTEXT_GLOBAL, storagesize, FOUNDATION_PLATFORM_POINTER_SIZE, MEMORY_PERSISTENT );
 	_memory_temporary.end       = pointer_offset( _memory_temporary.storage, storagesize );
 	_memory_temporary.head      = _memory_temporary.storage;
 	_memory_temporary.size      = storagesize;
 	_memory_temporary.maxchunk  = ( storagesize / 8 );
+
+	//Thread arenas are slices of a single reservation, committed on first use, so a range check
+	//identifies temporary blocks. Without a reservation all threads use the shared ring buffer
+	_memory_temporary_thread_base = memory_reserve_virtual( storagesize * BUILD_SIZE_TEMPORARY_THREAD_ARENAS );
+	_memory_temporary_thread_end  = _memory_temporary_thread_base ? pointer_offset( _memory_temporary_thread_base, storagesize * BUILD_SIZE_TEMPORARY_THREAD_ARENAS ) : 0;
 }
 
 
 static void _atomic_allocate_shutdown( void )
 {
+	uint64_t wraps = memory_temporary_wraps();
+
+	if( wraps )
+		log_debugf( 0, "Temporary memory wrapped %llu times, consider increasing temporary memory size (%llu bytes)", wraps, _memory_temporary.size );
+
+	set_thread_memory_temporary( 0 );
+	if( _memory_temporary_thread_base )
+		memory_release_virtual( _memory_temporary_thread_base, pointer_diff( _memory_temporary_thread_end, _memory_temporary_thread_base ) );
+	memset( _memory_temporary_thread, 0, sizeof( _memory_temporary_thread ) );
+	_memory_temporary_thread_base = 0;
+	_memory_temporary_thread_end = 0;
+
 	if( _memory_temporary.storage )
-		memory_deallocate( _memory_temporary.storage );
+		_memsys.deallocate( _memory_temporary.storage );
 	memset( &_memory_temporary, 0, sizeof( _memory_temporary ) );
 }
 
@@ -86,6 +182,7 @@ static void* _atomic_allocate_linear( uint64_t chunksize )
 	void* old_head;
 	void* new_head;
 	void* return_pointer = 0;
+	bool wrapped;
 
 	do
 	{
@@ -93,28 +190,130 @@ static void* _atomic_allocate_linear( uint64_t chunksize )
 		new_head = pointer_offset( old_head, chunksize );
 
 		return_pointer = old_head;
+		wrapped = false;
 
 		if( new_head > _memory_temporary.end )
 		{
 			new_head = pointer_offset( _memory_temporary.storage, chunksize );
 			return_pointer = _memory_temporary.storage;
+			wrapped = true;
 		}
 	} while( !atomic_cas_ptr( &_memory_temporary.head, new_head, old_head ) );
+
+	if( wrapped )
+		atomic_incr64( &_memory_temporary.wraps );
 	
 	return return_pointer;
 }
 
 
+static thread_linear_memory_t* _thread_allocate_arena( void )
+{
+	thread_linear_memory_t* arena = get_thread_memory_temporary();
+	unsigned int iarena;
+
+	if( arena )
+		return ( arena != MEMORY_TEMPORARY_SHARED ) ? arena : 0;
+
+	//Temporary allocations made while committing, like logging a failure, go to the shared ring buffer
+	set_thread_memory_temporary( MEMORY_TEMPORARY_SHARED );
+	if( !_memory_temporary_thread_base )
+		return 0;
+
+	//Reuse an arena released by a terminated thread, or commit a new one in the first unused slot
+	_memory_spin_lock( &_memory_temporary_thread_lock );
+	for( iarena = 0; iarena < BUILD_SIZE_TEMPORARY_THREAD_ARENAS; ++iarena )
+	{
+		if( !_memory_temporary_thread[iarena].used )
+		{
+			arena = _memory_temporary_thread + iarena;
+			break;
+		}
+	}
+	if( arena && !arena->storage )
+	{
+		void* storage = pointer_offset( _memory_temporary_thread_base, _memory_temporary.size * iarena );
+		if( memory_commit( storage, _memory_temporary.size ) )
+		{
+			arena->storage = storage;
+			arena->end = pointer_offset( storage, _memory_temporary.size );
+			arena->head = storage;
+		}
+		else
+		{
+			arena = 0;
+		}
+	}
+	if( arena )
+		arena->used = 1;
+	_memory_spin_unlock( &_memory_temporary_thread_lock );
+
+	set_thread_memory_temporary( arena ? arena : MEMORY_TEMPORARY_SHARED );
+
+	return arena;
+}
+
+
+static void _thread_release_arena( void )
+{
+	thread_linear_memory_t* arena = get_thread_memory_temporary();
+	if( arena && ( arena != MEMORY_TEMPORARY_SHARED ) )
+	{
+		arena->head = arena->storage;
+		atomic_cas32( &arena->used, 0, 1 );
+	}
+	set_thread_memory_temporary( 0 );
+}
+
+
+static FORCEINLINE void* _memory_allocate_linear( void** head, const void* end, uint64_t chunksize )
+{
+	void* return_pointer = *head;
+	void* new_head = pointer_offset( return_pointer, chunksize );
+
+	if( new_head > end )
+		return 0;
+	*head = new_head;
+
+	return return_pointer;
+}
+
+
+static FORCEINLINE void* _thread_allocate_linear( thread_linear_memory_t* arena, uint64_t chunksize )
+{
+	void* return_pointer = _memory_allocate_linear( &arena->head, arena->end, chunksize );
+
+	if( !return_pointer )
+	{
+		return_pointer = arena->storage;
+		arena->head = pointer_offset( return_pointer, chunksize );
+		++arena->wraps;
+	}
+
+	return return_pointer;
+}
+
+
+static void* _memory_allocate_temporary( uint64_t chunksize )
+{
+	thread_linear_memory_t* arena = _thread_allocate_arena();
+	return arena ? _thread_allocate_linear( arena, chunksize ) : _atomic_allocate_linear( chunksize );
+}
+
+
+static FORCEINLINE bool _memory_is_temporary( const void* p )
+{
+	return ( ( p >= _memory_temporary.storage ) && ( p < _memory_temporary.end ) ) ||
+	       ( ( p >= _memory_temporary_thread_base ) && ( p < _memory_temporary_thread_end ) );
+}
+
+
 static CONSTCALL FORCEINLINE unsigned int _memory_get_align( unsigned int align )
 {
-#if FOUNDATION_PLATFORM_ANDROID
-	return align ? FOUNDATION_MAX_ALIGN : 0;
-#else
-	if( align < FOUNDATION_PLATFORM_POINTER_SIZE )
-		return align ? FOUNDATION_PLATFORM_POINTER_SIZE : 0;
+	if( align < FOUNDATION_MIN_ALIGN )
+		return align ? FOUNDATION_MIN_ALIGN : 0;
 	align = math_align_poweroftwo( align );
 	return ( align < FOUNDATION_MAX_ALIGN ) ? align : FOUNDATION_MAX_ALIGN;
-#endif
 }
 
 
@@ -149,18 +348,35 @@ void _memory_preallocate( void )
 	if( !_memory_temporary.storage )
 		_atomic_allocate_initialize( config_int( HASH_FOUNDATION, HASH_TEMPORARY_MEMORY ) );
 
+	if( config_int( HASH_FOUNDATION, HASH_MEMORY_MAP_THRESHOLD ) > 0 )
+		_memory_map_threshold = (uint64_t)config_int( HASH_FOUNDATION, HASH_MEMORY_MAP_THRESHOLD );
+
+	if( ( config_int( HASH_FOUNDATION, HASH_MEMORY_BUDGET_SOFT ) > 0 ) || ( config_int( HASH_FOUNDATION, HASH_MEMORY_BUDGET_HARD ) > 0 ) )
+		memory_set_budget( MEMORYCONTEXT_GLOBAL, (uint64_t)config_int( HASH_FOUNDATION, HASH_MEMORY_BUDGET_SOFT ), (uint64_t)config_int( HASH_FOUNDATION, HASH_MEMORY_BUDGET_HARD ) );
+
+#if BUILD_ENABLE_MEMORY_SAMPLING
+	if( config_int( HASH_FOUNDATION, HASH_MEMORY_SAMPLE_INTERVAL ) > 0 )
+		_memory_sample_interval = (uint64_t)config_int( HASH_FOUNDATION, HASH_MEMORY_SAMPLE_INTERVAL );
+#endif
+
 	tracker = config_string_hash( HASH_FOUNDATION, HASH_MEMORY_TRACKER );
 	if( tracker == HASH_LOCAL )
 		memory_set_tracker( memory_tracker_local() );
+	else if( tracker == HASH_SAMPLING )
+		memory_set_tracker( memory_tracker_sampling() );
 }
 
 
 void _memory_shutdown( void )
 {
 	memory_tracker_t no_tracker = {0};
+
+	_mempool_shutdown();
+
 	memory_set_tracker( no_tracker );
 	
 	_atomic_allocate_shutdown();
+	_memory_statistics_shutdown();
 	_memsys.shutdown();
 }
 
@@ -171,11 +387,15 @@ void* memory_allocate( uint64_t size, unsigned int align, memory_hint_t hint )
 	if( ( hint == MEMORY_TEMPORARY ) && _memory_temporary.storage && ( size + align < _memory_temporary.maxchunk ) )
 	{
 		align = _memory_get_align( align );
-		p = _memory_align_pointer( _atomic_allocate_linear( size + align ), align );
+		p = _memory_align_pointer( _memory_allocate_temporary( size + align ), align );
 	}
 	else
-	{		
-		p = _memsys.allocate( memory_context(), size, align, hint );
+	{
+		uint16_t context = memory_context();
+		unsigned int header = _memory_statistics_header_size( align );
+		if( !_memory_budget_reserve( context, size ) )
+			return 0;
+		p = _memory_statistics_store( _memsys.allocate( context, size + header, align, hint ), header, context, size );
 	}
 	_memory_track( p, size );
 	return p;
@@ -188,12 +408,16 @@ void* memory_allocate_zero( uint64_t size, unsigned int align, memory_hint_t hin
 	if( ( hint == MEMORY_TEMPORARY ) && _memory_temporary.storage && ( size + align < _memory_temporary.maxchunk ) )
 	{
 		align = _memory_get_align( align );
-		p = _memory_align_pointer( _atomic_allocate_linear( size + align ), align );
+		p = _memory_align_pointer( _memory_allocate_temporary( size + align ), align );
 		memset( p, 0, (size_t)size );
 	}
 	else
 	{
-		p = _memsys.allocate_zero( memory_context(), size, align, hint );
+		uint16_t context = memory_context();
+		unsigned int header = _memory_statistics_header_size( align );
+		if( !_memory_budget_reserve( context, size ) )
+			return 0;
+		p = _memory_statistics_store( _memsys.allocate_zero( context, size + header, align, hint ), header, context, size );
 	}
 	_memory_track( p, size );
 	return p;
@@ -202,7 +426,11 @@ void* memory_allocate_zero( uint64_t size, unsigned int align, memory_hint_t hin
 
 void* memory_allocate_context( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
 {
-	void* p = _memsys.allocate( context, size, align, hint );
+	unsigned int header = _memory_statistics_header_size( align );
+	void* p;
+	if( !_memory_budget_reserve( context, size ) )
+		return 0;
+	p = _memory_statistics_store( _memsys.allocate( context, size + header, align, hint ), header, context, size );
 	_memory_track( p, size );
 	return p;
 }
@@ -210,7 +438,11 @@ void* memory_allocate_context( uint16_t context, uint64_t size, unsigned int ali
 
 void* memory_allocate_zero_context( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
 {
-	void* p = _memsys.allocate_zero( context, size, align, hint );
+	unsigned int header = _memory_statistics_header_size( align );
+	void* p;
+	if( !_memory_budget_reserve( context, size ) )
+		return 0;
+	p = _memory_statistics_store( _memsys.allocate_zero( context, size + header, align, hint ), header, context, size );
 	_memory_track( p, size );
 	return p;
 }
@@ -218,317 +450,1862 @@ void* memory_allocate_zero_context( uint16_t context, uint64_t size, unsigned in
 
 void* memory_reallocate( void* p, uint64_t size, unsigned int align, uint64_t oldsize )
 {
-	FOUNDATION_ASSERT_MSG( ( p < _memory_temporary.storage ) || ( p >= _memory_temporary.end ), "Trying to reallocate temporary memory" );
+	void* block;
+	FOUNDATION_ASSERT_MSG( !_memory_is_temporary( p ), "Trying to reallocate temporary memory" );
 	_memory_untrack( p );
-	p = _memsys.reallocate( p, size, align, oldsize );
-	_memory_track( p, size );
-	return p;
+	block = _memory_statistics_reallocate( p, size, align, oldsize );
+	if( block || !p )
+		_memory_track( block, size );
+	else
+		_memory_track( p, oldsize ); //Failed reallocation leaves the old block live
+	return block;
 }
 
 
 void memory_deallocate( void* p )
 {
-	if( ( p < _memory_temporary.storage ) || ( p >=_memory_temporary.end ) )
-		_memsys.deallocate( p );
+	if( !_memory_is_temporary( p ) )
+		_memory_statistics_deallocate( p );
 	_memory_untrack( p );
 }
 
 
-#if BUILD_ENABLE_MEMORY_CONTEXT
+//Batches are passed to the backend in chunks through a stack buffer of raw block pointers
+#define MEMORY_BATCH_CHUNK 64
 
+unsigned int memory_allocate_batch( unsigned int count, uint64_t size, unsigned int align, memory_hint_t hint, void** ptrs )
+{
+	uint16_t context;
+	unsigned int header, iptr;
 
-FOUNDATION_DECLARE_THREAD_LOCAL( memory_context_t*, memory_context, 0 )
+	if( !_memsys.allocate_batch || ( ( hint == MEMORY_TEMPORARY ) && _memory_temporary.storage && ( size + align < _memory_temporary.maxchunk ) ) )
+	{
+		for( iptr = 0; iptr < count; ++iptr )
+		{
+			ptrs[iptr] = memory_allocate( size, align, hint );
+			if( !ptrs[iptr] )
+				break;
+		}
+		return iptr;
+	}
 
-void memory_context_push( uint16_t context_id )
-{
-	memory_context_t* context = get_thread_memory_context();
-	if( !context )
+	context = memory_context();
+	header = _memory_statistics_header_size( align );
+	if( !_memory_budget_reserve( context, size * count ) )
+		return 0;
+	count = _memsys.allocate_batch( context, size + header, align, hint, ptrs, count );
+	for( iptr = 0; iptr < count; ++iptr )
 	{
-		context = memory_allocate_zero( sizeof( memory_context_t ), 0, MEMORY_PERSISTENT );
-		set_thread_memory_context( context );
+		ptrs[iptr] = _memory_statistics_store( ptrs[iptr], header, context, size );
+		_memory_track( ptrs[iptr], size );
 	}
-	FOUNDATION_ASSERT_MSG( context->depth < BUILD_SIZE_MEMORY_CONTEXT_DEPTH, "Memory context stack overflow" );
-	context->context[ context->depth ] = context_id;
-	if( context->depth < BUILD_SIZE_MEMORY_CONTEXT_DEPTH-1 )
-		++context->depth;
+	return count;
 }
 
 
-void memory_context_pop( void )
+void memory_deallocate_batch( void** ptrs, unsigned int count )
 {
-	memory_context_t* context = get_thread_memory_context();
-	if( context )
+	void* raw[MEMORY_BATCH_CHUNK];
+	unsigned int iptr, num = 0;
+	uint16_t context;
+
+	if( !_memsys.deallocate_batch )
 	{
-		FOUNDATION_ASSERT_MSG( context->depth, "Memory context stack underflow" );
-		--context->depth;
+		for( iptr = 0; iptr < count; ++iptr )
+			memory_deallocate( ptrs[iptr] );
+		return;
 	}
+
+	for( iptr = 0; iptr < count; ++iptr )
+	{
+		void* p = ptrs[iptr];
+		if( !p )
+			continue;
+		_memory_untrack( p );
+		if( _memory_is_temporary( p ) )
+			continue;
+		raw[num++] = _memory_statistics_release( p, &context );
+		if( num == MEMORY_BATCH_CHUNK )
+		{
+			_memsys.deallocate_batch( raw, num );
+			num = 0;
+		}
+	}
+	if( num )
+		_memsys.deallocate_batch( raw, num );
 }
 
 
-uint16_t memory_context( void )
+void memory_thread_deallocate( void )
 {
-	memory_context_t* context = get_thread_memory_context();
-	return ( context && ( context->depth > 0 ) ) ? context->context[ context->depth - 1 ] : MEMORYCONTEXT_GLOBAL;
+	_thread_release_arena();
+	if( _memsys.thread_finalize )
+		_memsys.thread_finalize();
+	_memory_statistics_thread_release();
 }
 
 
-void memory_context_thread_deallocate( void )
+uint64_t memory_temporary_wraps( void )
 {
-	memory_context_t* context = get_thread_memory_context();
-	if( context )
-		memory_deallocate( context );
-	set_thread_memory_context( 0 );
+	uint64_t wraps = (uint64_t)_memory_temporary.wraps;
+	unsigned int iarena;
+	for( iarena = 0; iarena < BUILD_SIZE_TEMPORARY_THREAD_ARENAS; ++iarena )
+		wraps += _memory_temporary_thread[iarena].wraps;
+	return wraps;
 }
 
 
-#endif
-
+typedef struct _foundation_memory_arena_chunk memory_arena_chunk_t;
 
-#if FOUNDATION_PLATFORM_WINDOWS
+struct ALIGN(16) _foundation_memory_arena_chunk
+{
+	memory_arena_chunk_t*   next;
+	void*                   end;
+};
 
-typedef long (*NtAllocateVirtualMemoryFn)( HANDLE, void**, ULONG, size_t*, ULONG, ULONG);
-static NtAllocateVirtualMemoryFn NtAllocateVirtualMemory = 0;
 
-#endif
+void memory_arena_initialize( memory_arena_t* arena, uint64_t chunksize )
+{
+	memset( arena, 0, sizeof( memory_arena_t ) );
+	arena->chunksize = ( chunksize > 1024 ) ? chunksize : 1024;
+}
 
 
-static void* _memory_allocate_malloc_raw( uint64_t size, unsigned int align, memory_hint_t hint )
+void memory_arena_destroy( memory_arena_t* arena )
 {
-	//If we align manually, we must be able to retrieve the original pointer for passing to free()
-	//Thus all allocations need to go through that path
+	memory_arena_chunk_t* chunk = arena->chunk;
+	while( chunk )
+	{
+		memory_arena_chunk_t* next = chunk->next;
+		memory_deallocate( chunk );
+		chunk = next;
+	}
+	memset( arena, 0, sizeof( memory_arena_t ) );
+}
 
-#if FOUNDATION_PLATFORM_WINDOWS
 
-#  if FOUNDATION_PLATFORM_POINTER_SIZE == 4
-	return _aligned_malloc( (size_t)size, align );
-#  else
-	unsigned int padding;
-	size_t allocate_size;
-	char* raw_memory;
-	void* memory;
-	long vmres;
+static bool _memory_arena_advance( memory_arena_t* arena, uint64_t chunksize )
+{
+	memory_arena_chunk_t* current = arena->current;
+	memory_arena_chunk_t* next = current ? current->next : arena->chunk;
 
-	if( hint != MEMORY_PERSISTENT_32BIT_ADDRESS )
+	//Reuse the following chunk if large enough, otherwise insert a new chunk before it
+	if( !next || ( pointer_diff( next->end, next + 1 ) < chunksize ) )
 	{
-		padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE );
-		raw_memory = _aligned_malloc( (size_t)size + padding, align );
-
-		memory = raw_memory + padding; //Will be aligned since padding is multiple of alignment (minimum align/pad is pointer size)
-		*( (void**)memory - 1 ) = raw_memory;
-		FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
-
-		return memory;
+		uint64_t size = sizeof( memory_arena_chunk_t ) + ( ( chunksize > arena->chunksize ) ? chunksize : arena->chunksize );
+		memory_arena_chunk_t* chunk = memory_allocate( size, 16, MEMORY_PERSISTENT );
+		if( !chunk )
+			return false;
+		chunk->end = pointer_offset( chunk, size );
+		chunk->next = next;
+		if( current )
+			current->next = chunk;
+		else
+			arena->chunk = chunk;
+		next = chunk;
 	}
 
-	padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ) ? align : FOUNDATION_PLATFORM_POINTER_SIZE;
-	allocate_size = size + padding + align;
-	raw_memory = 0;
+	arena->current = next;
+	arena->head = next + 1;
+	arena->end = next->end;
+	return true;
+}
 
-	vmres = NtAllocateVirtualMemory( INVALID_HANDLE_VALUE, &raw_memory, 1, &allocate_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
-	if( vmres != 0 )
-		return 0;
-	
-	memory = _memory_align_pointer( raw_memory + padding, align );
-	*( (void**)memory - 1 ) = (void*)( (uintptr_t)raw_memory | 1 );
-	FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
 
-	return memory;
-#  endif	
+void* memory_arena_allocate( memory_arena_t* arena, uint64_t size, unsigned int align )
+{
+	void* block;
 
-#else
-	
-#  if FOUNDATION_PLATFORM_POINTER_SIZE > 4
-	if( hint != MEMORY_PERSISTENT_32BIT_ADDRESS )
-#  endif
+	align = _memory_get_align( align );
+	block = arena->current ? _memory_allocate_linear( &arena->head, arena->end, size + align ) : 0;
+	if( !block )
 	{
-		unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE );
-		char* raw_memory = malloc( (size_t)size + align + padding );
-		void* memory = _memory_align_pointer( raw_memory + padding, align );
-		*( (void**)memory - 1 ) = raw_memory;
-		FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
-		return memory;
+		if( !_memory_arena_advance( arena, size + align ) )
+			return 0;
+		block = _memory_allocate_linear( &arena->head, arena->end, size + align );
 	}
-	
-#  if FOUNDATION_PLATFORM_POINTER_SIZE > 4
 
-	unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE*2 ? align : FOUNDATION_PLATFORM_POINTER_SIZE*2 );
-	size_t allocate_size = size + padding + align;
-	char* raw_memory;
-	void* memory;
+	return _memory_align_pointer( block, align );
+}
 
-	#ifndef MAP_UNINITIALIZED
-	#define MAP_UNINITIALIZED 0
-	#endif
-	
-	#ifndef MAP_ANONYMOUS
-	#define MAP_ANONYMOUS MAP_ANON
-	#endif
-	
-	#ifndef MAP_32BIT
-	#define MAP_32BIT 0
-	#endif
-	
-	raw_memory = mmap( 0, allocate_size, PROT_READ | PROT_WRITE, MAP_32BIT | MAP_PRIVATE | MAP_ANONYMOUS | MAP_UNINITIALIZED, -1, 0 );
-	if( !raw_memory )
-		return 0;
-	
-	memory = _memory_align_pointer( raw_memory + padding, align );
-	*( (uintptr_t*)memory - 1 ) = ( (uintptr_t)raw_memory | 1 );
-	*( (uintptr_t*)memory - 2 ) = allocate_size;
-	FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
 
-	return memory;	
+memory_arena_mark_t memory_arena_mark( const memory_arena_t* arena )
+{
+	memory_arena_mark_t mark;
+	mark.chunk = arena->current;
+	mark.head = arena->head;
+	return mark;
+}
 
-#  endif
-	
-#endif
+
+void memory_arena_reset_to_mark( memory_arena_t* arena, memory_arena_mark_t mark )
+{
+	memory_arena_chunk_t* chunk = mark.chunk;
+	arena->current = chunk;
+	arena->head = mark.head;
+	arena->end = chunk ? chunk->end : 0;
 }
 
 
-static void* _memory_allocate_malloc( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
+void memory_arena_reset( memory_arena_t* arena )
 {
-	align = _memory_get_align( align );
-	return _memory_allocate_malloc_raw( size, align, hint );
+	memory_arena_mark_t mark = {0};
+	memory_arena_reset_to_mark( arena, mark );
 }
 
 
-static void* _memory_allocate_zero_malloc( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
+static uint64_t _memory_page_size = 0;
+
+
+static uint64_t _memory_virtual_page_size( void )
 {
-	void* memory = _memory_allocate_malloc( context, size, align, hint );
-	if( memory )
-		memset( memory, 0, (size_t)size );
-	return memory;
+	if( !_memory_page_size )
+	{
+#if FOUNDATION_PLATFORM_WINDOWS
+		SYSTEM_INFO system_info;
+		GetSystemInfo( &system_info );
+		_memory_page_size = system_info.dwPageSize;
+#else
+		long page_size = sysconf( _SC_PAGESIZE );
+		_memory_page_size = ( page_size > 0 ) ? (uint64_t)page_size : 4096;
+#endif
+	}
+	return _memory_page_size;
 }
 
 
-static void _memory_deallocate_malloc( void* p )
+void* memory_reserve_virtual( uint64_t size )
 {
-#if FOUNDATION_PLATFORM_POINTER_SIZE == 4
+	uint64_t page_size = _memory_virtual_page_size();
+	void* memory;
 
-	if( !p )
-		return;
-#  if FOUNDATION_PLATFORM_WINDOWS
-	_aligned_free( p );
-#  else
-	free( *( (void**)p - 1 ) );
-#  endif
+	size = ( size + page_size - 1 ) & ~( page_size - 1 );
+#if FOUNDATION_PLATFORM_WINDOWS
+	memory = VirtualAlloc( 0, (SIZE_T)size, MEM_RESERVE, PAGE_NOACCESS );
+#else
+	memory = mmap( 0, (size_t)size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+	if( memory == MAP_FAILED )
+		memory = 0;
+#endif
+	if( !memory )
+		log_errorf( 0, ERROR_OUT_OF_MEMORY, "Unable to reserve %llu bytes of virtual memory: %s", size, system_error_message( 0 ) );
+	return memory;
+}
 
+
+bool memory_commit( void* p, uint64_t size )
+{
+	//Commit all pages touched by the range
+	uint64_t page_size = _memory_virtual_page_size();
+	uintptr_t start = (uintptr_t)p & ~(uintptr_t)( page_size - 1 );
+	uintptr_t end = (uintptr_t)( ( (uint64_t)(uintptr_t)p + size + page_size - 1 ) & ~( page_size - 1 ) );
+	bool committed;
+
+	if( !p || !size )
+		return false;
+#if FOUNDATION_PLATFORM_WINDOWS
+	committed = ( VirtualAlloc( (void*)start, (SIZE_T)( end - start ), MEM_COMMIT, PAGE_READWRITE ) != 0 );
 #else
+	committed = ( mprotect( (void*)start, (size_t)( end - start ), PROT_READ | PROT_WRITE ) == 0 );
+#endif
+	if( !committed )
+		log_errorf( 0, ERROR_OUT_OF_MEMORY, "Unable to commit %llu bytes of virtual memory: %s", (uint64_t)( end - start ), system_error_message( 0 ) );
+	return committed;
+}
 
-	uintptr_t raw_ptr;
+
+void memory_decommit( void* p, uint64_t size )
+{
+	//Only decommit pages entirely inside the range, partially covered pages may still hold live data
+	uint64_t page_size = _memory_virtual_page_size();
+	uintptr_t start = (uintptr_t)( ( (uint64_t)(uintptr_t)p + page_size - 1 ) & ~( page_size - 1 ) );
+	uintptr_t end = (uintptr_t)( ( (uint64_t)(uintptr_t)p + size ) & ~( page_size - 1 ) );
+
+	if( !p || ( end <= start ) )
+		return;
+#if FOUNDATION_PLATFORM_WINDOWS
+	VirtualFree( (void*)start, (SIZE_T)( end - start ), MEM_DECOMMIT );
+#else
+	//Mapping fresh inaccessible pages over the range returns the physical pages and commit charge to the system
+	mmap( (void*)start, (size_t)( end - start ), PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+#endif
+}
+
+
+void memory_release_virtual( void* p, uint64_t size )
+{
+	if( !p )
+		return;
+#if FOUNDATION_PLATFORM_WINDOWS
+	(void)sizeof( size );
+	VirtualFree( p, 0, MEM_RELEASE );
+#else
+	munmap( p, (size_t)( ( size + _memory_virtual_page_size() - 1 ) & ~( _memory_virtual_page_size() - 1 ) ) );
+#endif
+}
+
+
+#if BUILD_ENABLE_MEMORY_STATISTICS
+
+//Allocations are prefixed by a header word holding the requested size, the memory context and the
+//header size, which is the alignment (at least 8 bytes) to keep the returned block aligned
+#define MEMORY_STATISTICS_SIZE_BITS     44
+#define MEMORY_STATISTICS_SIZE_MASK     ( ( 1ULL << MEMORY_STATISTICS_SIZE_BITS ) - 1ULL )
+#define MEMORY_STATISTICS_HEADER_SHIFT  60
+
+//Thread local live byte deltas are flushed to the global counter when exceeding this, which bounds the peak error
+#define MEMORY_STATISTICS_FLUSH_LIMIT   ( 64 * 1024 )
+
+#define MEMORY_STATISTICS_OVERFLOW_SLOT ( BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS - 1 )
+
+typedef struct _foundation_memory_statistics_counters
+{
+	uint64_t                          allocations;
+	uint64_t                          deallocations;
+	uint64_t                          allocated;
+	uint64_t                          deallocated;
+	int64_t                           pending;
+	uint64_t                          histogram[BUILD_SIZE_MEMORY_STATISTICS_HISTOGRAM];
+} memory_statistics_counters_t;
+
+//Counters are sharded per thread and only written by the owning thread. Shards are never freed
+//until shutdown, a shard released in memory_thread_deallocate is picked up by the next new thread
+typedef struct ALIGN(64) _foundation_memory_statistics_shard memory_statistics_shard_t;
+
+struct ALIGN(64) _foundation_memory_statistics_shard
+{
+	memory_statistics_counters_t      counters[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+	memory_statistics_shard_t*        next;
+	volatile int32_t                  used;
+};
+
+static volatile int32_t               _memory_statistics_context[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+static volatile int64_t               _memory_statistics_live[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+static volatile int64_t               _memory_statistics_peak[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+static memory_statistics_shard_t*     _memory_statistics_shards = 0;
+static volatile int32_t               _memory_statistics_lock = 0;
+
+FOUNDATION_DECLARE_THREAD_LOCAL( memory_statistics_shard_t*, memory_statistics, 0 )
+
+//Byte budgets per statistics slot, zero means no budget. Pressure levels are evaluated against the global
+//live counter when thread deltas are flushed. Hard budgets are also enforced before each allocation in the
+//budgeted context, using the global live counter plus the delta not yet flushed by the calling thread
+static volatile int64_t               _memory_budget_soft[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+static volatile int64_t               _memory_budget_hard[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+static volatile int32_t               _memory_budget_level[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+static volatile int32_t               _memory_budget_count = 0;
+static volatile int32_t               _memory_budget_hard_count = 0;
+static memory_pressure_fn volatile    _memory_pressure_callback[BUILD_SIZE_MEMORY_PRESSURE_CALLBACKS];
+static volatile int32_t               _memory_pressure_lock = 0;
+
+FOUNDATION_DECLARE_THREAD_LOCAL( int, memory_pressure_busy, 0 )
+
+
+static unsigned int _memory_statistics_slot( uint16_t context, bool insert )
+{
+	//Slots store context + 1 to keep zero as free marker, last slot is shared by contexts not fitting in table.
+	//Lookups without insert return an out of range slot for unknown contexts
+	int32_t key = (int32_t)context + 1;
+	unsigned int islot = context % MEMORY_STATISTICS_OVERFLOW_SLOT;
+	unsigned int iprobe;
+	for( iprobe = 0; iprobe < MEMORY_STATISTICS_OVERFLOW_SLOT; ++iprobe )
+	{
+		int32_t current = _memory_statistics_context[islot];
+		if( current == key )
+			return islot;
+		if( !current )
+		{
+			if( !insert )
+				return BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS;
+			if( atomic_cas32( &_memory_statistics_context[islot], key, 0 ) || ( _memory_statistics_context[islot] == key ) )
+				return islot;
+		}
+		if( ++islot == MEMORY_STATISTICS_OVERFLOW_SLOT )
+			islot = 0;
+	}
+	return MEMORY_STATISTICS_OVERFLOW_SLOT;
+}
+
+
+static memory_statistics_shard_t* _memory_statistics_shard( void )
+{
+	memory_statistics_shard_t* shard = get_thread_memory_statistics();
+	if( shard )
+		return shard;
+
+	for( shard = _memory_statistics_shards; shard; shard = shard->next )
+	{
+		if( !shard->used && atomic_cas32( &shard->used, 1, 0 ) )
+			break;
+	}
+	if( !shard )
+	{
+		shard = _memsys.allocate_zero( MEMORYCONTEXT_GLOBAL, sizeof( memory_statistics_shard_t ), 64, MEMORY_PERSISTENT );
+		if( !shard )
+			return 0;
+		shard->used = 1;
+		_memory_spin_lock( &_memory_statistics_lock );
+		shard->next = _memory_statistics_shards;
+		_memory_statistics_shards = shard;
+		_memory_spin_unlock( &_memory_statistics_lock );
+	}
+	set_thread_memory_statistics( shard );
+	return shard;
+}
+
+
+static void _memory_pressure_notify( uint16_t context, memory_pressure_t level, int64_t live, int64_t budget )
+{
+	//Callbacks may allocate and free memory, which must not trigger nested notifications on this thread
+	unsigned int icb;
+	if( get_thread_memory_pressure_busy() )
+		return;
+	set_thread_memory_pressure_busy( 1 );
+	for( icb = 0; icb < BUILD_SIZE_MEMORY_PRESSURE_CALLBACKS; ++icb )
+	{
+		memory_pressure_fn callback = _memory_pressure_callback[icb];
+		if( callback )
+			callback( context, level, ( live > 0 ) ? (uint64_t)live : 0, (uint64_t)budget );
+	}
+	set_thread_memory_pressure_busy( 0 );
+}
+
+
+static void _memory_budget_update( unsigned int islot, uint16_t context, int64_t live )
+{
+	int64_t soft = _memory_budget_soft[islot];
+	int64_t hard = _memory_budget_hard[islot];
+	int32_t level = MEMORY_PRESSURE_NONE;
+	int32_t prev = _memory_budget_level[islot];
+
+	if( hard && ( live > hard ) )
+		level = MEMORY_PRESSURE_HARD;
+	else if( soft && ( live > soft ) )
+		level = MEMORY_PRESSURE_SOFT;
+
+	//Notify once when crossing into a higher level, dropping back below a budget rearms the notification
+	if( ( level == prev ) || !atomic_cas32( &_memory_budget_level[islot], level, prev ) )
+		return;
+	if( level > prev )
+		_memory_pressure_notify( context, (memory_pressure_t)level, live, ( level == MEMORY_PRESSURE_HARD ) ? hard : soft );
+}
+
+
+static void _memory_statistics_flush( unsigned int islot, uint16_t context, memory_statistics_counters_t* counters )
+{
+	int64_t live = atomic_add64( &_memory_statistics_live[islot], counters->pending );
+	int64_t peak;
+	counters->pending = 0;
+	do
+	{
+		peak = _memory_statistics_peak[islot];
+	} while( ( live > peak ) && !atomic_cas64( &_memory_statistics_peak[islot], live, peak ) );
+
+	if( _memory_budget_count )
+		_memory_budget_update( islot, context, live );
+}
+
+
+static void _memory_statistics_thread_release( void )
+{
+	//Flush pending live deltas, the totals stay in the shard and are summed with those of the next owner
+	memory_statistics_shard_t* shard = get_thread_memory_statistics();
+	unsigned int islot;
+
+	if( !shard )
+		return;
+
+	for( islot = 0; islot < BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS; ++islot )
+	{
+		int32_t key = _memory_statistics_context[islot];
+		if( shard->counters[islot].pending )
+			_memory_statistics_flush( islot, (uint16_t)( key ? key - 1 : 0 ), shard->counters + islot );
+	}
+
+	set_thread_memory_statistics( 0 );
+	atomic_cas32( &shard->used, 0, 1 );
+}
+
+
+static int64_t _memory_budget_live( unsigned int islot )
+{
+	memory_statistics_shard_t* shard = get_thread_memory_statistics();
+	return _memory_statistics_live[islot] + ( shard ? shard->counters[islot].pending : 0 );
+}
+
+
+static bool _memory_budget_reserve( uint16_t context, uint64_t size )
+{
+	unsigned int islot;
+	int64_t hard;
+
+	if( !_memory_budget_hard_count || get_thread_memory_pressure_busy() )
+		return true;
+
+	islot = _memory_statistics_slot( context, false );
+	if( ( islot >= BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS ) || !( hard = _memory_budget_hard[islot] ) )
+		return true;
+	if( _memory_budget_live( islot ) + (int64_t)size <= hard )
+		return true;
+
+	//Give the pressure callbacks a chance to release memory before failing the allocation
+	_memory_pressure_notify( context, MEMORY_PRESSURE_HARD, _memory_budget_live( islot ) + (int64_t)size, hard );
+	if( _memory_budget_live( islot ) + (int64_t)size <= hard )
+		return true;
+
+	_memory_budget_level[islot] = MEMORY_PRESSURE_HARD;
+	set_thread_memory_pressure_busy( 1 );
+	log_errorf( 0, ERROR_OUT_OF_MEMORY, "Memory budget exceeded in context %u: %llu bytes requested with %lld of %lld bytes in use", (unsigned int)context, size, _memory_budget_live( islot ), hard );
+	set_thread_memory_pressure_busy( 0 );
+	return false;
+}
+
+
+static unsigned int _memory_statistics_header_size( unsigned int align )
+{
+	align = _memory_get_align( align );
+	return ( align > 8 ) ? align : 8;
+}
+
+
+static void* _memory_statistics_store( void* raw, unsigned int header, uint16_t context, uint64_t size )
+{
+	memory_statistics_shard_t* shard;
+	memory_statistics_counters_t* counters;
+	unsigned int islot, ibucket, shift;
+	void* p;
+
+	if( !raw )
+		return 0;
+
+	p = pointer_offset( raw, header );
+	for( shift = 3; ( 1U << shift ) < header; ++shift ) {}
+	*( (uint64_t*)p - 1 ) = ( (uint64_t)shift << MEMORY_STATISTICS_HEADER_SHIFT ) | ( (uint64_t)context << MEMORY_STATISTICS_SIZE_BITS ) | ( size & MEMORY_STATISTICS_SIZE_MASK );
+
+	shard = _memory_statistics_shard();
+	if( !shard )
+		return p;
+
+	islot = _memory_statistics_slot( context, true );
+	counters = shard->counters + islot;
+	for( ibucket = 0; ( ibucket < BUILD_SIZE_MEMORY_STATISTICS_HISTOGRAM - 1 ) && ( ( 16ULL << ibucket ) < size ); ++ibucket ) {}
+	++counters->allocations;
+	++counters->histogram[ibucket];
+	counters->allocated += size;
+	counters->pending += (int64_t)size;
+	if( counters->pending > MEMORY_STATISTICS_FLUSH_LIMIT )
+		_memory_statistics_flush( islot, context, counters );
+
+	return p;
+}
+
+
+static void _memory_statistics_release_header( uint64_t header )
+{
+	memory_statistics_shard_t* shard;
+	memory_statistics_counters_t* counters;
+	unsigned int islot;
+	uint64_t size = header & MEMORY_STATISTICS_SIZE_MASK;
+	uint16_t context = (uint16_t)( ( header >> MEMORY_STATISTICS_SIZE_BITS ) & 0xFFFF );
+
+	shard = _memory_statistics_shard();
+	if( shard )
+	{
+		islot = _memory_statistics_slot( context, true );
+		counters = shard->counters + islot;
+		++counters->deallocations;
+		counters->deallocated += size;
+		counters->pending -= (int64_t)size;
+		if( counters->pending < -MEMORY_STATISTICS_FLUSH_LIMIT )
+			_memory_statistics_flush( islot, context, counters );
+	}
+}
+
+
+static void* _memory_statistics_release( void* p, uint16_t* context )
+{
+	uint64_t header = *( (uint64_t*)p - 1 );
+	*context = (uint16_t)( ( header >> MEMORY_STATISTICS_SIZE_BITS ) & 0xFFFF );
+	_memory_statistics_release_header( header );
+	return pointer_offset( p, -(int64_t)( 1ULL << ( header >> MEMORY_STATISTICS_HEADER_SHIFT ) ) );
+}
+
+
+static void* _memory_statistics_reallocate( void* p, uint64_t size, unsigned int align, uint64_t oldsize )
+{
+	uint16_t context = memory_context();
+	unsigned int header = _memory_statistics_header_size( align );
+	void* raw = 0;
+
+	if( p )
+	{
+		//Only release the old block and its accounting once the new block is in place, a failed
+		//reallocation leaves the caller with the old block still valid and tracked
+		uint64_t old_tag = *( (uint64_t*)p - 1 );
+		unsigned int old_header = 1U << ( old_tag >> MEMORY_STATISTICS_HEADER_SHIFT );
+		void* old_raw = pointer_offset( p, -(int64_t)old_header );
+
+		context = (uint16_t)( ( old_tag >> MEMORY_STATISTICS_SIZE_BITS ) & 0xFFFF );
+		if( ( size > oldsize ) && !_memory_budget_reserve( context, size - oldsize ) )
+			return 0;
+		if( old_header == header )
+		{
+			raw = _memsys.reallocate( old_raw, size + header, align, oldsize + header );
+			if( !raw )
+				return 0;
+		}
+		else
+		{
+			//Header size changed with alignment, contents must move to a new offset
+			raw = _memsys.allocate( context, size + header, align, MEMORY_PERSISTENT );
+			if( !raw )
+				return 0;
+			if( oldsize )
+				memcpy( pointer_offset( raw, header ), p, (size_t)( ( size < oldsize ) ? size : oldsize ) );
+			_memsys.deallocate( old_raw );
+		}
+		_memory_statistics_release_header( old_tag );
+	}
+	else
+	{
+		if( !_memory_budget_reserve( context, size ) )
+			return 0;
+		raw = _memsys.reallocate( 0, size + header, align, 0 );
+	}
+
+	return _memory_statistics_store( raw, header, context, size );
+}
+
+
+static void _memory_statistics_deallocate( void* p )
+{
+	uint16_t context;
+	if( p )
+		_memsys.deallocate( _memory_statistics_release( p, &context ) );
+}
+
+
+static void _memory_statistics_shutdown( void )
+{
+	memory_statistics_shard_t* shard = _memory_statistics_shards;
+	unsigned int islot;
+	while( shard )
+	{
+		memory_statistics_shard_t* next = shard->next;
+		_memsys.deallocate( shard );
+		shard = next;
+	}
+	_memory_statistics_shards = 0;
+	set_thread_memory_statistics( 0 );
+
+	for( islot = 0; islot < BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS; ++islot )
+	{
+		_memory_budget_soft[islot] = 0;
+		_memory_budget_hard[islot] = 0;
+		_memory_budget_level[islot] = MEMORY_PRESSURE_NONE;
+	}
+	for( islot = 0; islot < BUILD_SIZE_MEMORY_PRESSURE_CALLBACKS; ++islot )
+		_memory_pressure_callback[islot] = 0;
+	_memory_budget_count = 0;
+	_memory_budget_hard_count = 0;
+}
+
+
+memory_statistics_t memory_statistics( uint16_t context )
+{
+	memory_statistics_t stats;
+	memory_statistics_shard_t* shard;
+	unsigned int islot = _memory_statistics_slot( context, false );
+	unsigned int ibucket;
+	uint64_t deallocated = 0;
+
+	memset( &stats, 0, sizeof( stats ) );
+	if( islot >= BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS )
+		return stats;
+
+	for( shard = _memory_statistics_shards; shard; shard = shard->next )
+	{
+		const memory_statistics_counters_t* counters = shard->counters + islot;
+		stats.allocations += counters->allocations;
+		stats.deallocations += counters->deallocations;
+		stats.allocated_total += counters->allocated;
+		deallocated += counters->deallocated;
+		for( ibucket = 0; ibucket < BUILD_SIZE_MEMORY_STATISTICS_HISTOGRAM; ++ibucket )
+			stats.histogram[ibucket] += counters->histogram[ibucket];
+	}
+
+	stats.allocated_current = ( stats.allocated_total > deallocated ) ? stats.allocated_total - deallocated : 0;
+	stats.allocated_peak = ( _memory_statistics_peak[islot] > 0 ) ? (uint64_t)_memory_statistics_peak[islot] : 0;
+	if( stats.allocated_peak < stats.allocated_current )
+		stats.allocated_peak = stats.allocated_current;
+
+	return stats;
+}
+
+
+unsigned int memory_statistics_contexts( uint16_t* contexts, unsigned int capacity )
+{
+	unsigned int islot, count = 0;
+	for( islot = 0; islot < MEMORY_STATISTICS_OVERFLOW_SLOT; ++islot )
+	{
+		int32_t key = _memory_statistics_context[islot];
+		if( !key )
+			continue;
+		if( count < capacity )
+			contexts[count] = (uint16_t)( key - 1 );
+		++count;
+	}
+	return count;
+}
+
+
+void memory_set_budget( uint16_t context, uint64_t soft, uint64_t hard )
+{
+	unsigned int islot = _memory_statistics_slot( context, true );
+	unsigned int count = 0, hard_count = 0;
+
+	_memory_spin_lock( &_memory_statistics_lock );
+	_memory_budget_soft[islot] = (int64_t)soft;
+	_memory_budget_hard[islot] = (int64_t)hard;
+	for( islot = 0; islot < BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS; ++islot )
+	{
+		if( _memory_budget_soft[islot] || _memory_budget_hard[islot] )
+			++count;
+		if( _memory_budget_hard[islot] )
+			++hard_count;
+	}
+	_memory_budget_count = (int32_t)count;
+	_memory_budget_hard_count = (int32_t)hard_count;
+	_memory_spin_unlock( &_memory_statistics_lock );
+}
+
+
+memory_pressure_t memory_pressure( uint16_t context )
+{
+	unsigned int islot = _memory_statistics_slot( context, false );
+	if( islot >= BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS )
+		return MEMORY_PRESSURE_NONE;
+	return (memory_pressure_t)_memory_budget_level[islot];
+}
+
+
+bool memory_pressure_register( memory_pressure_fn callback )
+{
+	//Slots are only written under the lock, notification reads them without locking
+	unsigned int icb;
+	_memory_spin_lock( &_memory_pressure_lock );
+	for( icb = 0; icb < BUILD_SIZE_MEMORY_PRESSURE_CALLBACKS; ++icb )
+	{
+		if( !_memory_pressure_callback[icb] )
+		{
+			_memory_pressure_callback[icb] = callback;
+			_memory_spin_unlock( &_memory_pressure_lock );
+			return true;
+		}
+	}
+	_memory_spin_unlock( &_memory_pressure_lock );
+	log_errorf( 0, ERROR_OUT_OF_MEMORY, "Unable to register memory pressure callback, limit of %d reached", BUILD_SIZE_MEMORY_PRESSURE_CALLBACKS );
+	return false;
+}
+
+
+void memory_pressure_unregister( memory_pressure_fn callback )
+{
+	unsigned int icb;
+	_memory_spin_lock( &_memory_pressure_lock );
+	for( icb = 0; icb < BUILD_SIZE_MEMORY_PRESSURE_CALLBACKS; ++icb )
+	{
+		if( _memory_pressure_callback[icb] == callback )
+			_memory_pressure_callback[icb] = 0;
+	}
+	_memory_spin_unlock( &_memory_pressure_lock );
+}
+
+
+#else
+
+
+memory_statistics_t memory_statistics( uint16_t context )
+{
+	memory_statistics_t stats;
+	(void)sizeof( context );
+	memset( &stats, 0, sizeof( stats ) );
+	return stats;
+}
+
+
+unsigned int memory_statistics_contexts( uint16_t* contexts, unsigned int capacity )
+{
+	(void)sizeof( contexts );
+	(void)sizeof( capacity );
+	return 0;
+}
+
+
+void memory_set_budget( uint16_t context, uint64_t soft, uint64_t hard )
+{
+	(void)sizeof( context );
+	(void)sizeof( soft );
+	(void)sizeof( hard );
+}
+
+
+memory_pressure_t memory_pressure( uint16_t context )
+{
+	(void)sizeof( context );
+	return MEMORY_PRESSURE_NONE;
+}
+
+
+bool memory_pressure_register( memory_pressure_fn callback )
+{
+	(void)sizeof( callback );
+	return false;
+}
+
+
+void memory_pressure_unregister( memory_pressure_fn callback )
+{
+	(void)sizeof( callback );
+}
+
+
+#endif
+
+
+#if BUILD_ENABLE_MEMORY_CONTEXT
+
+
+FOUNDATION_DECLARE_THREAD_LOCAL( memory_context_t*, memory_context, 0 )
+
+void memory_context_push( uint16_t context_id )
+{
+	memory_context_t* context = get_thread_memory_context();
+	if( !context )
+	{
+		context = memory_allocate_zero( sizeof( memory_context_t ), 0, MEMORY_PERSISTENT );
+		set_thread_memory_context( context );
+	}
+	FOUNDATION_ASSERT_MSG( context->depth < BUILD_SIZE_MEMORY_CONTEXT_DEPTH, "Memory context stack overflow" );
+	context->context[ context->depth ] = context_id;
+	if( context->depth < BUILD_SIZE_MEMORY_CONTEXT_DEPTH-1 )
+		++context->depth;
+}
+
+
+void memory_context_pop( void )
+{
+	memory_context_t* context = get_thread_memory_context();
+	if( context )
+	{
+		FOUNDATION_ASSERT_MSG( context->depth, "Memory context stack underflow" );
+		--context->depth;
+	}
+}
+
+
+uint16_t memory_context( void )
+{
+	memory_context_t* context = get_thread_memory_context();
+	return ( context && ( context->depth > 0 ) ) ? context->context[ context->depth - 1 ] : MEMORYCONTEXT_GLOBAL;
+}
+
+
+void memory_context_thread_deallocate( void )
+{
+	memory_context_t* context = get_thread_memory_context();
+	if( context )
+		memory_deallocate( context );
+	set_thread_memory_context( 0 );
+}
+
+
+#endif
+
+
+#if FOUNDATION_PLATFORM_WINDOWS
+
+typedef long (*NtAllocateVirtualMemoryFn)( HANDLE, void**, ULONG, size_t*, ULONG, ULONG);
+static NtAllocateVirtualMemoryFn NtAllocateVirtualMemory = 0;
+
+#endif
+
+
+#if FOUNDATION_PLATFORM_POSIX && ( FOUNDATION_PLATFORM_POINTER_SIZE > 4 )
+
+static void* _memory_map_hugepage( size_t* size, bool zero )
+{
+	size_t map_size = ( *size + ( MEMORY_HUGEPAGE_SIZE - 1 ) ) & ~(size_t)( MEMORY_HUGEPAGE_SIZE - 1 );
+	char* raw_memory;
+	char* aligned_memory;
+	size_t head_size;
+
+#if FOUNDATION_PLATFORM_LINUX
+	raw_memory = mmap( 0, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+	if( raw_memory != MAP_FAILED )
+	{
+		*size = map_size;
+		return raw_memory;
+	}
+#endif
+
+	//No reserved huge pages available, map huge page aligned memory and hint for transparent huge pages
+	raw_memory = mmap( 0, map_size + MEMORY_HUGEPAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | ( zero ? 0 : MAP_UNINITIALIZED ), -1, 0 );
+	if( raw_memory == MAP_FAILED )
+		return 0;
+
+	aligned_memory = _memory_align_pointer( raw_memory, MEMORY_HUGEPAGE_SIZE );
+	head_size = (size_t)pointer_diff( aligned_memory, raw_memory );
+	if( head_size )
+		munmap( raw_memory, head_size );
+	munmap( aligned_memory + map_size, MEMORY_HUGEPAGE_SIZE - head_size );
+
+#if defined( MADV_HUGEPAGE )
+	madvise( aligned_memory, map_size, MADV_HUGEPAGE );
+#endif
+
+	*size = map_size;
+	return aligned_memory;
+}
+
+#endif
+
+
+static void* _memory_allocate_malloc_raw( uint64_t size, unsigned int align, memory_hint_t hint, bool zero )
+{
+	//If we align manually, we must be able to retrieve the original pointer for passing to free()
+	//Thus all allocations need to go through that path
+
+	//Zeroed blocks are taken from calloc or fresh anonymous mappings which are already zero, letting the
+	//pages be faulted in lazily on first touch instead of clearing the whole block up front
+
+#if FOUNDATION_PLATFORM_WINDOWS
+
+#  if FOUNDATION_PLATFORM_POINTER_SIZE == 4
+	void* memory = _aligned_malloc( (size_t)size, align );
+	if( zero && memory )
+		memset( memory, 0, (size_t)size );
+	return memory;
+#  else
+	unsigned int padding;
+	size_t allocate_size;
+	char* raw_memory;
+	void* memory;
+	long vmres;
+
+	if( hint != MEMORY_PERSISTENT_32BIT_ADDRESS )
+	{
+		padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE );
+		raw_memory = _aligned_malloc( (size_t)size + padding, align );
+
+		memory = raw_memory + padding; //Will be aligned since padding is multiple of alignment (minimum align/pad is pointer size)
+		*( (void**)memory - 1 ) = raw_memory;
+		FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
+		if( zero )
+			memset( memory, 0, (size_t)size );
+
+		return memory;
+	}
+
+	padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ) ? align : FOUNDATION_PLATFORM_POINTER_SIZE;
+	allocate_size = size + padding + align;
+	raw_memory = 0;
+
+	vmres = NtAllocateVirtualMemory( INVALID_HANDLE_VALUE, &raw_memory, 1, &allocate_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+	if( vmres != 0 )
+		return 0;
+	
+	memory = _memory_align_pointer( raw_memory + padding, align );
+	*( (void**)memory - 1 ) = (void*)( (uintptr_t)raw_memory | 5 );
+	FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
+
+	return memory;
+#  endif	
+
+#else
+	
+#  if FOUNDATION_PLATFORM_POINTER_SIZE > 4
+	if( ( hint != MEMORY_PERSISTENT_32BIT_ADDRESS ) && ( ( hint != MEMORY_PERSISTENT_HUGEPAGE ) || ( size < MEMORY_HUGEPAGE_SIZE ) ) && ( size < _memory_map_threshold ) )
+#  endif
+	{
+		unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE );
+		char* raw_memory = zero ? calloc( 1, (size_t)size + align + padding ) : malloc( (size_t)size + align + padding );
+		void* memory = _memory_align_pointer( raw_memory + padding, align );
+		*( (void**)memory - 1 ) = raw_memory;
+		FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
+		return memory;
+	}
+	
+#  if FOUNDATION_PLATFORM_POINTER_SIZE > 4
+
+	unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE*2 ? align : FOUNDATION_PLATFORM_POINTER_SIZE*2 );
+	size_t allocate_size = size + padding + align;
+	uintptr_t tag = 1;
+	char* raw_memory;
+	void* memory;
+
+	//Mapped blocks are tagged with the low bit, huge page blocks also with the second bit and
+	//blocks in the low 32-bit address range with the third bit
+	if( hint == MEMORY_PERSISTENT_HUGEPAGE )
+	{
+		raw_memory = _memory_map_hugepage( &allocate_size, zero );
+		tag = 3;
+	}
+	else
+	{
+		int flags = MAP_PRIVATE | MAP_ANONYMOUS | ( zero ? 0 : MAP_UNINITIALIZED );
+		if( hint == MEMORY_PERSISTENT_32BIT_ADDRESS )
+		{
+			flags |= MAP_32BIT;
+			tag = 5;
+		}
+		raw_memory = mmap( 0, allocate_size, PROT_READ | PROT_WRITE, flags, -1, 0 );
+		if( raw_memory == MAP_FAILED )
+			raw_memory = 0;
+	}
+	if( !raw_memory )
+		return 0;
+	
+	memory = _memory_align_pointer( raw_memory + padding, align );
+	*( (uintptr_t*)memory - 1 ) = ( (uintptr_t)raw_memory | tag );
+	*( (uintptr_t*)memory - 2 ) = allocate_size;
+	FOUNDATION_ASSERT( !( (uintptr_t)raw_memory & 1 ) );
+
+	return memory;	
+
+#  endif
+	
+#endif
+}
+
+
+static void* _memory_allocate_malloc( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
+{
+	align = _memory_get_align( align );
+	return _memory_allocate_malloc_raw( size, align, hint, false );
+}
+
+
+static void* _memory_allocate_zero_malloc( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
+{
+	align = _memory_get_align( align );
+	return _memory_allocate_malloc_raw( size, align, hint, true );
+}
+
+
+static void _memory_deallocate_malloc( void* p )
+{
+#if FOUNDATION_PLATFORM_POINTER_SIZE == 4
+
+	if( !p )
+		return;
+#  if FOUNDATION_PLATFORM_WINDOWS
+	_aligned_free( p );
+#  else
+	free( *( (void**)p - 1 ) );
+#  endif
+
+#else
+
+	uintptr_t raw_ptr;
+
+	if( !p )
+		return;
+
+	raw_ptr = *( (uintptr_t*)p - 1 );
+	if( raw_ptr & 1 )
+	{
+#  if FOUNDATION_PLATFORM_WINDOWS
+		VirtualFree( (void*)( raw_ptr & ~(uintptr_t)7 ), 0, MEM_RELEASE );
+#  else
+		uintptr_t raw_size = *( (uintptr_t*)p - 2 );
+		munmap( (void*)( raw_ptr & ~(uintptr_t)7 ), raw_size );
+#  endif
+	}
+	else
+	{
+#  if FOUNDATION_PLATFORM_WINDOWS
+		_aligned_free( (void*)raw_ptr );
+#  else
+		free( (void*)raw_ptr );
+#  endif
+	}
+
+#endif
+}
+
+
+static FORCEINLINE memory_hint_t _memory_raw_hint( const void* raw_p )
+{
+	//Recreate the hint of the original allocation from the raw pointer tag bits
+	if( !( (uintptr_t)raw_p & 1 ) )
+		return MEMORY_PERSISTENT;
+	if( (uintptr_t)raw_p & 2 )
+		return MEMORY_PERSISTENT_HUGEPAGE;
+	return ( (uintptr_t)raw_p & 4 ) ? MEMORY_PERSISTENT_32BIT_ADDRESS : MEMORY_PERSISTENT;
+}
+
+
+static void* _memory_reallocate_mapped( void* p, uint64_t size, unsigned int align, uint64_t oldsize )
+{
+#if FOUNDATION_PLATFORM_LINUX && ( FOUNDATION_PLATFORM_POINTER_SIZE > 4 )
+	uintptr_t raw_ptr = *( (uintptr_t*)p - 1 );
+	uintptr_t raw_size = *( (uintptr_t*)p - 2 );
+	char* raw_memory = (char*)( raw_ptr & ~(uintptr_t)7 );
+	unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE*2 ? align : FOUNDATION_PLATFORM_POINTER_SIZE*2 );
+	uintptr_t old_offset = pointer_diff( p, raw_memory );
+	size_t allocate_size = (size_t)size + padding + align;
+	void* memory;
+
+	//Remapping could move blocks out of the low 32-bit address range
+	if( ( raw_ptr & 4 ) || ( old_offset > (uintptr_t)padding + align ) )
+		return 0;
+
+	if( raw_ptr & 2 )
+		allocate_size = ( allocate_size + ( MEMORY_HUGEPAGE_SIZE - 1 ) ) & ~(size_t)( MEMORY_HUGEPAGE_SIZE - 1 );
+
+	raw_memory = mremap( raw_memory, raw_size, allocate_size, MREMAP_MAYMOVE );
+	if( raw_memory == MAP_FAILED )
+		return 0;
+
+	memory = _memory_align_pointer( raw_memory + padding, align );
+	if( pointer_diff( memory, raw_memory ) != old_offset )
+		memmove( memory, raw_memory + old_offset, ( oldsize && ( oldsize < size ) ) ? (size_t)oldsize : (size_t)size );
+	*( (uintptr_t*)memory - 1 ) = ( (uintptr_t)raw_memory | ( raw_ptr & 7 ) );
+	*( (uintptr_t*)memory - 2 ) = allocate_size;
+
+	return memory;
+#else
+	return 0;
+#endif
+}
+
+
+static void* _memory_reallocate_malloc( void* p, uint64_t size, unsigned int align, uint64_t oldsize )
+{
+#if ( FOUNDATION_PLATFORM_POINTER_SIZE == 4 ) && FOUNDATION_PLATFORM_WINDOWS
+	align = _memory_get_align( align );
+	return _aligned_realloc( p, (size_t)size, align );
+#else
+	void* memory;
+	void* raw_p;
+
+	align = _memory_get_align( align );
+
+	memory = 0;
+	raw_p = p ? *( (void**)p - 1 ) : 0;
+#if FOUNDATION_PLATFORM_WINDOWS
+	//_aligned_realloc requires the same alignment as the original allocation, identified by the padding
+	if( raw_p && !( (uintptr_t)raw_p & 1 ) && ( pointer_diff( p, raw_p ) == ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE ) ) )
+	{
+		unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE );
+		void* raw_memory = _aligned_realloc( raw_p, padding + size, align );
+		if( raw_memory )
+		{
+			memory = pointer_offset( raw_memory, padding );
+			*( (void**)memory - 1 ) = raw_memory;
+		}
+	}
+	else
+	{
+		memory = _memory_allocate_malloc_raw( size, align, _memory_raw_hint( raw_p ), false );
+		if( p && memory && oldsize )
+			memcpy( memory, p, ( size < oldsize ) ? size : oldsize );
+		_memory_deallocate_malloc( p );
+	}
+#else
+	unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE );
+#if FOUNDATION_PLATFORM_POINTER_SIZE > 4
+	bool map = ( size >= _memory_map_threshold );
+#else
+	bool map = false;
+#endif
+	if( raw_p && ( (uintptr_t)raw_p & 1 ) )
+	{
+		//Grow or shrink mapped blocks in place if possible
+		memory = _memory_reallocate_mapped( p, size, align, oldsize );
+	}
+	else if( raw_p && !map && ( pointer_diff( p, raw_p ) <= (uintptr_t)padding + align ) )
+	{
+		//Same layout as _memory_allocate_malloc_raw, if the realloc'ed block ends up with a different
+		//alignment offset the contents must be moved to the new aligned position
+		uintptr_t old_offset = pointer_diff( p, raw_p );
+		char* raw_memory = realloc( raw_p, (size_t)size + align + padding );
+		if( raw_memory )
+		{
+			memory = _memory_align_pointer( raw_memory + padding, align );
+			if( pointer_diff( memory, raw_memory ) != old_offset )
+				memmove( memory, raw_memory + old_offset, ( oldsize && ( oldsize < size ) ) ? (size_t)oldsize : (size_t)size );
+			*( (void**)memory - 1 ) = raw_memory;
+		}
+	}
+	if( !memory )
+	{
+		memory = _memory_allocate_malloc_raw( size, align, _memory_raw_hint( raw_p ), false );
+		if( p && memory && oldsize )
+			memcpy( memory, p, ( size < oldsize ) ? (size_t)size : (size_t)oldsize );
+		_memory_deallocate_malloc( p );
+	}
+#endif
+	if( !memory )
+	{
+		log_panicf( 0, ERROR_OUT_OF_MEMORY, "Unable to reallocate memory: %s", system_error_message( 0 ) );
+	}
+	return memory;
+#endif
+}
+
+
+static int _memory_initialize_malloc( void )
+{
+#if FOUNDATION_PLATFORM_WINDOWS && ( FOUNDATION_PLATFORM_POINTER_SIZE > 4 )
+	NtAllocateVirtualMemory = (NtAllocateVirtualMemoryFn)GetProcAddress( GetModuleHandleA( "ntdll.dll" ), "NtAllocateVirtualMemory" );
+#endif
+	return 0;
+}
+
+
+static void _memory_shutdown_malloc( void )
+{
+}
+
+
+memory_system_t memory_system_malloc( void )
+{
+	memory_system_t memsystem;
+	memsystem.allocate = _memory_allocate_malloc;
+	memsystem.allocate_zero = _memory_allocate_zero_malloc;
+	memsystem.reallocate = _memory_reallocate_malloc;
+	memsystem.deallocate = _memory_deallocate_malloc;
+	memsystem.initialize = _memory_initialize_malloc;
+	memsystem.shutdown = _memory_shutdown_malloc;
+	memsystem.thread_finalize = 0;
+	memsystem.allocate_batch = 0;
+	memsystem.deallocate_batch = 0;
+	return memsystem;
+}
+
+
+//Pool allocator. Small blocks are served from size classes carved out of 64KiB spans. Each thread keeps
+//a cache of free blocks per size class, refilled from and returned to the central per-class span lists
+//in batches. Spans are allocated in superblocks from the malloc backend and looked up through a two level
+//page map, blocks larger than the biggest size class are passed through to the malloc backend.
+
+#define MEMORY_POOL_SPAN_SHIFT        16
+#define MEMORY_POOL_SPAN_SIZE         ( 1U << MEMORY_POOL_SPAN_SHIFT )
+#define MEMORY_POOL_SUPERBLOCK_SPANS  64
+#define MEMORY_POOL_CLASS_COUNT       44
+#define MEMORY_POOL_MAX_SIZE          16384
+#define MEMORY_POOL_ALIGN             16
+#define MEMORY_POOL_MAP_BITS          16
+#define MEMORY_POOL_MAP_SIZE          ( 1U << MEMORY_POOL_MAP_BITS )
+
+typedef struct _foundation_memory_pool_span       memory_pool_span_t;
+typedef struct _foundation_memory_pool_superblock memory_pool_superblock_t;
+typedef struct _foundation_memory_pool_cache      memory_pool_cache_t;
+
+struct _foundation_memory_pool_span
+{
+	void*                          base;
+	void*                          free;
+	memory_pool_span_t*            next;
+	memory_pool_span_t*            prev;
+	uint32_t                       used;
+	uint32_t                       carved;
+	uint32_t                       capacity;
+	uint32_t                       size_class;
+};
+
+struct _foundation_memory_pool_superblock
+{
+	void*                          memory;
+	memory_pool_superblock_t*      next;
+	memory_pool_span_t             span[MEMORY_POOL_SUPERBLOCK_SPANS];
+};
+
+typedef struct ALIGN(64) _foundation_memory_pool_central
+{
+	volatile int32_t               lock;
+	uint32_t                       size;
+	uint32_t                       batch;
+	memory_pool_span_t*            partial;
+} memory_pool_central_t;
+
+typedef struct _foundation_memory_pool_bin
+{
+	void*                          free;
+	uint32_t                       count;
+} memory_pool_bin_t;
+
+struct _foundation_memory_pool_cache
+{
+	memory_pool_cache_t*           next;
+	memory_pool_bin_t              bin[MEMORY_POOL_CLASS_COUNT];
+};
+
+static memory_pool_central_t       _memory_pool_central[MEMORY_POOL_CLASS_COUNT];
+static memory_pool_span_t**        _memory_pool_map[MEMORY_POOL_MAP_SIZE];
+static volatile int32_t            _memory_pool_lock = 0;
+static memory_pool_span_t*         _memory_pool_span_free = 0;
+static memory_pool_superblock_t*   _memory_pool_superblocks = 0;
+static memory_pool_cache_t*        _memory_pool_caches = 0;
+
+FOUNDATION_DECLARE_THREAD_LOCAL( memory_pool_cache_t*, memory_pool_cache, 0 )
+
+
+static CONSTCALL FORCEINLINE unsigned int _memory_pool_class( uint64_t size )
+{
+	//16 byte steps up to 256, 128 byte steps up to 2048, 1024 byte steps up to 16384
+	if( size <= 256 )
+		return size ? (unsigned int)( ( size - 1 ) >> 4 ) : 0;
+	if( size <= 2048 )
+		return 16 + (unsigned int)( ( size - 257 ) >> 7 );
+	return 30 + (unsigned int)( ( size - 2049 ) >> 10 );
+}
+
+
+static CONSTCALL unsigned int _memory_pool_class_size( unsigned int iclass )
+{
+	if( iclass < 16 )
+		return ( iclass + 1 ) << 4;
+	if( iclass < 30 )
+		return 256 + ( ( iclass - 15 ) << 7 );
+	return 2048 + ( ( iclass - 29 ) << 10 );
+}
+
+
+static unsigned int _memory_pool_class_aligned( uint64_t size, unsigned int align )
+{
+	//Blocks are placed at multiples of the class size from the span base, so pick a class size which is a multiple of the alignment
+	unsigned int iclass = _memory_pool_class( ( size < align ) ? align : size );
+	while( ( iclass < MEMORY_POOL_CLASS_COUNT ) && ( _memory_pool_central[iclass].size % align ) )
+		++iclass;
+	return iclass;
+}
+
+
+static FORCEINLINE memory_pool_span_t* _memory_pool_span( const void* p )
+{
+	uint64_t page = (uint64_t)(uintptr_t)p >> MEMORY_POOL_SPAN_SHIFT;
+	memory_pool_span_t** leaf = _memory_pool_map[ ( page >> MEMORY_POOL_MAP_BITS ) & ( MEMORY_POOL_MAP_SIZE - 1 ) ];
+	memory_pool_span_t* span = leaf ? leaf[ page & ( MEMORY_POOL_MAP_SIZE - 1 ) ] : 0;
+	if( span && ( span->base == (void*)( (uintptr_t)p & ~(uintptr_t)( MEMORY_POOL_SPAN_SIZE - 1 ) ) ) )
+		return span;
+	return 0;
+}
+
+
+static bool _memory_pool_map_span( memory_pool_span_t* span )
+{
+	uint64_t page = (uint64_t)(uintptr_t)span->base >> MEMORY_POOL_SPAN_SHIFT;
+	memory_pool_span_t*** root = &_memory_pool_map[ ( page >> MEMORY_POOL_MAP_BITS ) & ( MEMORY_POOL_MAP_SIZE - 1 ) ];
+	memory_pool_span_t** leaf = *root;
+	if( !leaf )
+	{
+		leaf = _memory_allocate_malloc_raw( sizeof( memory_pool_span_t* ) * MEMORY_POOL_MAP_SIZE, FOUNDATION_PLATFORM_POINTER_SIZE, MEMORY_PERSISTENT, false );
+		if( !leaf )
+			return false;
+		memset( leaf, 0, sizeof( memory_pool_span_t* ) * MEMORY_POOL_MAP_SIZE );
+		if( !atomic_cas_ptr( root, leaf, 0 ) )
+		{
+			_memory_deallocate_malloc( leaf );
+			leaf = *root;
+		}
+	}
+	leaf[ page & ( MEMORY_POOL_MAP_SIZE - 1 ) ] = span;
+	return true;
+}
+
+
+static void _memory_pool_unmap_span( memory_pool_span_t* span )
+{
+	//Leaf tables are shared between superblocks and kept until shutdown
+	uint64_t page = (uint64_t)(uintptr_t)span->base >> MEMORY_POOL_SPAN_SHIFT;
+	memory_pool_span_t** leaf = _memory_pool_map[ ( page >> MEMORY_POOL_MAP_BITS ) & ( MEMORY_POOL_MAP_SIZE - 1 ) ];
+	if( leaf && ( leaf[ page & ( MEMORY_POOL_MAP_SIZE - 1 ) ] == span ) )
+		leaf[ page & ( MEMORY_POOL_MAP_SIZE - 1 ) ] = 0;
+}
+
+
+static memory_pool_span_t* _memory_pool_span_allocate( void )
+{
+	memory_pool_superblock_t* superblock;
+	memory_pool_span_t* span;
+	unsigned int ispan;
+
+	_memory_spin_lock( &_memory_pool_lock );
+	span = _memory_pool_span_free;
+	if( span )
+		_memory_pool_span_free = span->next;
+	_memory_spin_unlock( &_memory_pool_lock );
+	if( span )
+		return span;
+
+	superblock = _memory_allocate_malloc_raw( sizeof( memory_pool_superblock_t ), FOUNDATION_PLATFORM_POINTER_SIZE, MEMORY_PERSISTENT, false );
+	if( !superblock )
+		return 0;
+	memset( superblock, 0, sizeof( memory_pool_superblock_t ) );
+	superblock->memory = _memory_allocate_malloc_raw( (uint64_t)MEMORY_POOL_SPAN_SIZE * MEMORY_POOL_SUPERBLOCK_SPANS, MEMORY_POOL_SPAN_SIZE, MEMORY_PERSISTENT, false );
+	if( !superblock->memory )
+	{
+		_memory_deallocate_malloc( superblock );
+		return 0;
+	}
+	for( ispan = 0; ispan < MEMORY_POOL_SUPERBLOCK_SPANS; ++ispan )
+	{
+		superblock->span[ispan].base = pointer_offset( superblock->memory, (uint64_t)MEMORY_POOL_SPAN_SIZE * ispan );
+		if( !_memory_pool_map_span( superblock->span + ispan ) )
+		{
+			while( ispan-- )
+				_memory_pool_unmap_span( superblock->span + ispan );
+			_memory_deallocate_malloc( superblock->memory );
+			_memory_deallocate_malloc( superblock );
+			return 0;
+		}
+	}
+
+	_memory_spin_lock( &_memory_pool_lock );
+	for( ispan = MEMORY_POOL_SUPERBLOCK_SPANS - 1; ispan > 0; --ispan )
+	{
+		superblock->span[ispan].next = _memory_pool_span_free;
+		_memory_pool_span_free = superblock->span + ispan;
+	}
+	superblock->next = _memory_pool_superblocks;
+	_memory_pool_superblocks = superblock;
+	_memory_spin_unlock( &_memory_pool_lock );
+
+	return superblock->span;
+}
+
+
+static void _memory_pool_span_release( memory_pool_span_t* span )
+{
+	span->free = 0;
+	span->prev = 0;
+	span->used = 0;
+	span->carved = 0;
+	span->capacity = 0;
+	span->size_class = 0;
+
+	_memory_spin_lock( &_memory_pool_lock );
+	span->next = _memory_pool_span_free;
+	_memory_pool_span_free = span;
+	_memory_spin_unlock( &_memory_pool_lock );
+}
+
+
+static FORCEINLINE void _memory_pool_partial_link( memory_pool_central_t* central, memory_pool_span_t* span )
+{
+	span->prev = 0;
+	span->next = central->partial;
+	if( central->partial )
+		central->partial->prev = span;
+	central->partial = span;
+}
+
+
+static FORCEINLINE void _memory_pool_partial_unlink( memory_pool_central_t* central, memory_pool_span_t* span )
+{
+	if( span->prev )
+		span->prev->next = span->next;
+	else
+		central->partial = span->next;
+	if( span->next )
+		span->next->prev = span->prev;
+	span->next = span->prev = 0;
+}
+
+
+static void* _memory_pool_central_fetch( unsigned int iclass, uint32_t* count )
+{
+	memory_pool_central_t* central = _memory_pool_central + iclass;
+	void* list = 0;
+	uint32_t num = 0;
+
+	_memory_spin_lock( &central->lock );
+	while( num < central->batch )
+	{
+		memory_pool_span_t* span = central->partial;
+		void* block;
+		if( !span )
+		{
+			_memory_spin_unlock( &central->lock );
+			span = _memory_pool_span_allocate();
+			_memory_spin_lock( &central->lock );
+			if( !span )
+				break;
+			span->size_class = iclass;
+			span->capacity = MEMORY_POOL_SPAN_SIZE / central->size;
+			_memory_pool_partial_link( central, span );
+		}
+
+		block = span->free;
+		if( block )
+			span->free = *(void**)block;
+		else
+			block = pointer_offset( span->base, (uint64_t)central->size * span->carved++ );
+		++span->used;
+
+		if( !span->free && ( span->carved == span->capacity ) )
+			_memory_pool_partial_unlink( central, span );
+
+		*(void**)block = list;
+		list = block;
+		++num;
+	}
+	_memory_spin_unlock( &central->lock );
+
+	*count = num;
+	return list;
+}
+
+
+static void _memory_pool_central_release( unsigned int iclass, void* list )
+{
+	memory_pool_central_t* central = _memory_pool_central + iclass;
+
+	_memory_spin_lock( &central->lock );
+	while( list )
+	{
+		void* next = *(void**)list;
+		memory_pool_span_t* span = _memory_pool_span( list );
+		bool was_full = !span->free && ( span->carved == span->capacity );
+
+		*(void**)list = span->free;
+		span->free = list;
+
+		if( was_full )
+			_memory_pool_partial_link( central, span );
+		if( !--span->used )
+		{
+			_memory_pool_partial_unlink( central, span );
+			_memory_pool_span_release( span );
+		}
+
+		list = next;
+	}
+	_memory_spin_unlock( &central->lock );
+}
+
+
+static memory_pool_cache_t* _memory_pool_thread_cache( void )
+{
+	memory_pool_cache_t* cache = get_thread_memory_pool_cache();
+	if( !cache )
+	{
+		cache = _memory_allocate_malloc_raw( sizeof( memory_pool_cache_t ), FOUNDATION_PLATFORM_POINTER_SIZE, MEMORY_PERSISTENT, false );
+		if( !cache )
+			return 0;
+		memset( cache, 0, sizeof( memory_pool_cache_t ) );
+
+		_memory_spin_lock( &_memory_pool_lock );
+		cache->next = _memory_pool_caches;
+		_memory_pool_caches = cache;
+		_memory_spin_unlock( &_memory_pool_lock );
+
+		set_thread_memory_pool_cache( cache );
+	}
+	return cache;
+}
+
+
+static void* _memory_allocate_pool( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
+{
+	memory_pool_cache_t* cache;
+	memory_pool_bin_t* bin;
+	unsigned int iclass;
+	void* block;
+
+	if( ( size > MEMORY_POOL_MAX_SIZE ) || ( hint == MEMORY_PERSISTENT_32BIT_ADDRESS ) || ( hint == MEMORY_PERSISTENT_HUGEPAGE ) )
+		return _memory_allocate_malloc( context, size, align, hint );
+
+	align = _memory_get_align( align );
+	iclass = ( align > MEMORY_POOL_ALIGN ) ? _memory_pool_class_aligned( size, align ) : _memory_pool_class( size );
+	if( iclass >= MEMORY_POOL_CLASS_COUNT )
+		return _memory_allocate_malloc( context, size, align, hint );
+
+	cache = _memory_pool_thread_cache();
+	if( !cache )
+		return 0;
+
+	bin = cache->bin + iclass;
+	if( !bin->free )
+	{
+		bin->free = _memory_pool_central_fetch( iclass, &bin->count );
+		if( !bin->free )
+		{
+			log_panicf( 0, ERROR_OUT_OF_MEMORY, "Unable to allocate memory: %s", system_error_message( 0 ) );
+			return 0;
+		}
+	}
+
+	block = bin->free;
+	bin->free = *(void**)block;
+	--bin->count;
+
+	return block;
+}
+
+
+static void* _memory_allocate_zero_pool( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint )
+{
+	void* memory;
+	if( ( size > MEMORY_POOL_MAX_SIZE ) || ( hint == MEMORY_PERSISTENT_32BIT_ADDRESS ) || ( hint == MEMORY_PERSISTENT_HUGEPAGE ) )
+		return _memory_allocate_zero_malloc( context, size, align, hint );
+
+	memory = _memory_allocate_pool( context, size, align, hint );
+	if( memory )
+		memset( memory, 0, (size_t)size );
+	return memory;
+}
+
+
+static unsigned int _memory_allocate_batch_pool( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint, void** ptrs, unsigned int count )
+{
+	memory_pool_cache_t* cache;
+	memory_pool_bin_t* bin;
+	unsigned int iclass, iptr;
+
+	align = _memory_get_align( align );
+	iclass = ( align > MEMORY_POOL_ALIGN ) ? _memory_pool_class_aligned( size, align ) : _memory_pool_class( size );
+	if( ( size > MEMORY_POOL_MAX_SIZE ) || ( iclass >= MEMORY_POOL_CLASS_COUNT ) || ( hint == MEMORY_PERSISTENT_32BIT_ADDRESS ) || ( hint == MEMORY_PERSISTENT_HUGEPAGE ) )
+	{
+		for( iptr = 0; iptr < count; ++iptr )
+		{
+			ptrs[iptr] = _memory_allocate_malloc( context, size, align, hint );
+			if( !ptrs[iptr] )
+				break;
+		}
+		return iptr;
+	}
+
+	cache = _memory_pool_thread_cache();
+	if( !cache )
+		return 0;
+
+	//Size class and thread cache are resolved once, the bin is refilled from the central list as needed
+	bin = cache->bin + iclass;
+	for( iptr = 0; iptr < count; ++iptr )
+	{
+		if( !bin->free )
+		{
+			bin->free = _memory_pool_central_fetch( iclass, &bin->count );
+			if( !bin->free )
+			{
+				log_panicf( 0, ERROR_OUT_OF_MEMORY, "Unable to allocate memory: %s", system_error_message( 0 ) );
+				break;
+			}
+		}
+		ptrs[iptr] = bin->free;
+		bin->free = *(void**)bin->free;
+		--bin->count;
+	}
+
+	return iptr;
+}
+
+
+static void _memory_pool_cache_release( memory_pool_cache_t* cache, memory_pool_span_t* span, void* p )
+{
+	unsigned int iclass = span->size_class;
+	memory_pool_bin_t* bin;
+
+	if( !cache )
+	{
+		*(void**)p = 0;
+		_memory_pool_central_release( iclass, p );
+		return;
+	}
+
+	bin = cache->bin + iclass;
+	*(void**)p = bin->free;
+	bin->free = p;
+
+	if( ++bin->count > ( _memory_pool_central[iclass].batch * 2 ) )
+	{
+		//Return a batch to the central list, keep the most recently freed blocks in the cache
+		uint32_t batch = _memory_pool_central[iclass].batch;
+		void* last = bin->free;
+		void* list;
+		uint32_t iblock;
+		for( iblock = 1; iblock < batch; ++iblock )
+			last = *(void**)last;
+		list = *(void**)last;
+		*(void**)last = 0;
+		_memory_pool_central_release( iclass, list );
+		bin->count = batch;
+	}
+}
+
+
+static void _memory_deallocate_pool( void* p )
+{
+	memory_pool_span_t* span;
 
 	if( !p )
 		return;
 
-	raw_ptr = *( (uintptr_t*)p - 1 );
-	if( raw_ptr & 1 )
+	span = _memory_pool_span( p );
+	if( !span )
 	{
-#  if FOUNDATION_PLATFORM_WINDOWS
-		VirtualFree( (void*)raw_ptr, 0, MEM_RELEASE );
-#  else
-		uintptr_t raw_size = *( (uintptr_t*)p - 2 );
-		munmap( (void*)raw_ptr, raw_size );
-#  endif
+		_memory_deallocate_malloc( p );
+		return;
 	}
-	else
+
+	_memory_pool_cache_release( _memory_pool_thread_cache(), span, p );
+}
+
+
+static void _memory_deallocate_batch_pool( void** ptrs, unsigned int count )
+{
+	memory_pool_cache_t* cache = _memory_pool_thread_cache();
+	unsigned int iptr;
+
+	for( iptr = 0; iptr < count; ++iptr )
 	{
-#  if FOUNDATION_PLATFORM_WINDOWS
-		_aligned_free( (void*)raw_ptr );
-#  else
-		free( (void*)raw_ptr );
-#  endif
+		memory_pool_span_t* span;
+		if( !ptrs[iptr] )
+			continue;
+		span = _memory_pool_span( ptrs[iptr] );
+		if( span )
+			_memory_pool_cache_release( cache, span, ptrs[iptr] );
+		else
+			_memory_deallocate_malloc( ptrs[iptr] );
 	}
-
-#endif
 }
 
 
-static void* _memory_reallocate_malloc( void* p, uint64_t size, unsigned int align, uint64_t oldsize )
+static void* _memory_reallocate_pool( void* p, uint64_t size, unsigned int align, uint64_t oldsize )
 {
-#if ( FOUNDATION_PLATFORM_POINTER_SIZE == 4 ) && FOUNDATION_PLATFORM_WINDOWS
-	align = _memory_get_align( align );
-	return _aligned_realloc( p, (size_t)size, align );
-#else
+	memory_pool_span_t* span;
 	void* memory;
-	void* raw_p;
+
+	if( !p )
+		return _memory_allocate_pool( memory_context(), size, align, MEMORY_PERSISTENT );
+
+	span = _memory_pool_span( p );
+	if( !span )
+		return _memory_reallocate_malloc( p, size, align, oldsize );
 
 	align = _memory_get_align( align );
+	if( ( size <= _memory_pool_central[span->size_class].size ) && ( !align || !( (uintptr_t)p % align ) ) )
+		return p;
 
-	memory = 0;
-	raw_p = p ? *( (void**)p - 1 ) : 0;
-#if FOUNDATION_PLATFORM_WINDOWS
-	if( raw_p && !( (uintptr_t)raw_p & 1 ) )
-	{
-		unsigned int padding = ( align > FOUNDATION_PLATFORM_POINTER_SIZE ? align : FOUNDATION_PLATFORM_POINTER_SIZE );
-		void* raw_memory = _aligned_realloc( raw_p, padding + size, align );
-		if( raw_memory )
-		{
-			memory = pointer_offset( raw_memory, padding );
-			*( (void**)memory - 1 ) = raw_memory;
-		}
-	}
-	else
+	memory = _memory_allocate_pool( memory_context(), size, align, MEMORY_PERSISTENT );
+	if( !memory )
+		return 0;
+	if( oldsize )
+		memcpy( memory, p, ( size < oldsize ) ? (size_t)size : (size_t)oldsize );
+	_memory_deallocate_pool( p );
+
+	return memory;
+}
+
+
+static void _memory_thread_finalize_pool( void )
+{
+	memory_pool_cache_t* cache = get_thread_memory_pool_cache();
+	memory_pool_cache_t** link;
+	unsigned int iclass;
+
+	if( !cache )
+		return;
+
+	for( iclass = 0; iclass < MEMORY_POOL_CLASS_COUNT; ++iclass )
 	{
-		memory = _memory_allocate_malloc_raw( size, align, raw_p ? MEMORY_PERSISTENT_32BIT_ADDRESS : MEMORY_PERSISTENT );
-		if( p && memory && oldsize )
-			memcpy( memory, p, ( size < oldsize ) ? size : oldsize );
-		_memory_deallocate_malloc( p );
+		if( cache->bin[iclass].free )
+			_memory_pool_central_release( iclass, cache->bin[iclass].free );
 	}
-#else
-	if( !align && raw_p && !( (uintptr_t)raw_p & 1 ) )
+
+	_memory_spin_lock( &_memory_pool_lock );
+	for( link = &_memory_pool_caches; *link; link = &(*link)->next )
 	{
-		void* raw_memory = realloc( raw_p, (size_t)size + FOUNDATION_PLATFORM_POINTER_SIZE );
-		if( raw_memory )
+		if( *link == cache )
 		{
-			*(void**)raw_memory = raw_memory;
-			memory = pointer_offset( raw_memory, FOUNDATION_PLATFORM_POINTER_SIZE );
+			*link = cache->next;
+			break;
 		}
 	}
-	else
-	{
-		memory = _memory_allocate_malloc_raw( size, align, raw_p ? MEMORY_PERSISTENT_32BIT_ADDRESS : MEMORY_PERSISTENT );
-		if( p && memory && oldsize )
-			memcpy( memory, p, ( size < oldsize ) ? (size_t)size : (size_t)oldsize );
-		_memory_deallocate_malloc( p );
-	}
-#endif
-	if( !memory )
-	{
-		log_panicf( 0, ERROR_OUT_OF_MEMORY, "Unable to reallocate memory: %s", system_error_message( 0 ) );
-	}
-	return memory;
-#endif
+	_memory_spin_unlock( &_memory_pool_lock );
+
+	set_thread_memory_pool_cache( 0 );
+	_memory_deallocate_malloc( cache );
 }
 
 
-static int _memory_initialize_malloc( void )
+static int _memory_initialize_pool( void )
 {
-#if FOUNDATION_PLATFORM_WINDOWS && ( FOUNDATION_PLATFORM_POINTER_SIZE > 4 )
-	NtAllocateVirtualMemory = (NtAllocateVirtualMemoryFn)GetProcAddress( GetModuleHandleA( "ntdll.dll" ), "NtAllocateVirtualMemory" );
-#endif
-	return 0;
+	unsigned int iclass;
+
+	memset( _memory_pool_central, 0, sizeof( _memory_pool_central ) );
+	memset( _memory_pool_map, 0, sizeof( _memory_pool_map ) );
+	for( iclass = 0; iclass < MEMORY_POOL_CLASS_COUNT; ++iclass )
+	{
+		unsigned int batch;
+		_memory_pool_central[iclass].size = _memory_pool_class_size( iclass );
+		batch = MEMORY_POOL_MAX_SIZE / _memory_pool_central[iclass].size;
+		_memory_pool_central[iclass].batch = ( batch < 4 ) ? 4 : ( ( batch > 64 ) ? 64 : batch );
+	}
+
+	_memory_pool_lock = 0;
+	_memory_pool_span_free = 0;
+	_memory_pool_superblocks = 0;
+	_memory_pool_caches = 0;
+
+	return _memory_initialize_malloc();
 }
 
 
-static void _memory_shutdown_malloc( void )
+static void _memory_shutdown_pool( void )
 {
+	unsigned int imap;
+
+	set_thread_memory_pool_cache( 0 );
+	while( _memory_pool_caches )
+	{
+		memory_pool_cache_t* cache = _memory_pool_caches;
+		_memory_pool_caches = cache->next;
+		_memory_deallocate_malloc( cache );
+	}
+
+	while( _memory_pool_superblocks )
+	{
+		memory_pool_superblock_t* superblock = _memory_pool_superblocks;
+		_memory_pool_superblocks = superblock->next;
+		_memory_deallocate_malloc( superblock->memory );
+		_memory_deallocate_malloc( superblock );
+	}
+	_memory_pool_span_free = 0;
+
+	for( imap = 0; imap < MEMORY_POOL_MAP_SIZE; ++imap )
+	{
+		if( _memory_pool_map[imap] )
+			_memory_deallocate_malloc( _memory_pool_map[imap] );
+		_memory_pool_map[imap] = 0;
+	}
+	memset( _memory_pool_central, 0, sizeof( _memory_pool_central ) );
+
+	_memory_shutdown_malloc();
 }
 
 
-memory_system_t memory_system_malloc( void )
+memory_system_t memory_system_pool( void )
 {
 	memory_system_t memsystem;
-	memsystem.allocate = _memory_allocate_malloc;
-	memsystem.allocate_zero = _memory_allocate_zero_malloc;
-	memsystem.reallocate = _memory_reallocate_malloc;
-	memsystem.deallocate = _memory_deallocate_malloc;
-	memsystem.initialize = _memory_initialize_malloc;
-	memsystem.shutdown = _memory_shutdown_malloc;
+	memsystem.allocate = _memory_allocate_pool;
+	memsystem.allocate_zero = _memory_allocate_zero_pool;
+	memsystem.reallocate = _memory_reallocate_pool;
+	memsystem.deallocate = _memory_deallocate_pool;
+	memsystem.initialize = _memory_initialize_pool;
+	memsystem.shutdown = _memory_shutdown_pool;
+	memsystem.thread_finalize = _memory_thread_finalize_pool;
+	memsystem.allocate_batch = _memory_allocate_batch_pool;
+	memsystem.deallocate_batch = _memory_deallocate_batch_pool;
 	return memsystem;
 }
 
 
-#if BUILD_ENABLE_MEMORY_TRACKER
+#if BUILD_ENABLE_MEMORY_TRACKER || BUILD_ENABLE_MEMORY_SAMPLING
 
 
 void memory_set_tracker( memory_tracker_t tracker )
@@ -567,9 +2344,23 @@ static void _memory_untrack( void* addr )
 
 static void _memory_report( void )
 {
+	if( _memory_tracker.report )
+		_memory_tracker.report();
 }
 
 
+void memory_tracker_report( void )
+{
+	_memory_report();
+}
+
+
+#endif
+
+
+#if BUILD_ENABLE_MEMORY_TRACKER
+
+
 typedef struct ALIGN(8) _foundation_memory_tag
 {
 	void*         address;
@@ -577,86 +2368,469 @@ typedef struct ALIGN(8) _foundation_memory_tag
 	void*         trace[14];
 } memory_tag_t;
 
+//Tags are stored in a fixed number of shards selected by address hash, each shard is a linear probing
+//table with backward shift deletion protected by a spin lock and doubled in size at half load. Storage
+//is allocated directly from the memory system to avoid recursing into the tracker
+typedef struct ALIGN(64) _foundation_memory_tag_shard
+{
+	memory_tag_t*       tags;
+	uint32_t            capacity;
+	uint32_t            count;
+	volatile int32_t    lock;
+} memory_tag_shard_t;
+
+#define MEMORY_TAG_SHARD_BITS     6
+#define MEMORY_TAG_SHARDS         ( 1U << MEMORY_TAG_SHARD_BITS )
+#define MEMORY_TAG_SHARD_CAPACITY 256
+
+static memory_tag_shard_t _memory_tag_shards[MEMORY_TAG_SHARDS];
+
+
+static FORCEINLINE CONSTCALL uint64_t _memory_tag_hash( const void* addr )
+{
+	uint64_t key = (uint64_t)(uintptr_t)addr;
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	key *= 0xC4CEB9FE1A85EC53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+
+static bool _memory_tag_grow( memory_tag_shard_t* shard )
+{
+	uint32_t capacity = shard->capacity ? shard->capacity * 2 : MEMORY_TAG_SHARD_CAPACITY;
+	uint32_t mask = capacity - 1;
+	uint32_t itag, islot;
+	memory_tag_t* tags = _memsys.allocate_zero( MEMORYCONTEXT_GLOBAL, sizeof( memory_tag_t ) * capacity, 16, MEMORY_PERSISTENT );
+	if( !tags )
+		return false;
+
+	for( itag = 0; itag < shard->capacity; ++itag )
+	{
+		if( !shard->tags[itag].address )
+			continue;
+		islot = (uint32_t)_memory_tag_hash( shard->tags[itag].address ) & mask;
+		while( tags[islot].address )
+			islot = ( islot + 1 ) & mask;
+		tags[islot] = shard->tags[itag];
+	}
 
-hashtable_t*       _memory_table = 0;
-memory_tag_t*      _memory_tags = 0;
-ALIGN(8) int32_t   _memory_tag_next = 0;
+	if( shard->tags )
+		_memsys.deallocate( shard->tags );
+	shard->tags = tags;
+	shard->capacity = capacity;
 
-#define MAX_CONCURRENT_ALLOCATIONS 32 * 1024
+	return true;
+}
 
 
 static int _memory_tracker_initialize( void )
 {
 	log_debug( 0, "Initializing local memory tracker" );
-	if( !_memory_tags )
-		_memory_tags = memory_allocate_zero( sizeof( memory_tag_t ) * MAX_CONCURRENT_ALLOCATIONS, 16, MEMORY_PERSISTENT );
-	if( !_memory_table )
-		_memory_table = hashtable_allocate( MAX_CONCURRENT_ALLOCATIONS );
+	memset( _memory_tag_shards, 0, sizeof( _memory_tag_shards ) );
 	return 0;
 }
 
 
 static void _memory_tracker_shutdown( void )
 {
-	if( _memory_table )
-		hashtable_deallocate( _memory_table );
-	if( _memory_tags )
-	{
-		unsigned int it;
-		bool got_leaks = false;
+	unsigned int ishard, itag;
+	bool got_leaks = false;
 
-		log_debug( 0, "Checking for memory leaks" );
-		for( it = 0; it < MAX_CONCURRENT_ALLOCATIONS; ++it )
+	log_debug( 0, "Checking for memory leaks" );
+	for( ishard = 0; ishard < MEMORY_TAG_SHARDS; ++ishard )
+	{
+		memory_tag_shard_t* shard = _memory_tag_shards + ishard;
+		for( itag = 0; itag < shard->capacity; ++itag )
 		{
-			memory_tag_t* tag = _memory_tags + it;
+			memory_tag_t* tag = shard->tags + itag;
 			if( tag->address )
 			{
 				char* trace = stacktrace_resolve( tag->trace, 14, 0 );
-				log_warnf( 0, WARNING_MEMORY, "Memory leak: %d bytes @ " STRING_FORMAT_POINTER " : tag %d\n%s", (unsigned int)tag->size, tag->address, it, trace );
+				log_warnf( 0, WARNING_MEMORY, "Memory leak: %d bytes @ " STRING_FORMAT_POINTER " : tag %d:%d\n%s", (unsigned int)tag->size, tag->address, ishard, itag, trace );
 				string_deallocate( trace );
 				got_leaks = true;
 			}
 		}
-		memory_deallocate( _memory_tags );
-
-		if( !got_leaks )
-			log_debug( 0, "No memory leaks detected" );
+		if( shard->tags )
+			_memsys.deallocate( shard->tags );
+		shard->tags = 0;
+		shard->capacity = 0;
+		shard->count = 0;
 	}
+
+	if( !got_leaks )
+		log_debug( 0, "No memory leaks detected" );
 }
 
 
 static void _memory_tracker_track( void* addr, uint64_t size )
 {
-	if( addr ) do
+	memory_tag_t tag;
+	memory_tag_shard_t* shard;
+	uint64_t hash;
+	uint32_t mask, islot;
+
+	if( !addr )
+		return;
+
+	tag.address = addr;
+	tag.size = (uintptr_t)size;
+	stacktrace_capture( tag.trace, 14, 3 );
+
+	hash = _memory_tag_hash( addr );
+	shard = _memory_tag_shards + ( hash >> ( 64 - MEMORY_TAG_SHARD_BITS ) );
+
+	_memory_spin_lock( &shard->lock );
+	if( ( ( shard->count + 1 ) * 2 > shard->capacity ) && !_memory_tag_grow( shard ) && ( shard->count + 1 >= shard->capacity ) )
+	{
+		_memory_spin_unlock( &shard->lock );
+		return;
+	}
+	mask = shard->capacity - 1;
+	islot = (uint32_t)hash & mask;
+	while( shard->tags[islot].address )
+		islot = ( islot + 1 ) & mask;
+	shard->tags[islot] = tag;
+	++shard->count;
+	_memory_spin_unlock( &shard->lock );
+}
+
+
+static void _memory_tracker_untrack( void* addr )
+{
+	memory_tag_shard_t* shard;
+	uint64_t hash;
+	uint32_t mask, islot, inext, ihome;
+
+	if( !addr )
+		return;
+
+	hash = _memory_tag_hash( addr );
+	shard = _memory_tag_shards + ( hash >> ( 64 - MEMORY_TAG_SHARD_BITS ) );
+
+	_memory_spin_lock( &shard->lock );
+	mask = shard->capacity - 1;
+	islot = (uint32_t)hash & mask;
+	while( shard->capacity && shard->tags[islot].address )
 	{
-		int32_t tag = atomic_exchange_and_add32( &_memory_tag_next, 1 );
-		if( tag >= MAX_CONCURRENT_ALLOCATIONS )
+		if( shard->tags[islot].address == addr )
 		{
-			int32_t newtag = tag % MAX_CONCURRENT_ALLOCATIONS;
-			atomic_cas32( &_memory_tag_next, newtag, tag + 1 );
-			tag = newtag;
+			//Shift following entries back into the hole unless that would move them before their home slot
+			for( inext = ( islot + 1 ) & mask; shard->tags[inext].address; inext = ( inext + 1 ) & mask )
+			{
+				ihome = (uint32_t)_memory_tag_hash( shard->tags[inext].address ) & mask;
+				if( ( ( inext - ihome ) & mask ) >= ( ( inext - islot ) & mask ) )
+				{
+					shard->tags[islot] = shard->tags[inext];
+					islot = inext;
+				}
+			}
+			shard->tags[islot].address = 0;
+			--shard->count;
+			break;
 		}
-		if( !_memory_tags[ tag ].address && atomic_cas_ptr( &_memory_tags[ tag ].address, addr, 0 ) )
+		islot = ( islot + 1 ) & mask;
+	}
+	_memory_spin_unlock( &shard->lock );
+}
+
+
+#endif
+
+
+#if BUILD_ENABLE_MEMORY_SAMPLING
+
+
+//Sampling tracker, samples allocations at exponentially distributed byte intervals (Poisson process)
+//and aggregates live sampled allocations by deduplicated call site
+#define MEMORY_SAMPLE_DEPTH           14
+#define MEMORY_SAMPLE_FILTER_BITS     16
+#define MEMORY_SAMPLE_FILTER_SIZE     ( 1U << MEMORY_SAMPLE_FILTER_BITS )
+#define MEMORY_SAMPLE_REPORT_SITES    16
+
+typedef struct _foundation_memory_sample
+{
+	void*         address;
+	uint64_t      weight;
+	uint32_t      site;
+	uint32_t      next;
+} memory_sample_t;
+
+typedef struct _foundation_memory_sample_site
+{
+	hash_t        hash;
+	void*         trace[MEMORY_SAMPLE_DEPTH];
+	uint64_t      live_bytes;
+	uint64_t      live_samples;
+	uint64_t      total_bytes;
+	uint64_t      total_samples;
+} memory_sample_site_t;
+
+//Samples and sites are indexed from 1, index 0 is used as null marker. The filter holds the number of
+//live samples per address hash, letting deallocations of unsampled memory skip the lock
+static memory_sample_t*       _memory_samples = 0;
+static uint32_t*              _memory_sample_buckets = 0;
+static uint32_t               _memory_sample_free = 0;
+static memory_sample_site_t*  _memory_sample_sites = 0;
+static uint32_t               _memory_sample_site_count = 0;
+static uint16_t*              _memory_sample_filter = 0;
+static uint64_t               _memory_sample_dropped = 0;
+static volatile int32_t       _memory_sample_lock = 0;
+static volatile int64_t       _memory_sample_seed = 0;
+
+FOUNDATION_DECLARE_THREAD_LOCAL( intptr_t, memory_sample_remain, 0 )
+FOUNDATION_DECLARE_THREAD_LOCAL( int, memory_sample_busy, 0 )
+
+
+static FORCEINLINE CONSTCALL uint32_t _memory_sample_address_hash( const void* addr, unsigned int bits )
+{
+	return (uint32_t)( ( (uint64_t)(uintptr_t)addr * 0x9E3779B97F4A7C15ULL ) >> ( 64 - bits ) );
+}
+
+
+static intptr_t _memory_sample_next_interval( void )
+{
+	//Exponentially distributed interval with the configured mean from a shared splitmix64 sequence
+	uint64_t value = (uint64_t)atomic_add64( &_memory_sample_seed, (int64_t)0x9E3779B97F4A7C15ULL );
+	real uniform;
+	real interval;
+	value = ( value ^ ( value >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	value = ( value ^ ( value >> 27 ) ) * 0x94D049BB133111EBULL;
+	value = value ^ ( value >> 31 );
+	uniform = (real)( ( value >> 11 ) + 1 ) * REAL_C( 1.1102230246251565e-16 );
+	interval = -math_logn( uniform ) * (real)_memory_sample_interval;
+	if( interval < REAL_C( 1.0 ) )
+		return 1;
+	if( interval > (real)( INTPTR_MAX / 2 ) )
+		return INTPTR_MAX / 2;
+	return (intptr_t)interval;
+}
+
+
+static memory_sample_site_t* _memory_sample_site( hash_t hash, void** trace )
+{
+	uint32_t isite = (uint32_t)( hash % BUILD_SIZE_MEMORY_SAMPLE_SITES );
+	uint32_t iprobe;
+	for( iprobe = 0; iprobe < BUILD_SIZE_MEMORY_SAMPLE_SITES; ++iprobe )
+	{
+		memory_sample_site_t* site = _memory_sample_sites + isite;
+		if( !site->total_samples )
 		{
-			_memory_tags[ tag ].size = (uintptr_t)size;
-			stacktrace_capture( _memory_tags[ tag ].trace, 14, 3 );
-			hashtable_set( _memory_table, (uintptr_t)addr, (uintptr_t)( tag + 1 ) );
-			return;
+			site->hash = hash;
+			memcpy( site->trace, trace, sizeof( site->trace ) );
+			++_memory_sample_site_count;
+			return site;
 		}
-	} while( true );
+		if( ( site->hash == hash ) && !memcmp( site->trace, trace, sizeof( site->trace ) ) )
+			return site;
+		if( ++isite == BUILD_SIZE_MEMORY_SAMPLE_SITES )
+			isite = 0;
+	}
+	return 0;
 }
 
 
-static void _memory_tracker_untrack( void* addr )
+static void _memory_sample_record( void* addr, uint64_t size )
+{
+	void* trace[MEMORY_SAMPLE_DEPTH];
+	memory_sample_site_t* site;
+	memory_sample_t* sample;
+	uint32_t isample, ibucket;
+	uint64_t weight;
+	hash_t tracehash;
+	real ratio = (real)size / (real)_memory_sample_interval;
+
+	//Each sample represents the bytes expected to be allocated between samples of this size
+	weight = ( ratio < REAL_C( 64.0 ) ) ? (uint64_t)( (real)size / ( REAL_C( 1.0 ) - math_exp( -ratio ) ) ) : size;
+
+	set_thread_memory_sample_busy( 1 );
+
+	memset( trace, 0, sizeof( trace ) );
+	stacktrace_capture( trace, MEMORY_SAMPLE_DEPTH, 4 );
+	tracehash = hash( trace, sizeof( trace ) );
+
+	_memory_spin_lock( &_memory_sample_lock );
+
+	isample = _memory_sample_free;
+	site = isample ? _memory_sample_site( tracehash, trace ) : 0;
+	if( site )
+	{
+		sample = _memory_samples + isample;
+		_memory_sample_free = sample->next;
+
+		ibucket = _memory_sample_address_hash( addr, MEMORY_SAMPLE_FILTER_BITS ) % BUILD_SIZE_MEMORY_SAMPLES;
+		sample->address = addr;
+		sample->weight = weight;
+		sample->site = (uint32_t)( site - _memory_sample_sites ) + 1;
+		sample->next = _memory_sample_buckets[ibucket];
+		_memory_sample_buckets[ibucket] = isample;
+
+		++_memory_sample_filter[ _memory_sample_address_hash( addr, MEMORY_SAMPLE_FILTER_BITS ) ];
+
+		site->live_bytes += weight;
+		++site->live_samples;
+		site->total_bytes += weight;
+		++site->total_samples;
+	}
+	else
+	{
+		++_memory_sample_dropped;
+	}
+
+	_memory_spin_unlock( &_memory_sample_lock );
+
+	set_thread_memory_sample_busy( 0 );
+}
+
+
+static void _memory_sample_track( void* addr, uint64_t size )
+{
+	intptr_t remain;
+	if( !addr )
+		return;
+
+	remain = get_thread_memory_sample_remain();
+	if( !remain )
+		remain = _memory_sample_next_interval();
+	remain -= (intptr_t)size;
+	if( remain > 0 )
+	{
+		set_thread_memory_sample_remain( remain );
+		return;
+	}
+	set_thread_memory_sample_remain( _memory_sample_next_interval() );
+
+	if( !get_thread_memory_sample_busy() )
+		_memory_sample_record( addr, size );
+}
+
+
+static void _memory_sample_untrack( void* addr )
+{
+	uint32_t ifilter, ibucket, isample;
+	uint32_t* link;
+
+	if( !addr )
+		return;
+
+	ifilter = _memory_sample_address_hash( addr, MEMORY_SAMPLE_FILTER_BITS );
+	if( !_memory_sample_filter[ifilter] )
+		return;
+
+	ibucket = ifilter % BUILD_SIZE_MEMORY_SAMPLES;
+
+	_memory_spin_lock( &_memory_sample_lock );
+
+	link = _memory_sample_buckets + ibucket;
+	for( isample = *link; isample; link = &_memory_samples[isample].next, isample = *link )
+	{
+		memory_sample_t* sample = _memory_samples + isample;
+		if( sample->address == addr )
+		{
+			memory_sample_site_t* site = _memory_sample_sites + ( sample->site - 1 );
+			site->live_bytes -= sample->weight;
+			--site->live_samples;
+			--_memory_sample_filter[ifilter];
+
+			*link = sample->next;
+			sample->address = 0;
+			sample->next = _memory_sample_free;
+			_memory_sample_free = isample;
+			break;
+		}
+	}
+
+	_memory_spin_unlock( &_memory_sample_lock );
+}
+
+
+static void _memory_sample_report( void )
 {
-	uintptr_t tag = addr ? hashtable_get( _memory_table, (uintptr_t)addr ) : 0;
-	if( tag )
+	memory_sample_site_t top[MEMORY_SAMPLE_REPORT_SITES];
+	unsigned int num_top = 0;
+	unsigned int isite, itop;
+	uint64_t live_bytes = 0;
+	uint64_t live_samples = 0;
+	uint32_t num_sites;
+	uint64_t dropped;
+
+	if( !_memory_sample_sites )
+		return;
+
+	//Copy out the call sites with most live bytes while holding the lock, resolve and log after releasing it
+	_memory_spin_lock( &_memory_sample_lock );
+	for( isite = 0; isite < BUILD_SIZE_MEMORY_SAMPLE_SITES; ++isite )
+	{
+		const memory_sample_site_t* site = _memory_sample_sites + isite;
+		if( !site->live_samples )
+			continue;
+		live_bytes += site->live_bytes;
+		live_samples += site->live_samples;
+		for( itop = num_top; ( itop > 0 ) && ( top[itop-1].live_bytes < site->live_bytes ); --itop )
+		{
+			if( itop < MEMORY_SAMPLE_REPORT_SITES )
+				top[itop] = top[itop-1];
+		}
+		if( itop < MEMORY_SAMPLE_REPORT_SITES )
+		{
+			top[itop] = *site;
+			if( num_top < MEMORY_SAMPLE_REPORT_SITES )
+				++num_top;
+		}
+	}
+	num_sites = _memory_sample_site_count;
+	dropped = _memory_sample_dropped;
+	_memory_spin_unlock( &_memory_sample_lock );
+
+	log_infof( 0, "Sampled live heap: ~%llu bytes in %llu samples, %u call sites (interval %llu bytes, %llu samples dropped)", live_bytes, live_samples, num_sites, _memory_sample_interval, dropped );
+	for( itop = 0; itop < num_top; ++itop )
 	{
-		--tag;
-		_memory_tags[ tag ].address = 0;
+		char* trace = stacktrace_resolve( top[itop].trace, MEMORY_SAMPLE_DEPTH, 0 );
+		log_infof( 0, "~%llu bytes live in %llu samples (~%llu bytes in %llu samples total) @\n%s", top[itop].live_bytes, top[itop].live_samples, top[itop].total_bytes, top[itop].total_samples, trace );
+		string_deallocate( trace );
 	}
-	//else if( addr )
-	//	log_warnf( 0, WARNING_SUSPICIOUS, "Untracked deallocation: " STRING_FORMAT_POINTER, addr );
+}
+
+
+static int _memory_sample_initialize( void )
+{
+	uint32_t isample;
+
+	log_debugf( 0, "Initializing sampling memory tracker (interval %llu bytes)", _memory_sample_interval );
+
+	_memory_samples = memory_allocate_zero( sizeof( memory_sample_t ) * ( BUILD_SIZE_MEMORY_SAMPLES + 1 ), 16, MEMORY_PERSISTENT );
+	_memory_sample_buckets = memory_allocate_zero( sizeof( uint32_t ) * BUILD_SIZE_MEMORY_SAMPLES, 16, MEMORY_PERSISTENT );
+	_memory_sample_sites = memory_allocate_zero( sizeof( memory_sample_site_t ) * BUILD_SIZE_MEMORY_SAMPLE_SITES, 16, MEMORY_PERSISTENT );
+	_memory_sample_filter = memory_allocate_zero( sizeof( uint16_t ) * MEMORY_SAMPLE_FILTER_SIZE, 16, MEMORY_PERSISTENT );
+
+	for( isample = 1; isample < BUILD_SIZE_MEMORY_SAMPLES; ++isample )
+		_memory_samples[isample].next = isample + 1;
+	_memory_sample_free = 1;
+	_memory_sample_site_count = 0;
+	_memory_sample_dropped = 0;
+	_memory_sample_seed = (int64_t)time_current();
+
+	return 0;
+}
+
+
+static void _memory_sample_shutdown( void )
+{
+	_memory_sample_report();
+
+	memory_deallocate( _memory_samples );
+	memory_deallocate( _memory_sample_buckets );
+	memory_deallocate( _memory_sample_sites );
+	memory_deallocate( _memory_sample_filter );
+
+	_memory_samples = 0;
+	_memory_sample_buckets = 0;
+	_memory_sample_sites = 0;
+	_memory_sample_filter = 0;
+	_memory_sample_free = 0;
 }
 
 
@@ -674,3 +2848,17 @@ memory_tracker_t memory_tracker_local( void )
 #endif
 	return tracker;
 }
+
+
+memory_tracker_t memory_tracker_sampling( void )
+{
+	memory_tracker_t tracker = {0};
+#if BUILD_ENABLE_MEMORY_SAMPLING
+	tracker.track = _memory_sample_track;
+	tracker.untrack = _memory_sample_untrack;
+	tracker.initialize = _memory_sample_initialize;
+	tracker.shutdown = _memory_sample_shutdown;
+	tracker.report = _memory_sample_report;
+#endif
+	return tracker;
+}
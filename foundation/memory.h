@@ -25,6 +25,32 @@ FOUNDATION_API void*             memory_allocate_context( uint16_t context, uint
 FOUNDATION_API void*             memory_allocate_zero_context( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint );
 FOUNDATION_API void*             memory_reallocate( void* p, uint64_t size, unsigned int align, uint64_t oldsize );
 FOUNDATION_API void              memory_deallocate( void* p );
+FOUNDATION_API unsigned int      memory_allocate_batch( unsigned int count, uint64_t size, unsigned int align, memory_hint_t hint, void** ptrs );
+FOUNDATION_API void              memory_deallocate_batch( void** ptrs, unsigned int count );
+
+FOUNDATION_API void              memory_thread_deallocate( void );
+
+FOUNDATION_API uint64_t          memory_temporary_wraps( void );
+
+FOUNDATION_API void              memory_arena_initialize( memory_arena_t* arena, uint64_t chunksize );
+FOUNDATION_API void              memory_arena_destroy( memory_arena_t* arena );
+FOUNDATION_API void*             memory_arena_allocate( memory_arena_t* arena, uint64_t size, unsigned int align );
+FOUNDATION_API memory_arena_mark_t memory_arena_mark( const memory_arena_t* arena );
+FOUNDATION_API void              memory_arena_reset_to_mark( memory_arena_t* arena, memory_arena_mark_t mark );
+FOUNDATION_API void              memory_arena_reset( memory_arena_t* arena );
+
+FOUNDATION_API void*             memory_reserve_virtual( uint64_t size );
+FOUNDATION_API bool              memory_commit( void* p, uint64_t size );
+FOUNDATION_API void              memory_decommit( void* p, uint64_t size );
+FOUNDATION_API void              memory_release_virtual( void* p, uint64_t size );
+
+FOUNDATION_API memory_statistics_t memory_statistics( uint16_t context );
+FOUNDATION_API unsigned int      memory_statistics_contexts( uint16_t* contexts, unsigned int capacity );
+
+FOUNDATION_API void              memory_set_budget( uint16_t context, uint64_t soft, uint64_t hard );
+FOUNDATION_API memory_pressure_t memory_pressure( uint16_t context );
+FOUNDATION_API bool              memory_pressure_register( memory_pressure_fn callback );
+FOUNDATION_API void              memory_pressure_unregister( memory_pressure_fn callback );
 
 #if BUILD_ENABLE_MEMORY_CONTEXT
 
@@ -42,15 +68,19 @@ FOUNDATION_API void              memory_context_thread_deallocate( void );
 
 #endif
 
-#if BUILD_ENABLE_MEMORY_TRACKER
+#if BUILD_ENABLE_MEMORY_TRACKER || BUILD_ENABLE_MEMORY_SAMPLING
 
 FOUNDATION_API void              memory_set_tracker( memory_tracker_t tracker );
+FOUNDATION_API void              memory_tracker_report( void );
 
 #else
 
 #define memory_set_tracker( tracker )       /*lint -save -e506 -e751 */ do { (void)sizeof( tracker ); } while(0) /*lint -restore -e506 -e751 */
+#define memory_tracker_report()             do { /* */ } while(0)
 
 #endif
 
 FOUNDATION_API memory_system_t   memory_system_malloc( void );
+FOUNDATION_API memory_system_t   memory_system_pool( void );
 FOUNDATION_API memory_tracker_t  memory_tracker_local( void );
+FOUNDATION_API memory_tracker_t  memory_tracker_sampling( void );
@@ -0,0 +1,273 @@
+/* mempool.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <foundation/foundation.h>
+#include <foundation/internal.h>
+
+
+//Objects are carved from slabs linked through the first pointer in the slab, free objects are linked
+//through their first pointer. Each thread owns one magazine slot in every pool which it accesses without
+//locking, magazines are refilled from and flushed to the shared free list in batches of half a magazine
+#define MEMPOOL_SLAB_SIZE          ( 16 * 1024 )
+#define MEMPOOL_SLAB_MIN_OBJECTS   8
+#define MEMPOOL_BATCH              ( BUILD_SIZE_MEMPOOL_MAGAZINE / 2 )
+#define MEMPOOL_THREAD_SHARED      -1
+
+static volatile int32_t            _mempool_thread_used[BUILD_SIZE_MEMPOOL_THREADS];
+static mempool_t*                  _mempool_pools = 0;
+static volatile int32_t            _mempool_pools_lock = 0;
+
+FOUNDATION_DECLARE_THREAD_LOCAL( int, mempool_thread, 0 )
+
+
+static FORCEINLINE void _mempool_lock( volatile int32_t* lock )
+{
+	while( !atomic_cas32( lock, 1, 0 ) )
+		thread_yield();
+}
+
+
+static FORCEINLINE void _mempool_unlock( volatile int32_t* lock )
+{
+	atomic_cas32( lock, 0, 1 );
+}
+
+
+static int _mempool_thread_slot( void )
+{
+	int slot = get_thread_mempool_thread();
+	int islot;
+
+	if( slot > 0 )
+		return slot - 1;
+	if( slot == MEMPOOL_THREAD_SHARED )
+		return -1;
+
+	for( islot = 0; islot < BUILD_SIZE_MEMPOOL_THREADS; ++islot )
+	{
+		if( !_mempool_thread_used[islot] && atomic_cas32( &_mempool_thread_used[islot], 1, 0 ) )
+		{
+			set_thread_mempool_thread( islot + 1 );
+			return islot;
+		}
+	}
+
+	set_thread_mempool_thread( MEMPOOL_THREAD_SHARED );
+	return -1;
+}
+
+
+static void _mempool_setup( mempool_t* pool )
+{
+	_mempool_lock( &_mempool_pools_lock );
+	if( !pool->stride )
+	{
+		unsigned int align = ( pool->align > FOUNDATION_PLATFORM_POINTER_SIZE ) ? math_align_poweroftwo( pool->align ) : FOUNDATION_PLATFORM_POINTER_SIZE;
+		unsigned int size = ( pool->size > FOUNDATION_PLATFORM_POINTER_SIZE ) ? pool->size : FOUNDATION_PLATFORM_POINTER_SIZE;
+
+		unsigned int stride = ( size + align - 1 ) & ~( align - 1 );
+
+		pool->align = align;
+		pool->slab_objects = ( MEMPOOL_SLAB_SIZE - align ) / stride;
+		if( pool->slab_objects < MEMPOOL_SLAB_MIN_OBJECTS )
+			pool->slab_objects = MEMPOOL_SLAB_MIN_OBJECTS;
+		pool->next = _mempool_pools;
+		_mempool_pools = pool;
+
+		//Publish stride last, it marks the pool as set up
+		pool->stride = stride;
+	}
+	_mempool_unlock( &_mempool_pools_lock );
+}
+
+
+static bool _mempool_grow( mempool_t* pool )
+{
+	//First object starts after the slab link, at the object alignment
+	unsigned int iobj;
+	void* slab = memory_allocate_context( pool->context, pool->align + ( (uint64_t)pool->stride * pool->slab_objects ), pool->align, MEMORY_PERSISTENT );
+	void* object;
+	if( !slab )
+		return false;
+
+	*(void**)slab = pool->slabs;
+	pool->slabs = slab;
+
+	object = pointer_offset( slab, pool->align );
+	for( iobj = 0; iobj < pool->slab_objects - 1; ++iobj, object = pointer_offset( object, pool->stride ) )
+		*(void**)object = pointer_offset( object, pool->stride );
+	*(void**)object = pool->free;
+	pool->free = pointer_offset( slab, pool->align );
+
+	return true;
+}
+
+
+static unsigned int _mempool_fetch( mempool_t* pool, void** objects, unsigned int count )
+{
+	unsigned int iobj;
+
+	if( !pool->stride )
+		_mempool_setup( pool );
+
+	_mempool_lock( &pool->lock );
+	for( iobj = 0; iobj < count; ++iobj )
+	{
+		if( !pool->free && !_mempool_grow( pool ) )
+			break;
+		objects[iobj] = pool->free;
+		pool->free = *(void**)pool->free;
+	}
+	_mempool_unlock( &pool->lock );
+
+	return iobj;
+}
+
+
+static void _mempool_return( mempool_t* pool, void** objects, unsigned int count )
+{
+	unsigned int iobj;
+
+	_mempool_lock( &pool->lock );
+	for( iobj = 0; iobj < count; ++iobj )
+	{
+		*(void**)objects[iobj] = pool->free;
+		pool->free = objects[iobj];
+	}
+	_mempool_unlock( &pool->lock );
+}
+
+
+void mempool_initialize( mempool_t* pool, unsigned int size, unsigned int align, uint16_t context )
+{
+	memset( pool, 0, sizeof( mempool_t ) );
+	pool->size = size;
+	pool->align = align;
+	pool->context = context;
+}
+
+
+void mempool_destroy( mempool_t* pool )
+{
+	mempool_t** link;
+	void* slab;
+
+	_mempool_lock( &_mempool_pools_lock );
+	for( link = &_mempool_pools; *link; link = &(*link)->next )
+	{
+		if( *link == pool )
+		{
+			*link = pool->next;
+			break;
+		}
+	}
+	_mempool_unlock( &_mempool_pools_lock );
+
+	slab = pool->slabs;
+	while( slab )
+	{
+		void* next = *(void**)slab;
+		memory_deallocate( slab );
+		slab = next;
+	}
+
+	//Keep object size, alignment and context to allow reuse of statically initialized pools
+	mempool_initialize( pool, pool->size, pool->align, pool->context );
+}
+
+
+void* mempool_allocate( mempool_t* pool )
+{
+	void* object = 0;
+	int slot = _mempool_thread_slot();
+	if( slot >= 0 )
+	{
+		mempool_magazine_t* magazine = pool->magazine + slot;
+		if( !magazine->count )
+			magazine->count = _mempool_fetch( pool, magazine->objects, MEMPOOL_BATCH );
+		if( magazine->count )
+			object = magazine->objects[ --magazine->count ];
+	}
+	else
+	{
+		_mempool_fetch( pool, &object, 1 );
+	}
+	return object;
+}
+
+
+void* mempool_allocate_zero( mempool_t* pool )
+{
+	void* object = mempool_allocate( pool );
+	if( object )
+		memset( object, 0, pool->size );
+	return object;
+}
+
+
+void mempool_deallocate( mempool_t* pool, void* p )
+{
+	int slot;
+	if( !p )
+		return;
+
+	slot = _mempool_thread_slot();
+	if( slot >= 0 )
+	{
+		mempool_magazine_t* magazine = pool->magazine + slot;
+		if( magazine->count == BUILD_SIZE_MEMPOOL_MAGAZINE )
+		{
+			magazine->count -= MEMPOOL_BATCH;
+			_mempool_return( pool, magazine->objects + magazine->count, MEMPOOL_BATCH );
+		}
+		magazine->objects[ magazine->count++ ] = p;
+	}
+	else
+	{
+		_mempool_return( pool, &p, 1 );
+	}
+}
+
+
+void mempool_thread_deallocate( void )
+{
+	int slot = get_thread_mempool_thread();
+	if( slot > 0 )
+	{
+		mempool_t* pool;
+		--slot;
+
+		_mempool_lock( &_mempool_pools_lock );
+		for( pool = _mempool_pools; pool; pool = pool->next )
+		{
+			mempool_magazine_t* magazine = pool->magazine + slot;
+			if( magazine->count )
+				_mempool_return( pool, magazine->objects, magazine->count );
+			magazine->count = 0;
+		}
+		_mempool_unlock( &_mempool_pools_lock );
+
+		atomic_cas32( &_mempool_thread_used[slot], 0, 1 );
+	}
+	set_thread_mempool_thread( 0 );
+}
+
+
+void _mempool_shutdown( void )
+{
+	int islot;
+	mempool_thread_deallocate();
+	while( _mempool_pools )
+		mempool_destroy( _mempool_pools );
+	for( islot = 0; islot < BUILD_SIZE_MEMPOOL_THREADS; ++islot )
+		_mempool_thread_used[islot] = 0;
+}
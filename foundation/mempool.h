@@ -0,0 +1,58 @@
+/* mempool.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ * 
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ * 
+ * https://github.com/rampantpixels/foundation_lib
+ * 
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file mempool.h
+    Fixed size object pool with per-thread caches of free objects */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+
+/*! Static initializer for a pool, for pools with static storage that are used before
+    any initialization function can be called. Statically initialized pools are destroyed
+    when the memory system shuts down
+    \param size                     Object size
+    \param align                    Object alignment
+    \param context                  Memory context slabs are allocated in */
+#define MEMPOOL_INITIALIZER( size, align, context ) { (size), (align), (context) }
+
+/*! Initialize a pool
+    \param pool                     Pool
+    \param size                     Object size
+    \param align                    Object alignment
+    \param context                  Memory context slabs are allocated in */
+FOUNDATION_API void                 mempool_initialize( mempool_t* pool, unsigned int size, unsigned int align, uint16_t context );
+
+/*! Free all memory used by the pool. All objects allocated from the pool are invalid after this call
+    \param pool                     Pool */
+FOUNDATION_API void                 mempool_destroy( mempool_t* pool );
+
+/*! Allocate an object from the pool
+    \param pool                     Pool
+    \return                         Object, uninitialized memory */
+FOUNDATION_API void*                mempool_allocate( mempool_t* pool );
+
+/*! Allocate an object from the pool and zero the memory
+    \param pool                     Pool
+    \return                         Object */
+FOUNDATION_API void*                mempool_allocate_zero( mempool_t* pool );
+
+/*! Return an object to the pool it was allocated from
+    \param pool                     Pool
+    \param p                        Object */
+FOUNDATION_API void                 mempool_deallocate( mempool_t* pool, void* p );
+
+/*! Return the objects cached by the calling thread to the pools and release the thread cache slot.
+    Called automatically by thread_cleanup() */
+FOUNDATION_API void                 mempool_thread_deallocate( void );
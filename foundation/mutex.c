@@ -101,9 +101,12 @@ static void _mutex_shutdown( mutex_t* mutex )
 }
 
 
+static mempool_t _mutex_pool = MEMPOOL_INITIALIZER( sizeof( mutex_t ), 16, MEMORYCONTEXT_GLOBAL );
+
+
 mutex_t* mutex_allocate( const char* name )
 {
-	mutex_t* mutex = memory_allocate_zero( sizeof( mutex_t ), 16, MEMORY_PERSISTENT );
+	mutex_t* mutex = mempool_allocate_zero( &_mutex_pool );
 
 	_mutex_initialize( mutex, name );
 
@@ -118,7 +121,7 @@ void mutex_deallocate( mutex_t* mutex )
 
 	_mutex_shutdown( mutex );
 
-	memory_deallocate( mutex );
+	mempool_deallocate( &_mutex_pool, mutex );
 }
 
 
@@ -131,6 +131,9 @@
 #ifndef FOUNDATION_ARCH_SSE4_FMA3
 #  define FOUNDATION_ARCH_SSE4_FMA3 0
 #endif
+#ifndef FOUNDATION_ARCH_AVX2
+#  define FOUNDATION_ARCH_AVX2 0
+#endif
 #ifndef FOUNDATION_ARCH_NEON
 #  define FOUNDATION_ARCH_NEON 0
 #endif
@@ -482,6 +485,11 @@
 #  define FOUNDATION_ARCH_SSE4 1
 #endif
 
+#ifdef __AVX2__
+#  undef  FOUNDATION_ARCH_AVX2
+#  define FOUNDATION_ARCH_AVX2 1
+#endif
+
 #ifdef __ARM_NEON__
 #  undef  FOUNDATION_ARCH_NEON
 #  define FOUNDATION_ARCH_NEON 1
@@ -516,6 +524,7 @@
 #  define PURECALL ATTRIBUTE(pure)
 #  define CONSTCALL ATTRIBUTE(const)
 #  define ALIGN(x) ATTRIBUTE2(aligned,x)
+#  define PREFETCH(x) __builtin_prefetch( (x) )
 
 #  if FOUNDATION_PLATFORM_WINDOWS
 #    define STDCALL
@@ -547,6 +556,7 @@
 #  define PURECALL ATTRIBUTE(pure)
 #  define CONSTCALL ATTRIBUTE(const)
 #  define ALIGN(x) ATTRIBUTE2(aligned,x)
+#  define PREFETCH(x) __builtin_prefetch( (x) )
 
 #  include <stdbool.h>
 #  include <stdarg.h>
@@ -578,6 +588,7 @@
 #  define PURECALL 
 #  define CONSTCALL
 #  define ALIGN(x) __declspec(align(x))
+#  define PREFETCH(x) _mm_prefetch( (const char*)(x), _MM_HINT_T0 )
 
 #  if FOUNDATION_PLATFORM_WINDOWS
 #    define STDCALL __stdcall
@@ -608,11 +619,14 @@
 #  define PURECALL
 #  define CONSTCALL
 #  define ALIGN(x) __declspec(align(x))
+#  define PREFETCH(x) _mm_prefetch( (const char*)(x), _MM_HINT_T0 )
 
 #  if FOUNDATION_PLATFORM_WINDOWS
 #    define STDCALL __stdcall
 #  endif
 
+#  include <intrin.h>
+
 #  ifndef __cplusplus
 typedef enum
 {
@@ -52,6 +52,7 @@ struct _profile_block
 #define PROFILE_ID_UNLOCKCONTINUE   10
 #define PROFILE_ID_WAIT             11
 #define PROFILE_ID_SIGNAL           12
+#define PROFILE_ID_MEMORYSTATISTICS 13
 
 #define GET_BLOCK( index )          ( _profile_blocks + (index) )
 #define BLOCK_INDEX( block )        (uint16_t)((uintptr_t)( (block) - _profile_blocks ))
@@ -240,6 +241,36 @@ static void _profile_process_root_block( volatile profile_block_t* blockptr )
 }
 
 
+//Memory statistics block stores context in parentid, current/peak bytes in start/end and
+//allocation/deallocation counts and total allocated bytes in name
+static void _profile_write_memory_statistics( void )
+{
+	uint16_t contexts[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+	unsigned int icontext, num_contexts;
+	profile_block_t block;
+
+	if( !_profile_write )
+		return;
+
+	num_contexts = memory_statistics_contexts( contexts, BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS );
+	if( num_contexts > BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS )
+		num_contexts = BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS;
+
+	for( icontext = 0; icontext < num_contexts; ++icontext )
+	{
+		memory_statistics_t stats = memory_statistics( contexts[icontext] );
+		uint64_t counts[3] = { stats.allocations, stats.deallocations, stats.allocated_total };
+		memset( &block, 0, sizeof( profile_block_t ) );
+		block.data.id = PROFILE_ID_MEMORYSTATISTICS;
+		block.data.parentid = contexts[icontext];
+		block.data.start = stats.allocated_current;
+		block.data.end = stats.allocated_peak;
+		memcpy( block.data.name, counts, sizeof( counts ) );
+		_profile_write( &block, sizeof( profile_block_t ) );
+	}
+}
+
+
 static void* _profile_io( object_t thread, void* arg )
 {
 	unsigned int system_info_counter = 0;
@@ -274,6 +305,7 @@ static void* _profile_io( object_t thread, void* arg )
 		{
 			if( _profile_write )
 				_profile_write( &system_info, sizeof( profile_block_t ) );
+			_profile_write_memory_statistics();
 			system_info_counter = 0;
 		}
 
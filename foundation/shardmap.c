@@ -0,0 +1,265 @@
+/* shardmap.c  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <foundation/foundation.h>
+#include <foundation/internal.h>
+
+
+//Each shard is a Robin Hood table as in hashmap (see internal.h), guarded by a sequence counter which is odd while a
+//writer holds the shard. Readers sample the counter, probe the table and retry if the counter changed.
+//Tables replaced when a shard grows are kept until the map is deallocated since a concurrent reader
+//may still be probing them
+#define SHARDMAP_SHARD_STRIDE      64
+
+typedef struct _foundation_shardmap_table
+{
+	robinhood_table_t                    base;
+	struct _foundation_shardmap_table*   retired;
+} shardmap_table_t;
+
+typedef struct _foundation_shardmap_shard
+{
+	volatile int32_t                     sequence;
+	unsigned int                         num_nodes;
+	shardmap_table_t* volatile           table;
+	//Pad to a cache line to avoid false sharing between writers of neighbouring shards
+	char                                 pad[ SHARDMAP_SHARD_STRIDE - sizeof( int32_t ) - sizeof( unsigned int ) - sizeof( void* ) ];
+} shardmap_shard_t;
+
+struct _foundation_shardmap
+{
+	unsigned int                         num_shards;
+	unsigned int                         shard_shift;
+	shardmap_shard_t*                    shard;
+};
+
+
+static FORCEINLINE shardmap_shard_t* _shardmap_shard( const shardmap_t* map, hash_t key )
+{
+	//Use a different multiplier than the table home slot so keys in a shard still spread over its table
+	return map->shard + (unsigned int)( ( key * 0xC2B2AE3D27D4EB4FULL ) >> map->shard_shift );
+}
+
+
+static shardmap_table_t* _shardmap_table_allocate( unsigned int capacity )
+{
+	shardmap_table_t* table;
+	unsigned int bits = _robinhood_bits( capacity );
+
+	table = memory_allocate_zero( sizeof( shardmap_table_t ) + sizeof( robinhood_node_t ) * ( 1ULL << bits ), 0, MEMORY_PERSISTENT );
+	_robinhood_initialize( &table->base, bits, pointer_offset( table, sizeof( shardmap_table_t ) ) );
+	return table;
+}
+
+
+static void _shardmap_lock( shardmap_shard_t* shard )
+{
+	for( ;; )
+	{
+		int32_t sequence = shard->sequence;
+		if( !( sequence & 1 ) && atomic_cas32( &shard->sequence, sequence + 1, sequence ) )
+			return;
+		thread_yield();
+	}
+}
+
+
+static FORCEINLINE void _shardmap_unlock( shardmap_shard_t* shard )
+{
+	atomic_incr32( &shard->sequence );
+}
+
+
+static bool _shardmap_read( const shardmap_shard_t* shard, hash_t key, void** value )
+{
+	for( ;; )
+	{
+		int32_t sequence = shard->sequence;
+		if( !( sequence & 1 ) )
+		{
+			const robinhood_node_t* node;
+			void* found = 0;
+			bool has_key;
+
+			atomic_thread_fence_acquire();
+
+			node = _robinhood_find( &shard->table->base, key );
+			has_key = ( node != 0 );
+			if( has_key )
+				found = node->value;
+
+			atomic_thread_fence_acquire();
+
+			if( shard->sequence == sequence )
+			{
+				*value = found;
+				return has_key;
+			}
+		}
+		else
+		{
+			thread_yield();
+		}
+	}
+}
+
+
+shardmap_t* shardmap_allocate( unsigned int shards, unsigned int capacity )
+{
+	shardmap_t* map;
+	unsigned int bits = 0;
+	unsigned int ishard;
+	uint64_t shard_capacity;
+
+	if( !shards )
+		shards = system_hardware_threads() * 4;
+	if( shards < SHARDMAP_MINSHARDS )
+		shards = SHARDMAP_MINSHARDS;
+	if( shards > SHARDMAP_MAXSHARDS )
+		shards = SHARDMAP_MAXSHARDS;
+	while( ( 1U << bits ) < shards )
+		++bits;
+
+	shard_capacity = ( (uint64_t)capacity * ROBINHOOD_LOAD_DENOMINATOR / ROBINHOOD_LOAD_NUMERATOR ) >> bits;
+	if( shard_capacity < ROBINHOOD_MINCAPACITY )
+		shard_capacity = ROBINHOOD_MINCAPACITY;
+	if( shard_capacity > ROBINHOOD_MAXCAPACITY )
+		shard_capacity = ROBINHOOD_MAXCAPACITY;
+
+	map = memory_allocate( sizeof( shardmap_t ), 0, MEMORY_PERSISTENT );
+	map->num_shards = 1U << bits;
+	map->shard_shift = 64 - bits;
+	map->shard = memory_allocate_zero( sizeof( shardmap_shard_t ) * map->num_shards, SHARDMAP_SHARD_STRIDE, MEMORY_PERSISTENT );
+
+	for( ishard = 0; ishard < map->num_shards; ++ishard )
+		map->shard[ishard].table = _shardmap_table_allocate( (unsigned int)shard_capacity );
+
+	return map;
+}
+
+
+void shardmap_deallocate( shardmap_t* map )
+{
+	unsigned int ishard;
+	for( ishard = 0; ishard < map->num_shards; ++ishard )
+	{
+		shardmap_table_t* table = map->shard[ishard].table;
+		while( table )
+		{
+			shardmap_table_t* retired = table->retired;
+			memory_deallocate( table );
+			table = retired;
+		}
+	}
+	memory_deallocate( map->shard );
+	memory_deallocate( map );
+}
+
+
+void* shardmap_insert( shardmap_t* map, hash_t key, void* value )
+{
+	shardmap_shard_t* shard = _shardmap_shard( map, key );
+	shardmap_table_t* table;
+	robinhood_node_t* node;
+	void* prev = 0;
+
+	_shardmap_lock( shard );
+
+	table = shard->table;
+	node = _robinhood_find( &table->base, key );
+	if( node )
+	{
+		prev = node->value;
+		node->value = value;
+	}
+	else
+	{
+		if( _robinhood_need_grow( &table->base, shard->num_nodes ) )
+		{
+			//Fill the new table before publishing it, the old table stays valid for readers
+			shardmap_table_t* grown = _shardmap_table_allocate( table->base.capacity * 2 );
+			_robinhood_rehash( &grown->base, &table->base );
+			grown->retired = table;
+			shard->table = table = grown;
+		}
+
+		_robinhood_place( &table->base, key, value );
+		++shard->num_nodes;
+	}
+
+	_shardmap_unlock( shard );
+
+	return prev;
+}
+
+
+void* shardmap_erase( shardmap_t* map, hash_t key )
+{
+	shardmap_shard_t* shard = _shardmap_shard( map, key );
+	shardmap_table_t* table;
+	robinhood_node_t* node;
+	void* prev = 0;
+
+	_shardmap_lock( shard );
+
+	table = shard->table;
+	node = _robinhood_find( &table->base, key );
+	if( node )
+	{
+		prev = node->value;
+		_robinhood_erase( &table->base, node );
+		--shard->num_nodes;
+	}
+
+	_shardmap_unlock( shard );
+
+	return prev;
+}
+
+
+void* shardmap_lookup( shardmap_t* map, hash_t key )
+{
+	void* value;
+	_shardmap_read( _shardmap_shard( map, key ), key, &value );
+	return value;
+}
+
+
+bool shardmap_has_key( shardmap_t* map, hash_t key )
+{
+	void* value;
+	return _shardmap_read( _shardmap_shard( map, key ), key, &value );
+}
+
+
+unsigned int shardmap_size( shardmap_t* map )
+{
+	unsigned int ishard;
+	unsigned int size = 0;
+	for( ishard = 0; ishard < map->num_shards; ++ishard )
+		size += map->shard[ishard].num_nodes;
+	return size;
+}
+
+
+void shardmap_clear( shardmap_t* map )
+{
+	unsigned int ishard;
+	for( ishard = 0; ishard < map->num_shards; ++ishard )
+	{
+		shardmap_shard_t* shard = map->shard + ishard;
+		_shardmap_lock( shard );
+		memset( shard->table->base.node, 0, sizeof( robinhood_node_t ) * shard->table->base.capacity );
+		shard->num_nodes = 0;
+		_shardmap_unlock( shard );
+	}
+}
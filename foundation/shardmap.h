@@ -0,0 +1,43 @@
+/* shardmap.h  -  Foundation library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file shardmap.h
+    Container mapping hashvalues to pointers that is safe to use from multiple threads
+    concurrently. Keys are split over a number of shards, each guarded by a sequence lock.
+    Writers lock only the shard they modify, readers never write shared memory and retry
+    if a writer modified the shard during the lookup */
+
+#include <foundation/platform.h>
+#include <foundation/types.h>
+
+
+#define SHARDMAP_MINSHARDS                 4
+#define SHARDMAP_MAXSHARDS                 256
+
+//! Allocate a map. Pass zero shards to pick a count based on the number of hardware threads, capacity is a hint of the expected number of nodes
+FOUNDATION_API shardmap_t*                 shardmap_allocate( unsigned int shards, unsigned int capacity );
+
+//! Free the map. Must not be called concurrently with any other access to the map
+FOUNDATION_API void                        shardmap_deallocate( shardmap_t* map );
+
+FOUNDATION_API void*                       shardmap_insert( shardmap_t* map, hash_t key, void* value );
+FOUNDATION_API void*                       shardmap_erase( shardmap_t* map, hash_t key );
+
+FOUNDATION_API void*                       shardmap_lookup( shardmap_t* map, hash_t key );
+FOUNDATION_API bool                        shardmap_has_key( shardmap_t* map, hash_t key );
+
+//! Get number of nodes. Only a snapshot if other threads modify the map concurrently
+FOUNDATION_API unsigned int                shardmap_size( shardmap_t* map );
+
+FOUNDATION_API void                        shardmap_clear( shardmap_t* map );
@@ -510,10 +510,12 @@ static NOINLINE char** _resolve_stack_frames( void** frames, unsigned int max_fr
 
 #elif FOUNDATION_PLATFORM_LINUX
 
+	array_inline( char*, 32 ) addrs_storage;
+	array_inline( const char*, 40 ) args_storage;
 	char** addrs = 0;
 	char** lines = 0;
 	const char** args = 0;
-	process_t* proc = process_allocate();
+	process_t* proc = 0;
 	unsigned int num_frames = 0;
 	unsigned int requested_frames = 0;
 	bool last_was_main = false;
@@ -530,7 +532,12 @@ static NOINLINE char** _resolve_stack_frames( void** frames, unsigned int max_fr
 		}
 		return lines;
 	}
-	
+
+	//Address and argument arrays only live for the duration of the call, keep typical depths off the heap
+	addrs = array_inline_initialize( addrs_storage );
+	args = array_inline_initialize( args_storage );
+	proc = process_allocate();
+
 	array_push( args, "-e" );
 	array_push( args, environment_executable_path() );
 	array_push( args, "-f" );
@@ -71,7 +71,10 @@ void stream_deallocate( stream_t* stream )
 	if( stream->vtable && stream->vtable->deallocate )
 		stream->vtable->deallocate( stream );
 	string_deallocate( stream->path );
-	memory_deallocate( stream );
+	if( stream->vtable && stream->vtable->release )
+		stream->vtable->release( stream );
+	else
+		memory_deallocate( stream );
 }
 
 
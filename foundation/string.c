@@ -656,9 +656,8 @@ char* string_merge( const char* const* array, unsigned int num, const char* deli
 
 void string_array_deallocate_elements( char** array )
 {
-	int i, size = array_size( array );
-	for( i = 0; i < size; ++i )
-		string_deallocate( array[i] );
+	if( array )
+		memory_deallocate_batch( (void**)array, array_size( array ) );
 }
 
 
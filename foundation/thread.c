@@ -89,6 +89,7 @@ typedef struct ALIGN(16) _foundation_thread
 
 static uint64_t     _thread_main_id = 0;
 static objectmap_t* _thread_map = 0;
+static mempool_t    _thread_pool = MEMPOOL_INITIALIZER( sizeof( thread_t ), 16, MEMORYCONTEXT_GLOBAL );
 
 #define GET_THREAD( obj ) objectmap_lookup( _thread_map, obj )
 
@@ -145,7 +146,7 @@ static void _thread_destroy( void* thread_raw )
 			thread_yield();
 	}
 	objectmap_free( _thread_map, thread->id );
-	memory_deallocate( thread );
+	mempool_deallocate( &_thread_pool, thread );
 }
 
 
@@ -174,7 +175,7 @@ object_t thread_create( thread_fn fn, const char* name, thread_priority_t priori
 		log_error( 0, ERROR_OUT_OF_MEMORY, "Unable to allocate new thread, map full" );	
 		return 0;
 	}
-	thread = memory_allocate_zero( sizeof( thread_t ), 0, MEMORY_PERSISTENT );
+	thread = mempool_allocate_zero( &_thread_pool );
 	thread->id = id;
 	thread->fn = fn;
 	string_copy( thread->name, name, 32 );
@@ -549,7 +550,10 @@ void thread_cleanup( void )
 			memory_deallocate( block );
 		}
 	}
-#endif	
+#endif
+
+	mempool_thread_deallocate();
+	memory_thread_deallocate();
 }
 
 
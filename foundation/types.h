@@ -77,9 +77,26 @@ typedef enum
 	MEMORY_TEMPORARY,
 	MEMORY_THREAD,
 	MEMORY_PERSISTENT,
-	MEMORY_PERSISTENT_32BIT_ADDRESS
+	MEMORY_PERSISTENT_32BIT_ADDRESS,
+	MEMORY_PERSISTENT_HUGEPAGE
 } memory_hint_t;
 
+//! Array growth policies
+typedef enum
+{
+	ARRAY_GROWTH_DOUBLE = 0,
+	ARRAY_GROWTH_HALF,
+	ARRAY_GROWTH_PAGE
+} array_growth_t;
+
+//! Memory pressure levels
+typedef enum
+{
+	MEMORY_PRESSURE_NONE = 0,
+	MEMORY_PRESSURE_SOFT,
+	MEMORY_PRESSURE_HARD
+} memory_pressure_t;
+
 //! Memory contexts
 typedef enum
 {
@@ -315,9 +332,14 @@ typedef void*         (* memory_allocate_fn )( uint16_t context, uint64_t size,
 typedef void*         (* memory_allocate_zero_fn )( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint );
 typedef void*         (* memory_reallocate_fn )( void* p, uint64_t size, unsigned int align, uint64_t oldsize );
 typedef void          (* memory_deallocate_fn )( void* p );
+typedef unsigned int  (* memory_allocate_batch_fn )( uint16_t context, uint64_t size, unsigned int align, memory_hint_t hint, void** ptrs, unsigned int count );
+typedef void          (* memory_deallocate_batch_fn )( void** ptrs, unsigned int count );
+typedef void          (* memory_thread_finalize_fn )( void );
 
 typedef void          (* memory_track_fn )( void*, uint64_t );
 typedef void          (* memory_untrack_fn )( void* );
+typedef void          (* memory_report_fn )( void );
+typedef void          (* memory_pressure_fn )( uint16_t context, memory_pressure_t level, uint64_t current, uint64_t budget );
 
 //! Callback function for writing profiling data to a stream
 typedef void          (* profile_write_fn)( void*, uint64_t );
@@ -348,6 +370,9 @@ typedef struct _foundation_memory_system
 	memory_deallocate_fn            deallocate;
 	system_initialize_fn            initialize;
 	system_shutdown_fn              shutdown;
+	memory_thread_finalize_fn       thread_finalize;
+	memory_allocate_batch_fn        allocate_batch;
+	memory_deallocate_batch_fn      deallocate_batch;
 } memory_system_t;
 
 //! Memory tracking callbacks
@@ -357,8 +382,60 @@ typedef struct _foundation_memory_tracker
 	memory_untrack_fn               untrack;
 	system_initialize_fn            initialize;
 	system_shutdown_fn              shutdown;
+	memory_report_fn                report;
 } memory_tracker_t;
 
+//! Memory arena for scoped linear allocations
+typedef struct _foundation_memory_arena
+{
+	void*                           chunk;
+	void*                           current;
+	void*                           head;
+	void*                           end;
+	uint64_t                        chunksize;
+} memory_arena_t;
+
+//! Memory arena position
+typedef struct _foundation_memory_arena_mark
+{
+	void*                           chunk;
+	void*                           head;
+} memory_arena_mark_t;
+
+//! Per-thread cache of free objects in a memory pool, aligned to a cache line to avoid false sharing between threads
+typedef struct ALIGN(64) _foundation_mempool_magazine
+{
+	unsigned int                    count;
+	void*                           objects[BUILD_SIZE_MEMPOOL_MAGAZINE];
+} mempool_magazine_t;
+
+//! Fixed size object pool. Can be statically initialized with size, alignment and memory context as first members
+typedef struct _foundation_mempool mempool_t;
+struct _foundation_mempool
+{
+	unsigned int                    size;
+	unsigned int                    align;
+	uint16_t                        context;
+	unsigned int                    stride;
+	unsigned int                    slab_objects;
+	void*                           free;
+	void*                           slabs;
+	mempool_t*                      next;
+	volatile int32_t                lock;
+	mempool_magazine_t              magazine[BUILD_SIZE_MEMPOOL_THREADS];
+};
+
+//! Memory allocation statistics for a memory context. Histogram bucket N counts allocations of up to 16<<N bytes, last bucket counts all larger allocations
+typedef struct _foundation_memory_statistics
+{
+	uint64_t                        allocations;
+	uint64_t                        deallocations;
+	uint64_t                        allocated_current;
+	uint64_t                        allocated_peak;
+	uint64_t                        allocated_total;
+	uint64_t                        histogram[BUILD_SIZE_MEMORY_STATISTICS_HISTOGRAM];
+} memory_statistics_t;
+
 //! Version identifier
 typedef union _foundation_version
 {
@@ -427,6 +504,16 @@ typedef struct ALIGN(16) _foundation_objectmap
 	void*                           map[];
 } objectmap_t;
 
+//! Bucket array, elements are stored in fixed size buckets and never move. Can be statically initialized with element size, alignment and bucket size shift as first members
+typedef struct _foundation_bucketarray
+{
+	unsigned int                    element_size;
+	unsigned int                    align;
+	unsigned int                    bucket_shift;
+	unsigned int                    size;
+	void**                          bucket;
+} bucketarray_t;
+
 //! Event base structure
 #define FOUNDATION_DECLARE_EVENT       \
 	uint8_t               system;      \
@@ -503,6 +590,9 @@ typedef struct _foundation_blowfish         blowfish_t;
 typedef struct _foundation_radixsort        radixsort_t;
 
 typedef struct _foundation_hashmap          hashmap_t;
+typedef struct _foundation_flatmap          flatmap_t;
+typedef struct _foundation_groupmap         groupmap_t;
+typedef struct _foundation_shardmap         shardmap_t;
 typedef struct _foundation_hashtable32      hashtable32_t;
 typedef struct _foundation_hashtable64      hashtable64_t;
 
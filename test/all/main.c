@@ -78,6 +78,7 @@ extern int test_hashtable_run( void );
 extern int test_library_run( void );
 extern int test_math_run( void );
 extern int test_md5_run( void );
+extern int test_memory_run( void );
 extern int test_mutex_run( void );
 extern int test_objectmap_run( void );
 extern int test_path_run( void );
@@ -127,6 +128,7 @@ int main_run( void* main_arg )
 		test_library_run,
 		test_math_run,
 		test_md5_run,
+		test_memory_run,
 		test_mutex_run,
 		test_objectmap_run,
 		test_path_run,
@@ -1933,12 +1933,416 @@ DECLARE_TEST( array, inserterase )
 }
 
 
+DECLARE_TEST( array, growth )
+{
+	int*       array_int = 0;
+	basic_t*   array_basic = 0;
+	int        i;
+
+	EXPECT_EQ( array_growth( array_int ), ARRAY_GROWTH_DOUBLE );
+
+	for( i = 0; i < 1000; ++i )
+		array_push( array_int, i );
+	EXPECT_EQ( array_growth( array_int ), ARRAY_GROWTH_DOUBLE );
+	EXPECT_GE( array_capacity( array_int ), 1000 );
+
+	// Shrink
+	array_shrink_to_fit( array_int );
+	EXPECT_EQ( array_size( array_int ), 1000 );
+	EXPECT_EQ( array_capacity( array_int ), 1000 );
+	for( i = 0; i < 1000; ++i )
+		EXPECT_EQ( array_int[i], i );
+
+	// Half growth
+	array_set_growth( array_int, ARRAY_GROWTH_HALF );
+	EXPECT_EQ( array_growth( array_int ), ARRAY_GROWTH_HALF );
+	array_push( array_int, 1000 );
+	EXPECT_EQ( array_capacity( array_int ), 1501 );
+	EXPECT_EQ( array_size( array_int ), 1001 );
+
+	array_clear( array_int );
+	array_shrink_to_fit( array_int );
+	EXPECT_NE( array_int, 0 );
+	EXPECT_EQ( array_size( array_int ), 0 );
+	EXPECT_EQ( array_capacity( array_int ), 0 );
+	EXPECT_EQ( array_growth( array_int ), ARRAY_GROWTH_HALF );
+	array_push( array_int, 42 );
+	EXPECT_EQ( array_size( array_int ), 1 );
+	EXPECT_EQ( array_int[0], 42 );
+
+	// Page growth on unallocated array
+	array_set_growth( array_basic, ARRAY_GROWTH_PAGE );
+	EXPECT_NE( array_basic, 0 );
+	EXPECT_EQ( array_size( array_basic ), 0 );
+	EXPECT_EQ( array_growth( array_basic ), ARRAY_GROWTH_PAGE );
+	for( i = 0; i < 10000; ++i )
+	{
+		basic_t basic = { i, (object_t)i };
+		array_push( array_basic, basic );
+	}
+	EXPECT_GE( array_capacity( array_basic ), 10000 );
+	EXPECT_LT( array_capacity( array_basic ), 12000 );
+	for( i = 0; i < 10000; ++i )
+		EXPECT_EQ( array_basic[i].intval, i );
+
+	array_deallocate( array_int );
+	array_deallocate( array_basic );
+
+	return 0;
+}
+
+
+DECLARE_TEST( array, reserve )
+{
+	int*       array_int = 0;
+	int64_t    capacity;
+	int        i;
+
+	array_reserve( array_int, 8 );
+	EXPECT_NE( array_int, 0 );
+	EXPECT_EQ( array_size( array_int ), 0 );
+	EXPECT_EQ( array_capacity( array_int ), 8 );
+
+	for( i = 0; i < 10; ++i )
+		array_push( array_int, i );
+	capacity = array_capacity( array_int );
+	EXPECT_GE( capacity, 10 );
+
+	// Reserve on non-empty array grows to exactly the requested capacity
+	array_reserve( array_int, capacity + 4 );
+	EXPECT_EQ( array_capacity( array_int ), capacity + 4 );
+	EXPECT_EQ( array_size( array_int ), 10 );
+	for( i = 0; i < 10; ++i )
+		EXPECT_EQ( array_int[i], i );
+
+	// Reserve on full array
+	array_shrink_to_fit( array_int );
+	EXPECT_EQ( array_capacity( array_int ), 10 );
+	array_reserve( array_int, 11 );
+	EXPECT_EQ( array_capacity( array_int ), 11 );
+	EXPECT_EQ( array_size( array_int ), 10 );
+	for( i = 0; i < 10; ++i )
+		EXPECT_EQ( array_int[i], i );
+
+	// Reserving less than current capacity is a no-op
+	array_reserve( array_int, 4 );
+	EXPECT_EQ( array_capacity( array_int ), 11 );
+	EXPECT_EQ( array_size( array_int ), 10 );
+
+	array_deallocate( array_int );
+
+	return 0;
+}
+
+
+DECLARE_TEST( array, inline )
+{
+	array_inline( int, 16 ) storage;
+	array_inline( basic_t, 4 ) basic_storage;
+	int*       array_int;
+	basic_t*   array_basic;
+	int        i;
+
+	array_int = array_inline_initialize( storage );
+	EXPECT_EQ( array_int, storage.storage );
+	EXPECT_TRUE( array_is_inline( array_int ) );
+	EXPECT_EQ( array_capacity( array_int ), 16 );
+	EXPECT_EQ( array_size( array_int ), 0 );
+	EXPECT_EQ( array_growth( array_int ), ARRAY_GROWTH_DOUBLE );
+
+	for( i = 0; i < 16; ++i )
+		array_push( array_int, i );
+	EXPECT_EQ( array_int, storage.storage );
+	EXPECT_TRUE( array_is_inline( array_int ) );
+	EXPECT_EQ( array_size( array_int ), 16 );
+
+	// Shrink is a no-op on inline storage
+	array_pop( array_int );
+	array_shrink_to_fit( array_int );
+	EXPECT_EQ( array_int, storage.storage );
+	EXPECT_EQ( array_capacity( array_int ), 16 );
+	array_push( array_int, 15 );
+
+	// Spill to heap
+	array_push( array_int, 16 );
+	EXPECT_NE( array_int, storage.storage );
+	EXPECT_FALSE( array_is_inline( array_int ) );
+	EXPECT_EQ( array_size( array_int ), 17 );
+	EXPECT_GE( array_capacity( array_int ), 17 );
+	for( i = 0; i < 17; ++i )
+		EXPECT_EQ( array_int[i], i );
+
+	array_deallocate( array_int );
+	EXPECT_EQ( array_int, 0 );
+
+	// Deallocate while inline, growth policy kept on spill
+	array_basic = array_inline_initialize( basic_storage );
+	array_set_growth( array_basic, ARRAY_GROWTH_HALF );
+	EXPECT_TRUE( array_is_inline( array_basic ) );
+	for( i = 0; i < 4; ++i )
+	{
+		basic_t basic = { i, (object_t)i };
+		array_push( array_basic, basic );
+	}
+	EXPECT_TRUE( array_is_inline( array_basic ) );
+	array_deallocate( array_basic );
+	EXPECT_EQ( array_basic, 0 );
+
+	array_basic = array_inline_initialize( basic_storage );
+	array_set_growth( array_basic, ARRAY_GROWTH_HALF );
+	for( i = 0; i < 100; ++i )
+	{
+		basic_t basic = { i, (object_t)i };
+		array_push( array_basic, basic );
+	}
+	EXPECT_FALSE( array_is_inline( array_basic ) );
+	EXPECT_EQ( array_growth( array_basic ), ARRAY_GROWTH_HALF );
+	for( i = 0; i < 100; ++i )
+		EXPECT_EQ( array_basic[i].intval, i );
+	array_deallocate( array_basic );
+
+	return 0;
+}
+
+
+DECLARE_TEST( array, bucket )
+{
+	bucketarray_t array;
+	basic_t*      first;
+	basic_t*      element;
+	basic_t*      bucket;
+	unsigned int  i, ib, ie, count, total;
+
+	bucketarray_initialize( &array, sizeof( basic_t ), 16, 6 );
+	EXPECT_EQ( bucketarray_size( &array ), 0 );
+	EXPECT_EQ( bucketarray_capacity( &array ), 0 );
+	EXPECT_EQ( bucketarray_bucket_count( &array ), 0 );
+
+	first = bucketarray_push( &array, 0 );
+	EXPECT_NE( first, 0 );
+	EXPECT_EQ( first->intval, 0 );
+	EXPECT_EQ( first->objval, 0 );
+	EXPECT_EQ( bucketarray_capacity( &array ), 8 );
+
+	for( i = 1; i < 1000; ++i )
+	{
+		basic_t basic = { i, (object_t)i };
+		element = bucketarray_push( &array, &basic );
+		EXPECT_EQ( element, bucketarray_get( &array, i ) );
+	}
+	EXPECT_EQ( bucketarray_size( &array ), 1000 );
+	EXPECT_EQ( bucketarray_bucket_count( &array ), 125 );
+
+	// Addresses are stable
+	EXPECT_EQ( first, bucketarray_get( &array, 0 ) );
+	for( i = 0; i < 1000; ++i )
+	{
+		element = bucketarray_get( &array, i );
+		EXPECT_EQ( element->intval, (int)i );
+		EXPECT_EQ( element->objval, (object_t)i );
+	}
+
+	// Bucket iteration
+	bucketarray_pop( &array );
+	EXPECT_EQ( bucketarray_size( &array ), 999 );
+	for( ib = 0, total = 0; ib < bucketarray_bucket_count( &array ); ++ib )
+	{
+		bucket = bucketarray_bucket( &array, ib, &count );
+		EXPECT_EQ( count, ( ib == 124 ) ? 7U : 8U );
+		for( ie = 0; ie < count; ++ie, ++total )
+			EXPECT_EQ( bucket[ie].intval, (int)total );
+	}
+	EXPECT_EQ( total, 999 );
+
+	// Clear keeps buckets
+	bucketarray_clear( &array );
+	EXPECT_EQ( bucketarray_size( &array ), 0 );
+	EXPECT_EQ( bucketarray_capacity( &array ), 1000 );
+	EXPECT_EQ( bucketarray_push( &array, 0 ), first );
+
+	bucketarray_destroy( &array );
+	EXPECT_EQ( bucketarray_size( &array ), 0 );
+	EXPECT_EQ( bucketarray_capacity( &array ), 0 );
+
+	bucketarray_reserve( &array, 17 );
+	EXPECT_EQ( bucketarray_capacity( &array ), 24 );
+	EXPECT_EQ( bucketarray_size( &array ), 0 );
+	bucketarray_destroy( &array );
+
+	return 0;
+}
+
+
+DECLARE_TEST( array, search )
+{
+	int32_t*     array_int32 = 0;
+	uint32_t*    array_uint32 = 0;
+	int64_t*     array_int64 = 0;
+	uint64_t*    array_uint64 = 0;
+	float32_t*   array_float32 = 0;
+	float64_t*   array_float64 = 0;
+	unsigned int num, i, count;
+	int          found;
+	int64_t      sum;
+	uint64_t     usum, upper, lower;
+
+	// Sizes cover empty arrays, partial vectors and vector tails
+	for( num = 0; num < 80; ++num )
+	{
+		array_clear( array_int32 );
+		array_clear( array_uint32 );
+		array_clear( array_int64 );
+		array_clear( array_uint64 );
+		array_clear( array_float32 );
+		array_clear( array_float64 );
+		for( i = 0; i < num; ++i )
+		{
+			int32_t val = (int32_t)random32_range( 0, 16 ) - 8;
+			array_push( array_int32, val );
+			array_push( array_uint32, (uint32_t)val );
+			array_push( array_int64, (int64_t)val * 0x100000000LL );
+			array_push( array_uint64, (uint64_t)val * 0x100000000ULL );
+			array_push( array_float32, (float32_t)val );
+			array_push( array_float64, (float64_t)val );
+		}
+
+		found = -1;
+		for( i = 0; ( i < num ) && ( found < 0 ); ++i )
+			found = ( array_int32[i] == 3 ) ? (int)i : -1;
+		for( i = 0, count = 0; i < num; ++i )
+			count += ( array_int32[i] == 3 ) ? 1 : 0;
+		EXPECT_EQ( array_find_int32( array_int32, num, 3 ), found );
+		EXPECT_EQ( array_find_uint32( array_uint32, num, 3 ), found );
+		EXPECT_EQ( array_find_int64( array_int64, num, 0x300000000LL ), found );
+		EXPECT_EQ( array_find_hash( array_uint64, num, 0x300000000ULL ), found );
+		EXPECT_EQ( array_find_float32( array_float32, num, 3.0f ), found );
+		EXPECT_EQ( array_find_float64( array_float64, num, 3.0 ), found );
+		EXPECT_EQ( array_count_int32( array_int32, num, 3 ), count );
+		EXPECT_EQ( array_count_uint32( array_uint32, num, 3 ), count );
+		EXPECT_EQ( array_count_int64( array_int64, num, 0x300000000LL ), count );
+		EXPECT_EQ( array_count_uint64( array_uint64, num, 0x300000000ULL ), count );
+		EXPECT_EQ( array_count_float32( array_float32, num, 3.0f ), count );
+		EXPECT_EQ( array_count_float64( array_float64, num, 3.0 ), count );
+		EXPECT_EQ( array_find_int32( array_int32, num, 100 ), -1 );
+		EXPECT_EQ( array_count_int64( array_int64, num, 100 ), 0 );
+
+		sum = 0;
+		usum = 0;
+		for( i = 0; i < num; ++i )
+		{
+			sum += array_int32[i];
+			usum += array_uint32[i];
+		}
+		EXPECT_EQ( array_sum_int32( array_int32, num ), sum );
+		EXPECT_EQ( array_sum_uint32( array_uint32, num ), usum );
+		EXPECT_EQ( array_sum_int64( array_int64, num ), sum * 0x100000000LL );
+		EXPECT_EQ( array_sum_uint64( array_uint64, num ), (uint64_t)sum * 0x100000000ULL );
+		EXPECT_EQ( array_sum_float32( array_float32, num ), (float32_t)sum );
+		EXPECT_EQ( array_sum_float64( array_float64, num ), (float64_t)sum );
+
+		if( num )
+		{
+			int32_t minval = array_int32[0], maxval = array_int32[0];
+			uint32_t uminval = array_uint32[0], umaxval = array_uint32[0];
+			for( i = 1; i < num; ++i )
+			{
+				minval = ( array_int32[i] < minval ) ? array_int32[i] : minval;
+				maxval = ( array_int32[i] > maxval ) ? array_int32[i] : maxval;
+				uminval = ( array_uint32[i] < uminval ) ? array_uint32[i] : uminval;
+				umaxval = ( array_uint32[i] > umaxval ) ? array_uint32[i] : umaxval;
+			}
+			EXPECT_EQ( array_min_int32( array_int32, num ), minval );
+			EXPECT_EQ( array_max_int32( array_int32, num ), maxval );
+			EXPECT_EQ( array_min_uint32( array_uint32, num ), uminval );
+			EXPECT_EQ( array_max_uint32( array_uint32, num ), umaxval );
+			EXPECT_EQ( array_min_int64( array_int64, num ), (int64_t)minval * 0x100000000LL );
+			EXPECT_EQ( array_max_int64( array_int64, num ), (int64_t)maxval * 0x100000000LL );
+			EXPECT_EQ( array_min_uint64( array_uint64, num ), (uint64_t)uminval * 0x100000000ULL );
+			EXPECT_EQ( array_max_uint64( array_uint64, num ), (uint64_t)umaxval * 0x100000000ULL );
+			EXPECT_EQ( array_min_float32( array_float32, num ), (float32_t)minval );
+			EXPECT_EQ( array_max_float32( array_float32, num ), (float32_t)maxval );
+			EXPECT_EQ( array_min_float64( array_float64, num ), (float64_t)minval );
+			EXPECT_EQ( array_max_float64( array_float64, num ), (float64_t)maxval );
+		}
+		else
+		{
+			EXPECT_EQ( array_min_int32( array_int32, num ), 0 );
+			EXPECT_EQ( array_max_uint64( array_uint64, num ), 0 );
+		}
+	}
+
+	// Bounds on sorted buffers with runs of equal values, sizes below and above the linear window
+	for( num = 0; num < 300; num += 7 )
+	{
+		array_clear( array_int32 );
+		array_clear( array_uint32 );
+		array_clear( array_int64 );
+		array_clear( array_uint64 );
+		array_clear( array_float32 );
+		array_clear( array_float64 );
+		for( i = 0; i < num; ++i )
+		{
+			int32_t val = (int32_t)( i / 3 ) - 20;
+			array_push( array_int32, val );
+			array_push( array_uint32, (uint32_t)i / 3 );
+			array_push( array_int64, (int64_t)val );
+			array_push( array_uint64, ( (uint64_t)i / 3 ) | 0x8000000000000000ULL );
+			array_push( array_float32, (float32_t)val );
+			array_push( array_float64, (float64_t)val );
+		}
+		for( found = -25; found < (int)( num / 3 ) + 5; ++found )
+		{
+			int32_t val = found - 20;
+			for( i = 0, lower = 0, upper = 0; i < num; ++i )
+			{
+				lower += ( array_int32[i] < val ) ? 1 : 0;
+				upper += ( array_int32[i] <= val ) ? 1 : 0;
+			}
+			EXPECT_EQ( array_lower_bound_int32( array_int32, num, val ), lower );
+			EXPECT_EQ( array_upper_bound_int32( array_int32, num, val ), upper );
+			EXPECT_EQ( array_lower_bound_int64( array_int64, num, val ), lower );
+			EXPECT_EQ( array_upper_bound_int64( array_int64, num, val ), upper );
+			EXPECT_EQ( array_lower_bound_float32( array_float32, num, (float32_t)val ), lower );
+			EXPECT_EQ( array_upper_bound_float32( array_float32, num, (float32_t)val ), upper );
+			EXPECT_EQ( array_lower_bound_float64( array_float64, num, (float64_t)val ), lower );
+			EXPECT_EQ( array_upper_bound_float64( array_float64, num, (float64_t)val ), upper );
+			if( found >= 0 )
+			{
+				for( i = 0, lower = 0, upper = 0; i < num; ++i )
+				{
+					lower += ( array_uint32[i] < (uint32_t)found ) ? 1 : 0;
+					upper += ( array_uint32[i] <= (uint32_t)found ) ? 1 : 0;
+				}
+				EXPECT_EQ( array_lower_bound_uint32( array_uint32, num, (uint32_t)found ), lower );
+				EXPECT_EQ( array_upper_bound_uint32( array_uint32, num, (uint32_t)found ), upper );
+				EXPECT_EQ( array_lower_bound_hash( array_uint64, num, (uint64_t)found | 0x8000000000000000ULL ), lower );
+				EXPECT_EQ( array_upper_bound_uint64( array_uint64, num, (uint64_t)found | 0x8000000000000000ULL ), upper );
+			}
+		}
+	}
+
+	array_deallocate( array_int32 );
+	array_deallocate( array_uint32 );
+	array_deallocate( array_int64 );
+	array_deallocate( array_uint64 );
+	array_deallocate( array_float32 );
+	array_deallocate( array_float64 );
+
+	return 0;
+}
+
+
 void test_array_declare( void )
 {
 	ADD_TEST( array, allocation );
 	ADD_TEST( array, copy );
 	ADD_TEST( array, pushpop );
 	ADD_TEST( array, inserterase );
+	ADD_TEST( array, growth );
+	ADD_TEST( array, reserve );
+	ADD_TEST( array, inline );
+	ADD_TEST( array, bucket );
+	ADD_TEST( array, search );
 }
 
 
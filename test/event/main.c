@@ -519,6 +519,51 @@ DECLARE_TEST( event, delay_threaded )
 }
 
 
+DECLARE_TEST( event, large )
+{
+	//Grow the blocks well past the chunk size so they move into a reserved range and keep growing in place
+	event_stream_t* stream;
+	event_block_t* block;
+	event_t* event;
+	uint8_t buffer[200];
+	unsigned int ievent, iloop, ibyte;
+	unsigned int num_events = 2500;
+
+	stream = event_stream_allocate( 0 );
+
+	for( iloop = 0; iloop < 4; ++iloop )
+	{
+		for( ievent = 0; ievent < num_events; ++ievent )
+		{
+			for( ibyte = 0; ibyte < sizeof( buffer ); ++ibyte )
+				buffer[ibyte] = (uint8_t)( ievent + ibyte + iloop );
+			event_post( stream, SYSTEM_FOUNDATION, (uint8_t)( ievent & 0xFF ), (uint16_t)( 1 + ( ievent % sizeof( buffer ) ) ), ievent, buffer, 0 );
+		}
+
+		block = event_stream_process( stream );
+		event = event_next( block, 0 );
+		for( ievent = 0; ievent < num_events; ++ievent )
+		{
+			EXPECT_NE( event, 0 );
+			EXPECT_EQ( event->id, (uint8_t)( ievent & 0xFF ) );
+			EXPECT_EQ( event->object, ievent );
+			EXPECT_GE( event_payload_size( event ), 1 + ( ievent % sizeof( buffer ) ) );
+			for( ibyte = 0; ibyte < 1 + ( ievent % sizeof( buffer ) ); ++ibyte )
+				EXPECT_EQ( (uint8_t)event->payload[ibyte], (uint8_t)( ievent + ibyte + iloop ) );
+			event = event_next( block, event );
+		}
+		EXPECT_EQ( event, 0 );
+
+		//Later loops reuse the grown blocks with more events
+		num_events += 500;
+	}
+
+	event_stream_deallocate( stream );
+
+	return 0;
+}
+
+
 void test_event_declare( void )
 {
 	ADD_TEST( event, empty );
@@ -526,6 +571,7 @@ void test_event_declare( void )
 	ADD_TEST( event, delay );
 	ADD_TEST( event, immediate_threaded );
 	ADD_TEST( event, delay_threaded );
+	ADD_TEST( event, large );
 }
 
 
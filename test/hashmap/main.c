@@ -166,12 +166,318 @@ DECLARE_TEST( hashmap, lookup )
 }
 
 
+DECLARE_TEST( hashmap, resize )
+{
+	hashmap_t* map = hashmap_allocate( 0, 0 );
+	unsigned int ikey;
+
+	// Keys with identical low bits must still spread over the table
+	for( ikey = 0; ikey < 100000; ++ikey )
+		EXPECT_EQ( hashmap_insert( map, (hash_t)ikey << 32, (void*)(uintptr_t)( ikey + 1 ) ), 0 );
+	EXPECT_EQ( hashmap_size( map ), 100000 );
+
+	for( ikey = 0; ikey < 100000; ++ikey )
+		EXPECT_EQ( hashmap_lookup( map, (hash_t)ikey << 32 ), (void*)(uintptr_t)( ikey + 1 ) );
+	EXPECT_FALSE( hashmap_has_key( map, 1 ) );
+
+	for( ikey = 0; ikey < 100000; ikey += 2 )
+		EXPECT_EQ( hashmap_erase( map, (hash_t)ikey << 32 ), (void*)(uintptr_t)( ikey + 1 ) );
+	EXPECT_EQ( hashmap_size( map ), 50000 );
+
+	for( ikey = 0; ikey < 100000; ++ikey )
+		EXPECT_EQ( hashmap_lookup( map, (hash_t)ikey << 32 ), ( ikey & 1 ) ? (void*)(uintptr_t)( ikey + 1 ) : 0 );
+
+	hashmap_clear( map );
+	EXPECT_EQ( hashmap_size( map ), 0 );
+	EXPECT_EQ( hashmap_lookup( map, (hash_t)1 << 32 ), 0 );
+	EXPECT_EQ( hashmap_insert( map, (hash_t)1 << 32, map ), 0 );
+	EXPECT_EQ( hashmap_lookup( map, (hash_t)1 << 32 ), map );
+
+	hashmap_deallocate( map );
+
+	return 0;
+}
+
+
+DECLARE_TEST( hashmap, batch )
+{
+	hashmap_t* map = hashmap_allocate( 0, 0 );
+	hash_t keys[1000];
+	void* values[1000];
+	unsigned int i;
+
+	hashmap_lookup_batch( map, keys, 0, values );
+
+	for( i = 0; i < 1000; ++i )
+	{
+		keys[i] = (hash_t)( i + 1 ) << 32;
+		if( i & 1 )
+			hashmap_insert( map, keys[i], (void*)(uintptr_t)( i + 1 ) );
+	}
+
+	// Count not a multiple of the internal batch size
+	hashmap_lookup_batch( map, keys, 999, values );
+	for( i = 0; i < 999; ++i )
+		EXPECT_EQ( values[i], ( i & 1 ) ? (void*)(uintptr_t)( i + 1 ) : 0 );
+
+	hashmap_deallocate( map );
+
+	return 0;
+}
+
+
+DECLARE_TEST( hashmap, flatmap )
+{
+	flatmap_t* map = flatmap_allocate( 0 );
+	hash_t* keys = 0;
+	void** values = 0;
+	const hash_t* ordered;
+	unsigned int i;
+
+	EXPECT_EQ( flatmap_size( map ), 0 );
+	EXPECT_EQ( flatmap_lookup( map, 0 ), 0 );
+	EXPECT_FALSE( flatmap_has_key( map, 0 ) );
+
+	for( i = 0; i < 1000; ++i )
+		EXPECT_EQ( flatmap_insert( map, random64(), (void*)(uintptr_t)( i + 1 ) ), 0 );
+	EXPECT_EQ( flatmap_insert( map, 42, map ), 0 );
+	EXPECT_EQ( flatmap_insert( map, 42, (void*)(uintptr_t)1 ), map );
+	EXPECT_EQ( flatmap_size( map ), 1001 );
+	EXPECT_EQ( flatmap_lookup( map, 42 ), (void*)(uintptr_t)1 );
+
+	// Ordered iteration
+	ordered = flatmap_keys( map );
+	for( i = 1; i < flatmap_size( map ); ++i )
+		EXPECT_LT( ordered[i-1], ordered[i] );
+	for( i = 0; i < flatmap_size( map ); ++i )
+		EXPECT_EQ( flatmap_lookup( map, ordered[i] ), flatmap_values( map )[i] );
+
+	EXPECT_EQ( flatmap_erase( map, 42 ), (void*)(uintptr_t)1 );
+	EXPECT_EQ( flatmap_erase( map, 42 ), 0 );
+	EXPECT_FALSE( flatmap_has_key( map, 42 ) );
+	EXPECT_EQ( flatmap_size( map ), 1000 );
+
+	flatmap_clear( map );
+	EXPECT_EQ( flatmap_size( map ), 0 );
+
+	// Bulk build from unsorted input, duplicates keep the last value
+	for( i = 0; i < 2000; ++i )
+	{
+		array_push( keys, ( (hash_t)( i * 7919 ) % 1500 ) << 40 );
+		array_push( values, (void*)(uintptr_t)i );
+	}
+	flatmap_build( map, keys, values, array_size( keys ) );
+	EXPECT_EQ( flatmap_size( map ), 1500 );
+	ordered = flatmap_keys( map );
+	for( i = 0; i < 1500; ++i )
+		EXPECT_EQ( ordered[i], (hash_t)i << 40 );
+	for( i = 0; i < 2000; ++i )
+		EXPECT_EQ( flatmap_lookup( map, keys[i] ), (void*)(uintptr_t)( ( i < 500 ) ? i + 1500 : i ) );
+
+	array_deallocate( keys );
+	array_deallocate( values );
+	flatmap_deallocate( map );
+
+	return 0;
+}
+
+
+DECLARE_TEST( hashmap, groupmap )
+{
+	groupmap_t* map = groupmap_allocate( 0 );
+	hashmap_t* reference = hashmap_allocate( 0, 0 );
+	hash_t keys[4096];
+	unsigned int i, iloop;
+
+	EXPECT_EQ( groupmap_size( map ), 0 );
+	EXPECT_EQ( groupmap_lookup( map, 0 ), 0 );
+	EXPECT_FALSE( groupmap_has_key( map, 0 ) );
+
+	EXPECT_EQ( groupmap_insert( map, 0, map ), 0 );
+	EXPECT_EQ( groupmap_insert( map, 0, (void*)(uintptr_t)1 ), map );
+	EXPECT_TRUE( groupmap_has_key( map, 0 ) );
+	EXPECT_EQ( groupmap_erase( map, 0 ), (void*)(uintptr_t)1 );
+	EXPECT_EQ( groupmap_erase( map, 0 ), 0 );
+	EXPECT_EQ( groupmap_size( map ), 0 );
+
+	// Keys differing only in high or low bits, and string hashes
+	for( i = 0; i < 4096; ++i )
+	{
+		char buffer[32];
+		if( i < 1024 )
+			keys[i] = (hash_t)i << 54;
+		else if( i < 2048 )
+			keys[i] = i;
+		else
+		{
+			string_format_buffer( buffer, 32, "key_%u", i );
+			keys[i] = hash( buffer, string_length( buffer ) );
+		}
+		EXPECT_EQ( groupmap_insert( map, keys[i], (void*)(uintptr_t)( i + 1 ) ), 0 );
+		hashmap_insert( reference, keys[i], (void*)(uintptr_t)( i + 1 ) );
+	}
+	EXPECT_EQ( groupmap_size( map ), 4096 );
+	for( i = 0; i < 4096; ++i )
+		EXPECT_EQ( groupmap_lookup( map, keys[i] ), (void*)(uintptr_t)( i + 1 ) );
+
+	// Churn keys to leave deleted slots behind
+	for( iloop = 0; iloop < 16; ++iloop )
+	{
+		for( i = iloop % 3; i < 4096; i += 3 )
+		{
+			void* value = hashmap_lookup( reference, keys[i] );
+			EXPECT_EQ( groupmap_erase( map, keys[i] ), value );
+			hashmap_erase( reference, keys[i] );
+			if( iloop & 1 )
+			{
+				keys[i] = random64();
+				EXPECT_EQ( groupmap_insert( map, keys[i], (void*)(uintptr_t)( i + iloop ) ), 0 );
+				hashmap_insert( reference, keys[i], (void*)(uintptr_t)( i + iloop ) );
+			}
+		}
+		EXPECT_EQ( groupmap_size( map ), hashmap_size( reference ) );
+		for( i = 0; i < 4096; ++i )
+			EXPECT_EQ( groupmap_lookup( map, keys[i] ), hashmap_lookup( reference, keys[i] ) );
+	}
+
+	groupmap_clear( map );
+	EXPECT_EQ( groupmap_size( map ), 0 );
+	for( i = 0; i < 4096; ++i )
+		EXPECT_FALSE( groupmap_has_key( map, keys[i] ) );
+
+	hashmap_deallocate( reference );
+	groupmap_deallocate( map );
+
+	return 0;
+}
+
+
+typedef struct
+{
+	shardmap_t*          map;
+	unsigned int         index;
+	unsigned int         num_threads;
+	unsigned int         errors;
+} shardmap_arg_t;
+
+
+#define SHARDMAP_TEST_KEYS 20000
+
+void* shardmap_thread( object_t thread, void* arg )
+{
+	shardmap_arg_t* parg = arg;
+	shardmap_t* map = parg->map;
+	hash_t base = (hash_t)( parg->index + 1 ) << 32;
+	unsigned int ikey, iother;
+
+	for( ikey = 0; ikey < SHARDMAP_TEST_KEYS; ++ikey )
+	{
+		if( shardmap_insert( map, base + ikey, (void*)(uintptr_t)( ikey + 1 ) ) )
+			++parg->errors;
+	}
+
+	thread_yield();
+
+	for( ikey = 1; ikey < SHARDMAP_TEST_KEYS; ikey += 2 )
+	{
+		if( shardmap_erase( map, base + ikey ) != (void*)(uintptr_t)( ikey + 1 ) )
+			++parg->errors;
+	}
+
+	// Keys of other threads are either missing or have the value they were inserted with
+	for( iother = 0; iother < parg->num_threads; ++iother )
+	{
+		hash_t other = (hash_t)( iother + 1 ) << 32;
+		for( ikey = 0; ikey < SHARDMAP_TEST_KEYS; ++ikey )
+		{
+			void* value = shardmap_lookup( map, other + ikey );
+			if( value && ( value != (void*)(uintptr_t)( ikey + 1 ) ) )
+				++parg->errors;
+		}
+	}
+
+	for( ikey = 0; ikey < SHARDMAP_TEST_KEYS; ++ikey )
+	{
+		if( shardmap_lookup( map, base + ikey ) != ( ( ikey & 1 ) ? 0 : (void*)(uintptr_t)( ikey + 1 ) ) )
+			++parg->errors;
+	}
+
+	return 0;
+}
+
+
+DECLARE_TEST( hashmap, shardmap )
+{
+	object_t thread[16];
+	shardmap_arg_t args[16] = {0};
+	unsigned int num_threads = system_hardware_threads() + 1;
+	unsigned int ithread, ikey;
+	shardmap_t* map = shardmap_allocate( 0, 0 );
+
+	if( num_threads > 16 )
+		num_threads = 16;
+
+	EXPECT_EQ( shardmap_size( map ), 0 );
+	EXPECT_EQ( shardmap_lookup( map, 0 ), 0 );
+	EXPECT_FALSE( shardmap_has_key( map, 0 ) );
+	EXPECT_EQ( shardmap_insert( map, 0, map ), 0 );
+	EXPECT_EQ( shardmap_insert( map, 0, (void*)(uintptr_t)1 ), map );
+	EXPECT_TRUE( shardmap_has_key( map, 0 ) );
+	EXPECT_EQ( shardmap_erase( map, 0 ), (void*)(uintptr_t)1 );
+	EXPECT_EQ( shardmap_erase( map, 0 ), 0 );
+	EXPECT_EQ( shardmap_size( map ), 0 );
+
+	for( ithread = 0; ithread < num_threads; ++ithread )
+	{
+		args[ithread].map = map;
+		args[ithread].index = ithread;
+		args[ithread].num_threads = num_threads;
+
+		thread[ithread] = thread_create( shardmap_thread, "shardmap", THREAD_PRIORITY_NORMAL, 0 );
+		thread_start( thread[ithread], args + ithread );
+	}
+
+	test_wait_for_threads_startup( thread, num_threads );
+
+	for( ithread = 0; ithread < num_threads; ++ithread )
+	{
+		thread_terminate( thread[ithread] );
+		thread_destroy( thread[ithread] );
+	}
+
+	test_wait_for_threads_exit( thread, num_threads );
+
+	for( ithread = 0; ithread < num_threads; ++ithread )
+		EXPECT_EQ( args[ithread].errors, 0 );
+
+	EXPECT_EQ( shardmap_size( map ), num_threads * ( SHARDMAP_TEST_KEYS / 2 ) );
+	for( ithread = 0; ithread < num_threads; ++ithread )
+	{
+		for( ikey = 0; ikey < SHARDMAP_TEST_KEYS; ++ikey )
+			EXPECT_EQ( shardmap_lookup( map, ( (hash_t)( ithread + 1 ) << 32 ) + ikey ), ( ikey & 1 ) ? 0 : (void*)(uintptr_t)( ikey + 1 ) );
+	}
+
+	shardmap_clear( map );
+	EXPECT_EQ( shardmap_size( map ), 0 );
+	EXPECT_EQ( shardmap_lookup( map, (hash_t)1 << 32 ), 0 );
+
+	shardmap_deallocate( map );
+
+	return 0;
+}
+
+
 void test_hashmap_declare( void )
 {
 	ADD_TEST( hashmap, allocation );
 	ADD_TEST( hashmap, insert );
 	ADD_TEST( hashmap, erase );
 	ADD_TEST( hashmap, lookup );
+	ADD_TEST( hashmap, resize );
+	ADD_TEST( hashmap, batch );
+	ADD_TEST( hashmap, flatmap );
+	ADD_TEST( hashmap, groupmap );
+	ADD_TEST( hashmap, shardmap );
 }
 
 
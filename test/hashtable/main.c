@@ -264,12 +264,304 @@ DECLARE_TEST( hashtable, 64bit_threaded )
 }
 
 
+DECLARE_TEST( hashtable, grow )
+{
+	object_t thread[32];
+	producer32_arg_t args32[32] = {0};
+	producer64_arg_t args64[32] = {0};
+	int i, j;
+
+	hashtable32_t* table32 = hashtable32_allocate( 0 );
+	hashtable64_t* table64 = hashtable64_allocate( 0 );
+
+	// Start from minimal size and let concurrent producers grow the tables
+	for( i = 0; i < 32; ++i )
+	{
+		args32[i].table = table32;
+		args32[i].key_offset = 1 + ( i * 4099 );
+		args32[i].key_num = 8192;
+
+		thread[i] = thread_create( producer32_thread, "table_producer", THREAD_PRIORITY_NORMAL, 0 );
+		thread_start( thread[i], args32 + i );
+	}
+
+	test_wait_for_threads_startup( thread, 32 );
+
+	for( i = 0; i < 32; ++i )
+	{
+		thread_terminate( thread[i] );
+		thread_destroy( thread[i] );
+	}
+
+	test_wait_for_threads_exit( thread, 32 );
+
+	for( i = 0; i < 32; ++i )
+	{
+		args64[i].table = table64;
+		args64[i].key_offset = 1 + ( (uint64_t)i << 40 );
+		args64[i].key_num = 8192;
+
+		thread[i] = thread_create( producer64_thread, "table_producer", THREAD_PRIORITY_NORMAL, 0 );
+		thread_start( thread[i], args64 + i );
+	}
+
+	test_wait_for_threads_startup( thread, 32 );
+
+	for( i = 0; i < 32; ++i )
+	{
+		thread_terminate( thread[i] );
+		thread_destroy( thread[i] );
+	}
+
+	test_wait_for_threads_exit( thread, 32 );
+
+	EXPECT_EQ( hashtable32_size( table32 ), 31 * 4099 + 8191 );
+	EXPECT_EQ( hashtable64_size( table64 ), 32 * 8191 );
+
+	for( i = 0; i < 32; ++i )
+	{
+		for( j = 1; j < 8192; ++j )
+		{
+			uint32_t key32 = ( 1 + ( i * 4099 ) ) + j;
+			uint64_t key64 = ( 1 + ( (uint64_t)i << 40 ) ) + j;
+			EXPECT_EQ( hashtable32_get( table32, key32 ), 1 + ( key32 % 17 ) );
+			EXPECT_EQ( hashtable64_get( table64, key64 ), 1 + ( key64 % 17 ) );
+		}
+	}
+
+	hashtable32_deallocate( table32 );
+	hashtable64_deallocate( table64 );
+
+	return 0;
+}
+
+
+DECLARE_TEST( hashtable, churn )
+{
+	hashtable32_t* table32 = hashtable32_allocate( 64 );
+	hashtable64_t* table64 = hashtable64_allocate( 64 );
+	uint32_t key;
+
+	// Keys churn through the table with at most 32 live at a time, erased key slots must be reclaimed
+	for( key = 1; key < 200000; ++key )
+	{
+		hashtable32_set( table32, key, key );
+		hashtable64_set( table64, (uint64_t)key << 32, key );
+		if( key > 32 )
+		{
+			hashtable32_erase( table32, key - 32 );
+			hashtable64_erase( table64, (uint64_t)( key - 32 ) << 32 );
+		}
+		if( !( key % 1000 ) )
+		{
+			EXPECT_EQ( hashtable32_size( table32 ), 32 );
+			EXPECT_EQ( hashtable64_size( table64 ), 32 );
+		}
+	}
+
+	for( key = 199968; key < 200000; ++key )
+	{
+		EXPECT_EQ( hashtable32_get( table32, key ), key );
+		EXPECT_EQ( hashtable64_get( table64, (uint64_t)key << 32 ), key );
+	}
+	EXPECT_EQ( hashtable32_get( table32, 199967 ), 0 );
+	EXPECT_EQ( hashtable64_get( table64, (uint64_t)199967 << 32 ), 0 );
+
+	// Erasing a missing key and setting an existing key keep the count
+	hashtable32_erase( table32, 1 );
+	hashtable32_set( table32, 199999, 1 );
+	EXPECT_EQ( hashtable32_size( table32 ), 32 );
+
+	for( key = 199968; key < 199990; ++key )
+	{
+		hashtable32_erase( table32, key );
+		hashtable64_erase( table64, (uint64_t)key << 32 );
+	}
+
+	hashtable32_compact( table32 );
+	hashtable64_compact( table64 );
+
+	EXPECT_EQ( hashtable32_size( table32 ), 10 );
+	EXPECT_EQ( hashtable64_size( table64 ), 10 );
+	for( key = 199968; key < 200000; ++key )
+	{
+		EXPECT_EQ( hashtable32_get( table32, key ), ( key < 199990 ) ? 0 : ( key == 199999 ) ? 1 : key );
+		EXPECT_EQ( hashtable64_get( table64, (uint64_t)key << 32 ), ( key < 199990 ) ? 0 : key );
+	}
+
+	hashtable32_clear( table32 );
+	EXPECT_EQ( hashtable32_size( table32 ), 0 );
+
+	hashtable32_deallocate( table32 );
+	hashtable64_deallocate( table64 );
+
+	return 0;
+}
+
+
+DECLARE_TEST( hashtable, batch )
+{
+	hashtable32_t* table32 = hashtable32_allocate( 4096 );
+	hashtable64_t* table64 = hashtable64_allocate( 4096 );
+	uint32_t keys32[1000], values32[1000];
+	uint64_t keys64[1000], values64[1000];
+	unsigned int i;
+
+	for( i = 0; i < 1000; ++i )
+	{
+		keys32[i] = i + 1;
+		keys64[i] = ( (uint64_t)( i + 1 ) << 32 ) | i;
+		if( i % 3 )
+		{
+			hashtable32_set( table32, keys32[i], i * 7 + 1 );
+			hashtable64_set( table64, keys64[i], keys64[i] * 7 );
+		}
+	}
+
+	// Counts not a multiple of the internal batch size
+	hashtable32_get_batch( table32, keys32, 999, values32 );
+	hashtable64_get_batch( table64, keys64, 999, values64 );
+	for( i = 0; i < 999; ++i )
+	{
+		EXPECT_EQ( values32[i], ( i % 3 ) ? i * 7 + 1 : 0 );
+		EXPECT_EQ( values64[i], ( i % 3 ) ? keys64[i] * 7 : 0 );
+		EXPECT_EQ( values32[i], hashtable32_get( table32, keys32[i] ) );
+		EXPECT_EQ( values64[i], hashtable64_get( table64, keys64[i] ) );
+	}
+
+	hashtable32_deallocate( table32 );
+	hashtable64_deallocate( table64 );
+
+	return 0;
+}
+
+
+typedef struct
+{
+	hashtable32_t*       table32;
+	hashtable64_t*       table64;
+	unsigned int         errors;
+} reader_arg_t;
+
+
+#define READER_KEYS 1024
+
+
+void* reader_thread( object_t thread, void* arg )
+{
+	reader_arg_t* parg = arg;
+	uint32_t keys32[READER_KEYS], values32[READER_KEYS];
+	uint64_t keys64[READER_KEYS], values64[READER_KEYS];
+	unsigned int i;
+
+	for( i = 0; i < READER_KEYS; ++i )
+	{
+		keys32[i] = i + 1;
+		keys64[i] = (uint64_t)( i + 1 ) << 32;
+	}
+
+	// Stable keys must stay visible while writers grow and compact the tables
+	while( !thread_should_terminate( thread ) )
+	{
+		for( i = 0; i < READER_KEYS; ++i )
+		{
+			if( hashtable32_get( parg->table32, keys32[i] ) != keys32[i] * 3 )
+				++parg->errors;
+			if( hashtable64_get( parg->table64, keys64[i] ) != keys64[i] * 3 )
+				++parg->errors;
+		}
+		hashtable32_get_batch( parg->table32, keys32, READER_KEYS, values32 );
+		hashtable64_get_batch( parg->table64, keys64, READER_KEYS, values64 );
+		for( i = 0; i < READER_KEYS; ++i )
+		{
+			if( values32[i] != keys32[i] * 3 )
+				++parg->errors;
+			if( values64[i] != keys64[i] * 3 )
+				++parg->errors;
+		}
+		thread_yield();
+	}
+
+	return 0;
+}
+
+
+DECLARE_TEST( hashtable, readers )
+{
+	object_t thread[24];
+	reader_arg_t args[24] = {0};
+	uint32_t key;
+	int i, round;
+
+	hashtable32_t* table32 = hashtable32_allocate( 0 );
+	hashtable64_t* table64 = hashtable64_allocate( 0 );
+
+	for( key = 1; key <= READER_KEYS; ++key )
+	{
+		hashtable32_set( table32, key, key * 3 );
+		hashtable64_set( table64, (uint64_t)key << 32, ( (uint64_t)key << 32 ) * 3 );
+	}
+
+	// More readers than reader counter slots so slots are shared between threads
+	for( i = 0; i < 24; ++i )
+	{
+		args[i].table32 = table32;
+		args[i].table64 = table64;
+
+		thread[i] = thread_create( reader_thread, "table_reader", THREAD_PRIORITY_NORMAL, 0 );
+		thread_start( thread[i], args + i );
+	}
+
+	test_wait_for_threads_startup( thread, 24 );
+
+	// Grow the tables with temporary keys, then erase them and compact the tombstones away
+	for( round = 0; round < 32; ++round )
+	{
+		for( key = 100000; key < 108192; ++key )
+		{
+			hashtable32_set( table32, key, key );
+			hashtable64_set( table64, (uint64_t)key << 32, key );
+		}
+		for( key = 100000; key < 108192; ++key )
+		{
+			hashtable32_erase( table32, key );
+			hashtable64_erase( table64, (uint64_t)key << 32 );
+		}
+		hashtable32_compact( table32 );
+		hashtable64_compact( table64 );
+
+		EXPECT_EQ( hashtable32_size( table32 ), READER_KEYS );
+		EXPECT_EQ( hashtable64_size( table64 ), READER_KEYS );
+	}
+
+	for( i = 0; i < 24; ++i )
+	{
+		thread_terminate( thread[i] );
+		thread_destroy( thread[i] );
+	}
+
+	test_wait_for_threads_exit( thread, 24 );
+
+	for( i = 0; i < 24; ++i )
+		EXPECT_EQ( args[i].errors, 0 );
+
+	hashtable32_deallocate( table32 );
+	hashtable64_deallocate( table64 );
+
+	return 0;
+}
+
+
 void test_hashtable_declare( void )
 {
 	ADD_TEST( hashtable, 32bit_basic );
 	ADD_TEST( hashtable, 32bit_threaded );
 	ADD_TEST( hashtable, 64bit_basic );
 	ADD_TEST( hashtable, 64bit_threaded );
+	ADD_TEST( hashtable, grow );
+	ADD_TEST( hashtable, churn );
+	ADD_TEST( hashtable, batch );
+	ADD_TEST( hashtable, readers );
 }
 
 
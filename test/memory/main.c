@@ -0,0 +1,917 @@
+/* main.c  -  Foundation memory test  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a cross-platform foundation library in C11 providing basic support data types and
+ * functions to write applications and games in a platform-independent fashion. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/foundation_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <foundation/foundation.h>
+#include <test/test.h>
+
+
+application_t test_memory_application( void )
+{
+	application_t app = {0};
+	app.name = "Foundation memory tests";
+	app.short_name = "test_memory";
+	app.config_dir = "test_memory";
+	app.flags = APPLICATION_UTILITY;
+	return app;
+}
+
+
+memory_system_t test_memory_memory_system( void )
+{
+	return memory_system_pool();
+}
+
+
+int test_memory_initialize( void )
+{
+	return 0;
+}
+
+
+void test_memory_shutdown( void )
+{
+}
+
+
+#define TEST_MEMORY_THREAD_BLOCKS 1024
+
+typedef struct
+{
+	void**               blocks;
+	unsigned int         num;
+	uint64_t             size;
+} memory_thread_arg_t;
+
+
+static bool _memory_verify_fill( const void* p, uint64_t size, uint8_t value )
+{
+	const uint8_t* byte = p;
+	uint64_t ibyte;
+	for( ibyte = 0; ibyte < size; ++ibyte )
+	{
+		if( byte[ibyte] != value )
+			return false;
+	}
+	return true;
+}
+
+
+static void* _memory_allocate_thread( object_t thread, void* arg )
+{
+	memory_thread_arg_t* args = arg;
+	unsigned int iblock;
+	for( iblock = 0; iblock < args->num; ++iblock )
+	{
+		args->blocks[iblock] = memory_allocate( args->size + ( iblock % 7 ) * 16, 0, MEMORY_PERSISTENT );
+		if( !args->blocks[iblock] )
+			return FAILED_TEST;
+		memset( args->blocks[iblock], (int)( iblock & 0xFF ), (size_t)args->size );
+	}
+	return 0;
+}
+
+
+static void* _memory_deallocate_thread( object_t thread, void* arg )
+{
+	memory_thread_arg_t* args = arg;
+	unsigned int iblock;
+	for( iblock = 0; iblock < args->num; ++iblock )
+	{
+		if( !_memory_verify_fill( args->blocks[iblock], args->size, (uint8_t)( iblock & 0xFF ) ) )
+			return FAILED_TEST;
+		memory_deallocate( args->blocks[iblock] );
+		args->blocks[iblock] = 0;
+	}
+	return 0;
+}
+
+
+static void* _memory_run_thread( thread_fn fn, memory_thread_arg_t* args )
+{
+	object_t thread = thread_create( fn, "memory_thread", THREAD_PRIORITY_NORMAL, 0 );
+	void* result;
+
+	thread_start( thread, args );
+	test_wait_for_threads_startup( &thread, 1 );
+	while( thread_is_running( thread ) )
+		thread_sleep( 1 );
+
+	result = thread_result( thread );
+	thread_destroy( thread );
+	test_wait_for_threads_exit( &thread, 1 );
+	return result;
+}
+
+
+DECLARE_TEST( memory, pool_classes )
+{
+	//Every size up to the largest size class and past it into the fallback allocator
+	void* block[512];
+	uint64_t size[512];
+	unsigned int iblock, num = 0;
+	uint64_t cursize;
+
+	for( cursize = 1; cursize <= 32768; cursize += ( cursize < 256 ) ? 1 : ( ( cursize < 2048 ) ? 61 : 509 ) )
+	{
+		FOUNDATION_ASSERT( num < 512 );
+		size[num] = cursize;
+		block[num] = memory_allocate( cursize, 0, MEMORY_PERSISTENT );
+		EXPECT_NE( block[num], 0 );
+		EXPECT_EQ( (uintptr_t)block[num] % FOUNDATION_PLATFORM_POINTER_SIZE, 0 );
+		memset( block[num], (int)( num & 0xFF ), (size_t)cursize );
+		++num;
+	}
+
+	//Blocks must not overlap, which would show up as overwritten fill patterns
+	for( iblock = 0; iblock < num; ++iblock )
+		EXPECT_TRUE( _memory_verify_fill( block[iblock], size[iblock], (uint8_t)( iblock & 0xFF ) ) );
+
+	for( iblock = 0; iblock < num; ++iblock )
+		memory_deallocate( block[iblock] );
+
+	//Aligned requests pick a class which keeps the alignment
+	for( cursize = 1; cursize <= 8192; cursize = cursize * 3 + 1 )
+	{
+		unsigned int align;
+		for( align = 16; align <= 4096; align <<= 1 )
+		{
+			void* p = memory_allocate( cursize, align, MEMORY_PERSISTENT );
+			EXPECT_NE( p, 0 );
+			EXPECT_EQ( (uintptr_t)p % align, 0 );
+			memset( p, 0xCD, (size_t)cursize );
+			memory_deallocate( p );
+		}
+	}
+
+	return 0;
+}
+
+
+DECLARE_TEST( memory, pool_large )
+{
+	uint64_t size = 20000;
+	unsigned int iloop;
+
+	for( iloop = 0; iloop < 8; ++iloop, size *= 3 )
+	{
+		uint8_t* p = memory_allocate( size, 0, MEMORY_PERSISTENT );
+		uint8_t* z = memory_allocate_zero( size, 64, MEMORY_PERSISTENT );
+		EXPECT_NE( p, 0 );
+		EXPECT_NE( z, 0 );
+		EXPECT_EQ( (uintptr_t)z % 64, 0 );
+		EXPECT_TRUE( _memory_verify_fill( z, size, 0 ) );
+		memset( p, 0x5A, (size_t)size );
+		p[size-1] = 0xA5;
+		EXPECT_EQ( p[0], 0x5A );
+		EXPECT_EQ( p[size-1], 0xA5 );
+		memory_deallocate( p );
+		memory_deallocate( z );
+	}
+
+	return 0;
+}
+
+
+DECLARE_TEST( memory, pool_reallocate )
+{
+	uint64_t size = 8;
+	uint64_t oldsize = 0;
+	uint8_t* p = 0;
+	uint64_t ibyte;
+
+	//Grow from the smallest class through every class boundary into the fallback allocator
+	while( size <= 65536 )
+	{
+		p = memory_reallocate( p, size, 0, oldsize );
+		EXPECT_NE( p, 0 );
+		for( ibyte = 0; ibyte < oldsize; ++ibyte )
+			EXPECT_EQ( p[ibyte], (uint8_t)( ibyte * 13 ) );
+		for( ibyte = oldsize; ibyte < size; ++ibyte )
+			p[ibyte] = (uint8_t)( ibyte * 13 );
+		oldsize = size;
+		size = size + size / 2 + 3;
+	}
+
+	//And shrink back down, keeping the leading contents
+	while( oldsize > 16 )
+	{
+		size = oldsize / 3;
+		p = memory_reallocate( p, size, 0, oldsize );
+		EXPECT_NE( p, 0 );
+		for( ibyte = 0; ibyte < size; ++ibyte )
+			EXPECT_EQ( p[ibyte], (uint8_t)( ibyte * 13 ) );
+		oldsize = size;
+	}
+
+	memory_deallocate( p );
+
+	return 0;
+}
+
+
+DECLARE_TEST( memory, pool_cross_thread )
+{
+	memory_thread_arg_t args;
+	unsigned int iloop, iblock;
+	uint64_t sizes[] = { 16, 112, 1000, 9000 };
+
+	args.blocks = memory_allocate( sizeof( void* ) * TEST_MEMORY_THREAD_BLOCKS, 0, MEMORY_PERSISTENT );
+	args.num = TEST_MEMORY_THREAD_BLOCKS;
+
+	for( iloop = 0; iloop < sizeof( sizes ) / sizeof( sizes[0] ); ++iloop )
+	{
+		args.size = sizes[iloop];
+
+		//Allocated in a thread which then exits, freed here
+		EXPECT_EQ( _memory_run_thread( _memory_allocate_thread, &args ), 0 );
+		for( iblock = 0; iblock < args.num; ++iblock )
+		{
+			EXPECT_TRUE( _memory_verify_fill( args.blocks[iblock], args.size, (uint8_t)( iblock & 0xFF ) ) );
+			memory_deallocate( args.blocks[iblock] );
+		}
+
+		//Allocated here, freed in a thread which then exits
+		for( iblock = 0; iblock < args.num; ++iblock )
+		{
+			args.blocks[iblock] = memory_allocate( args.size, 0, MEMORY_PERSISTENT );
+			EXPECT_NE( args.blocks[iblock], 0 );
+			memset( args.blocks[iblock], (int)( iblock & 0xFF ), (size_t)args.size );
+		}
+		EXPECT_EQ( _memory_run_thread( _memory_deallocate_thread, &args ), 0 );
+
+		//Blocks released by both threads must be reusable
+		for( iblock = 0; iblock < args.num; ++iblock )
+		{
+			args.blocks[iblock] = memory_allocate( args.size, 0, MEMORY_PERSISTENT );
+			EXPECT_NE( args.blocks[iblock], 0 );
+			memset( args.blocks[iblock], 0, (size_t)args.size );
+		}
+		for( iblock = 0; iblock < args.num; ++iblock )
+			memory_deallocate( args.blocks[iblock] );
+	}
+
+	memory_deallocate( args.blocks );
+
+	return 0;
+}
+
+
+static void* _memory_temporary_thread( object_t thread, void* arg )
+{
+	uint64_t wraps = memory_temporary_wraps();
+	unsigned int iloop;
+	for( iloop = 0; iloop < 128; ++iloop )
+	{
+		void* p = memory_allocate( 64 * 1024, 16, MEMORY_TEMPORARY );
+		if( !p || ( (uintptr_t)p % 16 ) )
+			return FAILED_TEST;
+		memset( p, (int)iloop, 64 * 1024 );
+		memory_deallocate( p );
+	}
+	return ( memory_temporary_wraps() > wraps ) ? 0 : FAILED_TEST;
+}
+
+
+DECLARE_TEST( memory, temporary )
+{
+	uint64_t wraps = memory_temporary_wraps();
+	memory_thread_arg_t args = {0};
+	void* heap[128];
+	unsigned int iloop;
+
+	//Fill the thread buffer twice over, interleaved with heap blocks which must still be released normally
+	for( iloop = 0; iloop < 128; ++iloop )
+	{
+		void* p = memory_allocate( 64 * 1024, 0, MEMORY_TEMPORARY );
+		EXPECT_NE( p, 0 );
+		memset( p, (int)iloop, 64 * 1024 );
+		heap[iloop] = memory_allocate( 64 * 1024, 0, MEMORY_PERSISTENT );
+		EXPECT_NE( heap[iloop], 0 );
+		memset( heap[iloop], (int)iloop, 64 * 1024 );
+		memory_deallocate( p );
+	}
+	EXPECT_GT( memory_temporary_wraps(), wraps );
+
+	for( iloop = 0; iloop < 128; ++iloop )
+	{
+		EXPECT_TRUE( _memory_verify_fill( heap[iloop], 64 * 1024, (uint8_t)iloop ) );
+		memory_deallocate( heap[iloop] );
+	}
+
+	//Threads wrap their own buffers, counted in the same total
+	wraps = memory_temporary_wraps();
+	EXPECT_EQ( _memory_run_thread( _memory_temporary_thread, &args ), 0 );
+	EXPECT_EQ( _memory_run_thread( _memory_temporary_thread, &args ), 0 );
+	EXPECT_GE( memory_temporary_wraps(), wraps + 2 );
+
+	return 0;
+}
+
+
+DECLARE_TEST( memory, arena )
+{
+	memory_arena_t arena;
+	memory_arena_mark_t mark;
+	void* block[64];
+	unsigned int iblock;
+
+	memory_arena_initialize( &arena, 1024 );
+
+	//Each 200 byte block plus alignment padding fills a 1024 byte chunk after a few blocks
+	for( iblock = 0; iblock < 64; ++iblock )
+	{
+		block[iblock] = memory_arena_allocate( &arena, ( iblock == 40 ) ? 5000 : 200, 16 );
+		EXPECT_NE( block[iblock], 0 );
+		EXPECT_EQ( (uintptr_t)block[iblock] % 16, 0 );
+		memset( block[iblock], (int)iblock, 200 );
+		if( iblock == 20 )
+			mark = memory_arena_mark( &arena );
+	}
+	for( iblock = 0; iblock < 64; ++iblock )
+		EXPECT_TRUE( _memory_verify_fill( block[iblock], 200, (uint8_t)iblock ) );
+
+	//Rolling back to a mark several chunks back replays the same addresses and keeps earlier blocks
+	memory_arena_reset_to_mark( &arena, mark );
+	for( iblock = 21; iblock < 64; ++iblock )
+	{
+		void* p = memory_arena_allocate( &arena, ( iblock == 40 ) ? 5000 : 200, 16 );
+		EXPECT_EQ( p, block[iblock] );
+		memset( p, 0xFF, 200 );
+	}
+	for( iblock = 0; iblock <= 20; ++iblock )
+		EXPECT_TRUE( _memory_verify_fill( block[iblock], 200, (uint8_t)iblock ) );
+
+	//A full reset reuses all chunks, including the one inserted for the oversized block
+	memory_arena_reset( &arena );
+	for( iblock = 0; iblock < 64; ++iblock )
+		EXPECT_EQ( memory_arena_allocate( &arena, ( iblock == 40 ) ? 5000 : 200, 16 ), block[iblock] );
+
+	//Alignment larger than the chunk header
+	memory_arena_reset( &arena );
+	for( iblock = 0; iblock < 16; ++iblock )
+		EXPECT_EQ( (uintptr_t)memory_arena_allocate( &arena, 24, 256 ) % 256, 0 );
+
+	memory_arena_destroy( &arena );
+
+	return 0;
+}
+
+
+#define TEST_MEMORY_CONTEXT_A 0x5301
+#define TEST_MEMORY_CONTEXT_B 0x5302
+
+
+static void* _memory_statistics_thread( object_t thread, void* arg )
+{
+	void** block = arg;
+	unsigned int iblock;
+	for( iblock = 0; iblock < 8; ++iblock )
+		block[iblock] = memory_allocate_context( TEST_MEMORY_CONTEXT_A, 100, 0, MEMORY_PERSISTENT );
+	return 0;
+}
+
+
+DECLARE_TEST( memory, statistics )
+{
+#if BUILD_ENABLE_MEMORY_STATISTICS
+	memory_statistics_t stats_a, stats_b;
+	uint16_t contexts[BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS];
+	void* block_a[10];
+	void* block_b[5];
+	void* block_thread[8];
+	object_t thread;
+	unsigned int iblock, icontext, num_contexts;
+	bool found_a = false, found_b = false;
+
+	for( iblock = 0; iblock < 10; ++iblock )
+		block_a[iblock] = memory_allocate_context( TEST_MEMORY_CONTEXT_A, 100, 0, MEMORY_PERSISTENT );
+	for( iblock = 0; iblock < 5; ++iblock )
+		block_b[iblock] = memory_allocate_context( TEST_MEMORY_CONTEXT_B, 1000, 0, MEMORY_PERSISTENT );
+	memory_deallocate( block_a[9] );
+
+	stats_a = memory_statistics( TEST_MEMORY_CONTEXT_A );
+	stats_b = memory_statistics( TEST_MEMORY_CONTEXT_B );
+	EXPECT_EQ( stats_a.allocations, 10 );
+	EXPECT_EQ( stats_a.deallocations, 1 );
+	EXPECT_EQ( stats_a.allocated_total, 1000 );
+	EXPECT_EQ( stats_a.allocated_current, 900 );
+	EXPECT_GE( stats_a.allocated_peak, 900 );
+	EXPECT_EQ( stats_a.histogram[3], 10 );
+	EXPECT_EQ( stats_b.allocations, 5 );
+	EXPECT_EQ( stats_b.deallocations, 0 );
+	EXPECT_EQ( stats_b.allocated_total, 5000 );
+	EXPECT_EQ( stats_b.allocated_current, 5000 );
+	EXPECT_EQ( stats_b.histogram[6], 5 );
+
+	num_contexts = memory_statistics_contexts( contexts, BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS );
+	EXPECT_LE( num_contexts, BUILD_SIZE_MEMORY_STATISTICS_CONTEXTS );
+	for( icontext = 0; icontext < num_contexts; ++icontext )
+	{
+		found_a |= ( contexts[icontext] == TEST_MEMORY_CONTEXT_A );
+		found_b |= ( contexts[icontext] == TEST_MEMORY_CONTEXT_B );
+	}
+	EXPECT_TRUE( found_a );
+	EXPECT_TRUE( found_b );
+
+	//Counters of a terminated thread remain in the totals
+	thread = thread_create( _memory_statistics_thread, "memory_statistics", THREAD_PRIORITY_NORMAL, 0 );
+	thread_start( thread, block_thread );
+	test_wait_for_threads_startup( &thread, 1 );
+	while( thread_is_running( thread ) )
+		thread_sleep( 1 );
+	thread_destroy( thread );
+	test_wait_for_threads_exit( &thread, 1 );
+
+	stats_a = memory_statistics( TEST_MEMORY_CONTEXT_A );
+	EXPECT_EQ( stats_a.allocations, 18 );
+	EXPECT_EQ( stats_a.allocated_current, 1700 );
+
+	//Blocks are accounted to the context they were allocated in, whichever thread frees them
+	for( iblock = 0; iblock < 8; ++iblock )
+		memory_deallocate( block_thread[iblock] );
+	for( iblock = 0; iblock < 9; ++iblock )
+		memory_deallocate( block_a[iblock] );
+	for( iblock = 0; iblock < 5; ++iblock )
+		memory_deallocate( block_b[iblock] );
+
+	stats_a = memory_statistics( TEST_MEMORY_CONTEXT_A );
+	stats_b = memory_statistics( TEST_MEMORY_CONTEXT_B );
+	EXPECT_EQ( stats_a.deallocations, 18 );
+	EXPECT_EQ( stats_a.allocated_current, 0 );
+	EXPECT_EQ( stats_a.allocated_total, 1800 );
+	EXPECT_EQ( stats_b.deallocations, 5 );
+	EXPECT_EQ( stats_b.allocated_current, 0 );
+
+	//A failed reallocation leaves the old block live and accounted, in place and with a header change
+	block_a[0] = memory_allocate_context( TEST_MEMORY_CONTEXT_A, 100, 0, MEMORY_PERSISTENT );
+	block_a[1] = memory_allocate_context( TEST_MEMORY_CONTEXT_A, 100, 0, MEMORY_PERSISTENT );
+	memset( block_a[0], 0x5A, 100 );
+	memset( block_a[1], 0xA5, 100 );
+	EXPECT_EQ( memory_reallocate( block_a[0], 1ULL << 43, 0, 100 ), 0 );
+	EXPECT_EQ( memory_reallocate( block_a[1], 1ULL << 43, 64, 100 ), 0 );
+	EXPECT_TRUE( _memory_verify_fill( block_a[0], 100, 0x5A ) );
+	EXPECT_TRUE( _memory_verify_fill( block_a[1], 100, 0xA5 ) );
+	stats_a = memory_statistics( TEST_MEMORY_CONTEXT_A );
+	EXPECT_EQ( stats_a.allocated_current, 200 );
+	memory_deallocate( block_a[0] );
+	memory_deallocate( block_a[1] );
+	stats_a = memory_statistics( TEST_MEMORY_CONTEXT_A );
+	EXPECT_EQ( stats_a.allocated_current, 0 );
+	EXPECT_EQ( stats_a.deallocations, 20 );
+#endif
+	return 0;
+}
+
+
+#if BUILD_ENABLE_MEMORY_SAMPLING && BUILD_ENABLE_LOG
+
+static uint64_t _memory_sampled_live_bytes = 0;
+static uint64_t _memory_sampled_live_samples = 0;
+
+
+static void _memory_sample_log_callback( uint64_t context, int severity, const char* msg )
+{
+	unsigned int offset = string_find_string( msg, "Sampled live heap: ~", 0 );
+	if( offset != STRING_NPOS )
+	{
+		offset += 20;
+		_memory_sampled_live_bytes = string_to_uint64( msg + offset, false );
+		offset = string_find_string( msg, " bytes in ", offset );
+		_memory_sampled_live_samples = ( offset != STRING_NPOS ) ? string_to_uint64( msg + offset + 10, false ) : 0;
+	}
+}
+
+
+static void _memory_sample_report( void )
+{
+	error_level_t suppress = log_suppress( 0 );
+	_memory_sampled_live_bytes = _memory_sampled_live_samples = 0;
+	log_set_callback( _memory_sample_log_callback );
+	log_enable_stdout( false );
+	log_set_suppress( 0, ERRORLEVEL_DEBUG );
+	memory_tracker_report();
+	log_set_suppress( 0, suppress );
+	log_enable_stdout( true );
+	log_set_callback( 0 );
+}
+
+#endif
+
+
+DECLARE_TEST( memory, sampling )
+{
+#if BUILD_ENABLE_MEMORY_SAMPLING && BUILD_ENABLE_LOG
+	memory_tracker_t no_tracker = {0};
+	void** block;
+	uint64_t expected = (uint64_t)BUILD_SIZE_MEMORY_SAMPLE_INTERVAL * 128;
+	unsigned int iblock, num_blocks = (unsigned int)( expected / ( 32 * 1024 ) );
+
+	memory_set_tracker( memory_tracker_sampling() );
+
+	//About 128 samples expected, the estimate is well within half to one and a half times the live bytes
+	block = memory_allocate( sizeof( void* ) * num_blocks, 0, MEMORY_PERSISTENT );
+	for( iblock = 0; iblock < num_blocks; ++iblock )
+		block[iblock] = memory_allocate( 32 * 1024, 0, MEMORY_PERSISTENT );
+
+	_memory_sample_report();
+	EXPECT_GE( _memory_sampled_live_samples, 32 );
+	EXPECT_GE( _memory_sampled_live_bytes, expected / 2 );
+	EXPECT_LE( _memory_sampled_live_bytes, expected + expected / 2 );
+
+	//Freed blocks leave the live set
+	for( iblock = 0; iblock < num_blocks; iblock += 2 )
+		memory_deallocate( block[iblock] );
+	_memory_sample_report();
+	EXPECT_GE( _memory_sampled_live_bytes, expected / 8 );
+	EXPECT_LE( _memory_sampled_live_bytes, ( expected * 3 ) / 4 );
+
+	for( iblock = 1; iblock < num_blocks; iblock += 2 )
+		memory_deallocate( block[iblock] );
+	memory_deallocate( block );
+	_memory_sample_report();
+	EXPECT_LT( _memory_sampled_live_bytes, expected / 8 );
+
+	memory_set_tracker( no_tracker );
+#endif
+	return 0;
+}
+
+
+DECLARE_TEST( memory, virtual )
+{
+	uint64_t size = 1024 * 1024;
+	uint8_t* base = memory_reserve_virtual( size );
+	uint8_t* range;
+
+	EXPECT_NE( base, 0 );
+	EXPECT_EQ( (uintptr_t)base % 4096, 0 );
+
+	EXPECT_FALSE( memory_commit( 0, 4096 ) );
+	EXPECT_FALSE( memory_commit( base, 0 ) );
+
+	//Committing a range covers all pages it touches, which read as zero
+	range = base + 5000;
+	EXPECT_TRUE( memory_commit( range, 10000 ) );
+	EXPECT_TRUE( _memory_verify_fill( base + 4096, 12288, 0 ) );
+	memset( base + 4096, 0x3C, 12288 );
+
+	//Separate commits elsewhere in the reservation leave committed pages untouched
+	EXPECT_TRUE( memory_commit( base + size - 100, 100 ) );
+	memset( base + size - 4096, 0x4D, 4096 );
+	EXPECT_TRUE( _memory_verify_fill( base + 4096, 12288, 0x3C ) );
+
+	//Decommit only releases pages entirely inside the range, recommitted pages read as zero again
+	memory_decommit( base + 5000, 8000 );
+	EXPECT_TRUE( _memory_verify_fill( base + 4096, 4096, 0x3C ) );
+	EXPECT_TRUE( _memory_verify_fill( base + 12288, 4096, 0x3C ) );
+	EXPECT_TRUE( memory_commit( base + 8192, 4096 ) );
+	EXPECT_TRUE( _memory_verify_fill( base + 8192, 4096, 0 ) );
+	EXPECT_TRUE( _memory_verify_fill( base + size - 4096, 4096, 0x4D ) );
+
+	memory_decommit( base, size );
+	memory_release_virtual( base, size );
+
+	//Null and empty ranges are ignored
+	memory_decommit( 0, 4096 );
+	memory_release_virtual( 0, 4096 );
+
+	return 0;
+}
+
+
+static unsigned int _mempool_slab_count( const mempool_t* pool )
+{
+	unsigned int count = 0;
+	void* slab;
+	for( slab = pool->slabs; slab; slab = *(void**)slab )
+		++count;
+	return count;
+}
+
+
+static unsigned int _mempool_cached_count( const mempool_t* pool )
+{
+	unsigned int count = 0;
+	unsigned int islot;
+	for( islot = 0; islot < BUILD_SIZE_MEMPOOL_THREADS; ++islot )
+		count += pool->magazine[islot].count;
+	return count;
+}
+
+
+static mempool_t _memory_test_pool = MEMPOOL_INITIALIZER( 40, 16, 0x5303 );
+
+
+DECLARE_TEST( memory, mempool )
+{
+	void* object[1000];
+	unsigned int iobj, num_slabs;
+
+	for( iobj = 0; iobj < 1000; ++iobj )
+	{
+		object[iobj] = mempool_allocate( &_memory_test_pool );
+		EXPECT_NE( object[iobj], 0 );
+		EXPECT_EQ( (uintptr_t)object[iobj] % 16, 0 );
+		memset( object[iobj], (int)( iobj & 0xFF ), 40 );
+	}
+	for( iobj = 0; iobj < 1000; ++iobj )
+		EXPECT_TRUE( _memory_verify_fill( object[iobj], 40, (uint8_t)( iobj & 0xFF ) ) );
+
+#if BUILD_ENABLE_MEMORY_STATISTICS
+	//Slabs are allocated in the context of the pool
+	EXPECT_EQ( memory_statistics( 0x5303 ).allocations, _mempool_slab_count( &_memory_test_pool ) );
+#endif
+
+	//Freeing overflows the magazine into the shared list, objects are reused without growing the pool
+	num_slabs = _mempool_slab_count( &_memory_test_pool );
+	EXPECT_GT( num_slabs, 1 );
+	for( iobj = 0; iobj < 1000; ++iobj )
+		mempool_deallocate( &_memory_test_pool, object[iobj] );
+	EXPECT_LE( _mempool_cached_count( &_memory_test_pool ), BUILD_SIZE_MEMPOOL_MAGAZINE );
+	EXPECT_NE( _memory_test_pool.free, 0 );
+
+	//The magazine hands out the most recently freed object first, then refills from the shared list
+	EXPECT_EQ( mempool_allocate( &_memory_test_pool ), object[999] );
+	for( iobj = 1; iobj < 1000; ++iobj )
+		EXPECT_NE( mempool_allocate_zero( &_memory_test_pool ), 0 );
+	EXPECT_EQ( _mempool_slab_count( &_memory_test_pool ), num_slabs );
+
+	mempool_destroy( &_memory_test_pool );
+	EXPECT_EQ( _memory_test_pool.slabs, 0 );
+	EXPECT_EQ( _memory_test_pool.size, 40 );
+
+	return 0;
+}
+
+
+static void* _mempool_allocate_thread( object_t thread, void* arg )
+{
+	void** object = arg;
+	unsigned int iobj;
+	for( iobj = 0; iobj < 500; ++iobj )
+	{
+		object[iobj] = mempool_allocate( &_memory_test_pool );
+		if( !object[iobj] )
+			return FAILED_TEST;
+		memset( object[iobj], (int)( iobj & 0xFF ), 40 );
+	}
+	//Leave some freed objects in this thread's magazine, returned to the pool when the thread exits
+	for( iobj = 490; iobj < 500; ++iobj )
+		mempool_deallocate( &_memory_test_pool, object[iobj] );
+	return 0;
+}
+
+
+DECLARE_TEST( memory, mempool_thread )
+{
+	void* object[500];
+	object_t thread;
+	unsigned int iobj, num_slabs;
+
+	thread = thread_create( _mempool_allocate_thread, "mempool_thread", THREAD_PRIORITY_NORMAL, 0 );
+	thread_start( thread, object );
+	test_wait_for_threads_startup( &thread, 1 );
+	while( thread_is_running( thread ) )
+		thread_sleep( 1 );
+	EXPECT_EQ( thread_result( thread ), 0 );
+	thread_destroy( thread );
+	test_wait_for_threads_exit( &thread, 1 );
+
+	//Terminated thread returned its cached objects
+	EXPECT_EQ( _mempool_cached_count( &_memory_test_pool ), 0 );
+
+	//Objects allocated in another thread are freed here
+	num_slabs = _mempool_slab_count( &_memory_test_pool );
+	for( iobj = 0; iobj < 490; ++iobj )
+	{
+		EXPECT_TRUE( _memory_verify_fill( object[iobj], 40, (uint8_t)( iobj & 0xFF ) ) );
+		mempool_deallocate( &_memory_test_pool, object[iobj] );
+	}
+	EXPECT_GT( _mempool_cached_count( &_memory_test_pool ), 0 );
+
+	//Releasing the thread cache returns all objects to the shared list
+	mempool_thread_deallocate();
+	EXPECT_EQ( _mempool_cached_count( &_memory_test_pool ), 0 );
+
+	for( iobj = 0; iobj < 500; ++iobj )
+		object[iobj] = mempool_allocate( &_memory_test_pool );
+	EXPECT_EQ( _mempool_slab_count( &_memory_test_pool ), num_slabs );
+	for( iobj = 0; iobj < 500; ++iobj )
+		mempool_deallocate( &_memory_test_pool, object[iobj] );
+
+	mempool_destroy( &_memory_test_pool );
+
+	return 0;
+}
+
+
+DECLARE_TEST( memory, batch )
+{
+	void* ptrs[300];
+	uint64_t sizes[] = { 1, 48, 1000, 16384, 20000 };
+	unsigned int aligns[] = { 0, 16, 64, 4096 };
+	unsigned int isize, ialign, iptr, count;
+
+	for( isize = 0; isize < sizeof( sizes ) / sizeof( sizes[0] ); ++isize )
+	{
+		for( ialign = 0; ialign < sizeof( aligns ) / sizeof( aligns[0] ); ++ialign )
+		{
+			count = memory_allocate_batch( 300, sizes[isize], aligns[ialign], MEMORY_PERSISTENT, ptrs );
+			EXPECT_EQ( count, 300 );
+			for( iptr = 0; iptr < count; ++iptr )
+			{
+				EXPECT_NE( ptrs[iptr], 0 );
+				if( aligns[ialign] )
+					EXPECT_EQ( (uintptr_t)ptrs[iptr] % aligns[ialign], 0 );
+				memset( ptrs[iptr], (int)( iptr & 0xFF ), (size_t)sizes[isize] );
+			}
+			for( iptr = 0; iptr < count; ++iptr )
+				EXPECT_TRUE( _memory_verify_fill( ptrs[iptr], sizes[isize], (uint8_t)( iptr & 0xFF ) ) );
+
+			//Batches may hold null pointers and blocks from single allocations
+			memory_deallocate( ptrs[7] );
+			ptrs[7] = 0;
+			ptrs[8] = memory_reallocate( ptrs[8], sizes[isize] * 2, aligns[ialign], sizes[isize] );
+			EXPECT_NE( ptrs[8], 0 );
+			memory_deallocate_batch( ptrs, count );
+		}
+	}
+
+	//Temporary batches come from the temporary buffer and are ignored when deallocated
+	count = memory_allocate_batch( 64, 256, 16, MEMORY_TEMPORARY, ptrs );
+	EXPECT_EQ( count, 64 );
+	for( iptr = 0; iptr < count; ++iptr )
+	{
+		EXPECT_EQ( (uintptr_t)ptrs[iptr] % 16, 0 );
+		memset( ptrs[iptr], 0, 256 );
+	}
+	ptrs[count] = memory_allocate( 256, 0, MEMORY_PERSISTENT );
+	memory_deallocate_batch( ptrs, count + 1 );
+
+#if BUILD_ENABLE_MEMORY_STATISTICS && BUILD_ENABLE_MEMORY_CONTEXT
+	{
+		memory_statistics_t stats;
+		memory_context_push( 0x5304 );
+		count = memory_allocate_batch( 100, 100, 0, MEMORY_PERSISTENT, ptrs );
+		memory_context_pop();
+		stats = memory_statistics( 0x5304 );
+		EXPECT_EQ( stats.allocations, count );
+		EXPECT_EQ( stats.allocated_current, count * 100 );
+		memory_deallocate_batch( ptrs, count );
+		stats = memory_statistics( 0x5304 );
+		EXPECT_EQ( stats.deallocations, count );
+		EXPECT_EQ( stats.allocated_current, 0 );
+	}
+#endif
+
+	return 0;
+}
+
+
+#if BUILD_ENABLE_MEMORY_STATISTICS
+
+#define TEST_MEMORY_CONTEXT_BUDGET 0x5305
+
+static memory_pressure_t _memory_pressure_level = MEMORY_PRESSURE_NONE;
+static unsigned int      _memory_pressure_calls = 0;
+static uint64_t          _memory_pressure_budget = 0;
+static void*             _memory_pressure_release = 0;
+
+
+static void _memory_pressure_callback( uint16_t context, memory_pressure_t level, uint64_t current, uint64_t budget )
+{
+	if( context != TEST_MEMORY_CONTEXT_BUDGET )
+		return;
+	_memory_pressure_level = level;
+	_memory_pressure_budget = budget;
+	++_memory_pressure_calls;
+	if( _memory_pressure_release )
+	{
+		memory_deallocate( _memory_pressure_release );
+		_memory_pressure_release = 0;
+	}
+}
+
+#endif
+
+
+DECLARE_TEST( memory, budget )
+{
+#if BUILD_ENABLE_MEMORY_STATISTICS
+	void* block[16];
+	unsigned int iblock;
+	unsigned int calls;
+
+	EXPECT_TRUE( memory_pressure_register( _memory_pressure_callback ) );
+	memory_set_budget( TEST_MEMORY_CONTEXT_BUDGET, 100 * 1024, 200 * 1024 );
+	EXPECT_EQ( memory_pressure( TEST_MEMORY_CONTEXT_BUDGET ), MEMORY_PRESSURE_NONE );
+
+	//Soft budget is checked as live bytes are flushed, which happens at least every 64KiB
+	for( iblock = 0; iblock < 10; ++iblock )
+	{
+		block[iblock] = memory_allocate_context( TEST_MEMORY_CONTEXT_BUDGET, 16 * 1024, 0, MEMORY_PERSISTENT );
+		EXPECT_NE( block[iblock], 0 );
+	}
+	EXPECT_EQ( _memory_pressure_calls, 1 );
+	EXPECT_EQ( _memory_pressure_level, MEMORY_PRESSURE_SOFT );
+	EXPECT_EQ( _memory_pressure_budget, 100 * 1024 );
+	EXPECT_EQ( memory_pressure( TEST_MEMORY_CONTEXT_BUDGET ), MEMORY_PRESSURE_SOFT );
+
+	//Hard budget is enforced before each allocation, the callback gets a chance to release memory first
+	block[10] = memory_allocate_context( TEST_MEMORY_CONTEXT_BUDGET, 16 * 1024, 0, MEMORY_PERSISTENT );
+	block[11] = memory_allocate_context( TEST_MEMORY_CONTEXT_BUDGET, 16 * 1024, 0, MEMORY_PERSISTENT );
+	EXPECT_NE( block[10], 0 );
+	EXPECT_NE( block[11], 0 );
+	calls = _memory_pressure_calls;
+	block[12] = memory_allocate_context( TEST_MEMORY_CONTEXT_BUDGET, 16 * 1024, 0, MEMORY_PERSISTENT );
+	EXPECT_EQ( block[12], 0 );
+	EXPECT_GT( _memory_pressure_calls, calls );
+	EXPECT_EQ( _memory_pressure_level, MEMORY_PRESSURE_HARD );
+	EXPECT_EQ( _memory_pressure_budget, 200 * 1024 );
+	EXPECT_EQ( memory_pressure( TEST_MEMORY_CONTEXT_BUDGET ), MEMORY_PRESSURE_HARD );
+
+	//Growing a block past the budget fails and keeps the block
+	EXPECT_EQ( memory_reallocate( block[11], 64 * 1024, 0, 16 * 1024 ), 0 );
+
+	//Memory released by the callback lets the allocation through
+	_memory_pressure_release = block[0];
+	block[0] = memory_allocate_context( TEST_MEMORY_CONTEXT_BUDGET, 16 * 1024, 0, MEMORY_PERSISTENT );
+	EXPECT_NE( block[0], 0 );
+	EXPECT_EQ( _memory_pressure_release, 0 );
+
+	//Other contexts are not limited
+	block[12] = memory_allocate_context( TEST_MEMORY_CONTEXT_A, 256 * 1024, 0, MEMORY_PERSISTENT );
+	EXPECT_NE( block[12], 0 );
+	memory_deallocate( block[12] );
+
+	//Dropping below the budgets rearms the notifications
+	for( iblock = 0; iblock < 12; ++iblock )
+		memory_deallocate( block[iblock] );
+	block[0] = memory_allocate_context( TEST_MEMORY_CONTEXT_BUDGET, 16 * 1024, 0, MEMORY_PERSISTENT );
+	memory_deallocate( block[0] );
+	EXPECT_EQ( memory_pressure( TEST_MEMORY_CONTEXT_BUDGET ), MEMORY_PRESSURE_NONE );
+
+	//Without a budget nothing is enforced
+	memory_set_budget( TEST_MEMORY_CONTEXT_BUDGET, 0, 0 );
+	block[0] = memory_allocate_context( TEST_MEMORY_CONTEXT_BUDGET, 512 * 1024, 0, MEMORY_PERSISTENT );
+	EXPECT_NE( block[0], 0 );
+	memory_deallocate( block[0] );
+
+	memory_pressure_unregister( _memory_pressure_callback );
+#endif
+	return 0;
+}
+
+
+void test_memory_declare( void )
+{
+	ADD_TEST( memory, pool_classes );
+	ADD_TEST( memory, pool_large );
+	ADD_TEST( memory, pool_reallocate );
+	ADD_TEST( memory, pool_cross_thread );
+	ADD_TEST( memory, temporary );
+	ADD_TEST( memory, arena );
+	ADD_TEST( memory, statistics );
+	ADD_TEST( memory, sampling );
+	ADD_TEST( memory, virtual );
+	ADD_TEST( memory, mempool );
+	ADD_TEST( memory, mempool_thread );
+	ADD_TEST( memory, batch );
+	ADD_TEST( memory, budget );
+}
+
+
+test_suite_t test_memory_suite = {
+	test_memory_application,
+	test_memory_memory_system,
+	test_memory_declare,
+	test_memory_initialize,
+	test_memory_shutdown
+};
+
+
+#if FOUNDATION_PLATFORM_ANDROID
+
+int test_memory_run( void )
+{
+	test_suite = test_memory_suite;
+	return test_run_all();
+}
+
+#else
+
+test_suite_t test_suite_define( void )
+{
+	return test_memory_suite;
+}
+
+#endif